@@ -8,35 +8,146 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "index.h"
-#include "../libcs50/hashtable.h"
-#include "../libcs50/counters.h"
+#include "../libcs50/strtable.h"
+#include "postings.h"
+#include "segments.h"
 #include "../libcs50/file.h"
 #include "../libcs50/mem.h"
+#include "../libcs50/arena.h"
 
 // Local Types
-typedef struct word_counters {
-    char* word;
-    counters_t* ctrs;
-} word_counters_t;
-
 typedef struct index {
-    hashtable_t* ht; // Hashtable mapping words to word_counters
+    strtable_t* words; // word -> postings_t*; grows with the vocabulary
+    arena_t* arena; // where new posting lists come from, freed whole by index_delete; null if from the heap
+    int heapLists; // lists index_insert has taken in that are not from the arena
+    // A binary index file opened with index_open, from which words are loaded as they are asked for
+    const unsigned char* map; // the whole file, mapped read-only; null if there is none
+    size_t mapLength;
+    uint32_t mapVersion; // format version of the file
+    uint32_t mapWords; // number of words in the file
+    uint64_t wordTable; // offset of the sorted table of dictionary entry offsets; 0 if the file has none
+    uint64_t dictionary; // offset of the first dictionary entry
+    uint64_t dictionaryEnd; // offset of the first posting block
+    // Segments listed in the index's manifest, opened with it by index_open; a word's postings are its own
+    // followed by those of each segment, and a word in the table has them all already
+    struct index** segments;
+    int numSegments;
 } index_t;
 
+// One word and its posting list, for writing the words in sorted order
+typedef struct term {
+    const char* word;
+    postings_t* postings;
+} term_t;
+
+// A function to call on each word, and its argument, for index_iterate
+typedef struct iterate_call {
+    void* arg;
+    void (*itemfunc)(void* arg, const char* word, postings_t* postings);
+} iterate_call_t;
+
+// One input of index_merge: a mapped binary index, read one dictionary entry at a time, in word order
+typedef struct merge_run {
+    index_t* index;
+    int order; // position among the inputs; between equal words, the earlier input goes first
+    uint32_t left; // dictionary entries not yet read
+    uint64_t at; // offset of the current dictionary entry
+    uint64_t length; // length of the current word, which starts at at + 4
+    uint64_t block; // offset of the current word's posting block
+    uint64_t dictionaryDone; // the mapping before these offsets has been read and given back
+    uint64_t blocksDone;
+} merge_run_t;
+
+// The output of index_merge in the binary format: the dictionary and the posting blocks are written to
+// temporary files as the words come, and put together behind a header once the words are counted
+typedef struct merge_out {
+    FILE* dictionary; // entries as in the file, with block offsets from the first block
+    FILE* blocks;
+    uint32_t numWords;
+    uint64_t dictionaryBytes;
+    uint64_t blocksBytes;
+    char* buf; // scratch for write_block
+    size_t cap;
+} merge_out_t;
+
+typedef struct term_list {
+    term_t* terms;
+    int size;
+} term_list_t;
+
+// Global Constants
+
+/*
+* Binary index format. All integers are little-endian.
+*   header: "TSEINDEX", uint32 version, uint32 number of words, uint64 offset of the first posting block,
+*           and (from version 2) uint64 offset of the word table
+*   word table (version 2): for each word, in strcmp order: uint64 offset of its dictionary entry
+*   dictionary: for each word, in strcmp order: uint32 length, the word (no '\0'), uint64 offset of its posting block
+*   posting blocks: for each word: uint32 number of postings, then
+*           (version 4) uint32 length in bytes, then the postings compressed by postings_encode,
+*           (version 3) the same, without the block table postings_encode now puts before a long list, or
+*           (versions 1 and 2) uint32 docID and uint32 count for each posting, by docID
+* The word table's fixed-width entries let a reader binary-search the dictionary in place.
+*/
+static const char BINARY_MAGIC[8] = "TSEINDEX";
+static const uint32_t BINARY_VERSION = 4;
+enum { HEADER_SIZE = 32, HEADER_SIZE_V1 = 24 };
+static const int OPEN_WORDS = 64; // words an opened index expects to load; it grows if more are asked for
+static const uint64_t RELEASE_STEP = 1 << 16; // bytes index_merge reads of an input before giving them back
+static const uint64_t RELEASE_BACK = 2 << 20; // how far behind the page it is for, a fault may map pages in
+
 // Functions
-static void itemdelete(void* item);
 static void save_helper(void* arg, const char* key, void* item);
 static void counters_helper(void* arg, const int key, const int count);
+static void collect_helper(void* arg, const char* key, void* item);
+static void iterate_helper(void* arg, const char* key, void* item);
+static int compare_terms(const void* a, const void* b);
+static bool write_block(FILE* fp, const postings_t* postings, char** buf, size_t* cap);
+static index_t* load_file(const char* filename);
+static index_t* load_binary(const char* filename);
+static index_t* map_binary(const char* filename, const bool whole);
+static uint64_t find_entry(const index_t* index, const char* word);
+static bool read_entry(const index_t* index, const uint64_t at, uint64_t* length, uint64_t* block);
+static bool open_block(const index_t* index, const uint64_t block, postings_cursor_t* cursor);
+static postings_t* load_entry(index_t* index, const uint64_t at, uint64_t* next);
+static bool load_all(index_t* index);
+static void unmap(index_t* index);
+static postings_t* lookup(index_t* index, const char* word);
+static void put32(unsigned char* p, const uint32_t value);
+static void put64(unsigned char* p, const uint64_t value);
+static uint32_t get32(const unsigned char* p);
+static uint64_t get64(const unsigned char* p);
+static postings_t* find_or_add(index_t* index, const char* word);
+static postings_t* new_list(index_t* index);
+static bool next_word(merge_run_t* run);
+static bool run_before(const merge_run_t* a, const merge_run_t* b);
+static void sift_down(merge_run_t** heap, const int size, int at);
+static void release(const index_t* index, uint64_t* done, const uint64_t upTo);
+static uint64_t page_floor(const uint64_t offset);
+static bool write_postings(FILE* fp, merge_run_t* run, int* last);
+static bool append_postings(postings_t* postings, merge_run_t* run, int* last);
+static bool write_entry(merge_out_t* out, const unsigned char* word, const uint64_t length, const postings_t* postings);
+static bool assemble(merge_out_t* out, const char* filename);
+static bool copy_file(FILE* from, FILE* to);
+static bool open_segments(index_t* index, const char* filename);
+static postings_t* add_segments(index_t* index, const char* word, postings_t* postings);
+static bool fold_segments(index_t* index);
 
 /*
-* index_new(): Creates new index with specified hashtable size
-* Params: number of slots for hashtable (num_slots)
+* index_new(): Creates new, empty index
+* Params: number of words expected (num_slots); the index grows past it as needed
 * Returns: pointer to new index, or null if error
 */
 index_t* index_new(const int num_slots) {
     if (num_slots <= 0) {
-        return NULL; // If no slots in hashtable, return null
+        return NULL; // If no words expected, return null
     }
     
     index_t* index = mem_malloc(sizeof(index_t));
@@ -44,15 +155,45 @@ index_t* index_new(const int num_slots) {
         return NULL; // If index is null, return null
     }
     
-    index->ht = hashtable_new(num_slots);
-    if (index->ht == NULL) {
+    index->words = strtable_new(num_slots);
+    if (index->words == NULL) {
         mem_free(index); // Free the index and return null
         return NULL;
     }
+    index->arena = NULL;
+    index->heapLists = 0;
+    index->map = NULL;
+    index->mapLength = 0;
+    index->mapVersion = 0;
+    index->mapWords = 0;
+    index->wordTable = 0;
+    index->dictionary = 0;
+    index->dictionaryEnd = 0;
+    index->segments = NULL;
+    index->numSegments = 0;
     
     return index;
 }
 
+/*
+* index_newArena(): Creates new, empty index whose posting lists are allocated in an arena
+* Params: number of words expected (num_slots); the index grows past it as needed;
+*         bytes in each of the arena's blocks (blockSize; 0 for arena_new's default)
+* Returns: pointer to new index, or null if error
+*/
+index_t* index_newArena(const int num_slots, const size_t blockSize) {
+    index_t* index = index_new(num_slots);
+    if (index == NULL) {
+        return NULL;
+    }
+    index->arena = arena_new(blockSize);
+    if (index->arena == NULL) {
+        index_delete(index);
+        return NULL;
+    }
+    return index;
+}
+
 /*
 * index_add(): Increments word occurrence for given docID
 * Params: index pointer (index), word to add (word), document ID (docID)
@@ -63,43 +204,13 @@ bool index_add(index_t* index, const char* word, const int docID) {
         return false;
     }
     
-    // Look for existing word_counters
-    word_counters_t* wc = hashtable_find(index->ht, word);
-    if (wc == NULL) {
-        // Create new word_counters structure
-        wc = mem_malloc(sizeof(word_counters_t));
-        if (wc == NULL) {
-            return false;
-        }
-        
-        // Create counter set
-        wc->ctrs = counters_new();
-        if (wc->ctrs == NULL) {
-            mem_free(wc);
-            return false;
-        }
-        
-        // Copy word; free memory and return false if any errors
-        wc->word = mem_malloc(strlen(word) + 1);
-        if (wc->word == NULL) {
-            counters_delete(wc->ctrs);
-            mem_free(wc);
-            return false;
-        }
-        strcpy(wc->word, word);
-        
-        // Insert the word into hashtable
-        if (!hashtable_insert(index->ht, wc->word, wc)) {
-            mem_free(wc->word);
-            counters_delete(wc->ctrs);
-            mem_free(wc);
-            return false;
-        }
+    postings_t* postings = find_or_add(index, word);
+    if (postings == NULL) {
+        return false;
     }
     
-    // Increment counter for this docID
-    counters_add(wc->ctrs, docID);
-    return true;
+    // Increment counter for this docID; an append unless docIDs arrive out of order
+    return postings_add(postings, docID);
 }
 
 /*
@@ -112,54 +223,80 @@ bool index_set(index_t* index, const char* word, const int docID, const int coun
         return false;
     }
     
-    word_counters_t* wc = hashtable_find(index->ht, word);
-    if (wc == NULL) {
-        // Create new word_counters structure
-        wc = mem_malloc(sizeof(word_counters_t));
-        if (wc == NULL) {
-            return false;
-        }
-        
-        // Create counter set
-        wc->ctrs = counters_new();
-        if (wc->ctrs == NULL) {
-            mem_free(wc);
-            return false;
-        }
-        
-        // Copy word
-        wc->word = mem_malloc(strlen(word) + 1);
-        if (wc->word == NULL) {
-            counters_delete(wc->ctrs); // If word copy null; delete counters and free memory
-            mem_free(wc);
-            return false;
-        }
-        strcpy(wc->word, word);
-        
-        // Insert into hashtable
-        if (!hashtable_insert(index->ht, wc->word, wc)) {
-            mem_free(wc->word);
-            counters_delete(wc->ctrs);
-            mem_free(wc);
-            return false;
-        }
+    postings_t* postings = find_or_add(index, word);
+    if (postings == NULL) {
+        return false;
     }
     
-    counters_set(wc->ctrs, docID, count);
+    return postings_set(postings, docID, count);
+}
+
+/*
+* index_insert(): Adds a word with a whole posting list, which the index takes over
+* Params: index pointer (index), word to add (word), its posting list (postings)
+* Returns: true if successful; false if the word is already in the index, or on error
+*/
+bool index_insert(index_t* index, const char* word, postings_t* postings) {
+    if (index == NULL || word == NULL || postings == NULL || lookup(index, word) != NULL) {
+        return false;
+    }
+    if (!strtable_insert(index->words, word, postings)) {
+        return false;
+    }
+    // index_delete must then free lists one by one, in case this one is not from the arena
+    if (index->arena != NULL) {
+        index->heapLists++;
+    }
     return true;
 }
 
 /*
-* index_get(): Retrieves counter set for given word.
+* index_get(): Retrieves the posting list for given word.
 * Params: index pointer (index), word to look up (word)
-* Returns: pointer to counters set, or null if not found
+* Returns: pointer to the word's posting list, or null if not found
 */
-counters_t* index_get(index_t* index, const char* word) {
+postings_t* index_get(index_t* index, const char* word) {
     if (index == NULL || word == NULL) {
         return NULL;
     }
-    word_counters_t* wc = hashtable_find(index->ht, word);
-    return (wc != NULL) ? wc->ctrs : NULL;
+    return lookup(index, word);
+}
+
+/*
+* index_iterate(): Calls a function on every word in the index and its posting list
+* Params: index pointer (index), argument passed through (arg), function called on each word (itemfunc)
+* Returns: void
+*/
+void index_iterate(index_t* index, void* arg, void (*itemfunc)(void* arg, const char* word, postings_t* postings)) {
+    if (index == NULL || itemfunc == NULL || !load_all(index)) {
+        return;
+    }
+    iterate_call_t call = { arg, itemfunc };
+    strtable_iterate(index->words, &call, iterate_helper);
+}
+
+/*
+* index_bytes(): Tells how much memory the index takes up
+* Params: index pointer (index)
+* Returns: bytes allocated for its words and, if made by index_newArena, its posting lists; 0 if index is null
+*/
+size_t index_bytes(index_t* index) {
+    if (index == NULL) {
+        return 0;
+    }
+    return sizeof(index_t) + strtable_bytes(index->words) + arena_bytes(index->arena);
+}
+
+/*
+* index_saveBytes(): Tells how much more memory index_saveBinary takes to write the index
+* Params: index pointer (index)
+* Returns: bytes for the list of its words and qsort's copy of it; 0 if index is null
+*/
+size_t index_saveBytes(index_t* index) {
+    if (index == NULL) {
+        return 0;
+    }
+    return 2 * (size_t)strtable_size(index->words) * sizeof(term_t);
 }
 
 /*
@@ -168,7 +305,7 @@ counters_t* index_get(index_t* index, const char* word) {
 * Returns: true if successful, false on error
 */
 bool index_save(index_t* index, const char* filename) {
-    if (index == NULL || filename == NULL) {
+    if (index == NULL || filename == NULL || !load_all(index)) {
         return false;
     }
     
@@ -177,7 +314,7 @@ bool index_save(index_t* index, const char* filename) {
         return false;
     }
 
-    hashtable_iterate(index->ht, fp, save_helper);
+    strtable_iterate(index->words, fp, save_helper);
     fclose(fp);
     return true;
 }
@@ -190,13 +327,8 @@ static void save_helper(void* arg, const char* key, void* item) {
         return;
     }
     
-    word_counters_t* wc = item;
-    fprintf(fp, "%s", wc->word);
-    
-    if (wc->ctrs != NULL) {
-        fprintf(fp, " ");
-        counters_iterate(wc->ctrs, fp, counters_helper);
-    }
+    fprintf(fp, "%s ", key);
+    postings_iterate(item, fp, counters_helper);
     fprintf(fp, "\n");
 }
 
@@ -209,11 +341,93 @@ static void counters_helper(void* arg, const int key, const int count) {
 }
 
 /*
-* index_load(): Reads index from file in format
+* index_saveBinary(): Writes index to file in the binary format
+* Params: index pointer (index), filename to write to (filename)
+* Returns: true if successful, false on error
+*/
+bool index_saveBinary(index_t* index, const char* filename) {
+    if (index == NULL || filename == NULL || !load_all(index)) {
+        return false;
+    }
+
+    // Sorted, so the same index always makes the same file
+    int numWords = strtable_size(index->words);
+    term_list_t list = { mem_malloc((numWords > 0 ? numWords : 1) * sizeof(term_t)), 0 };
+    if (list.terms == NULL) {
+        return false;
+    }
+    strtable_iterate(index->words, &list, collect_helper);
+    qsort(list.terms, list.size, sizeof(term_t), compare_terms);
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        mem_free(list.terms);
+        return false;
+    }
+
+    // The word table follows the header, then the dictionary, then the posting blocks
+    uint64_t dictionary = HEADER_SIZE + 8 * (uint64_t)list.size;
+    uint64_t offset = dictionary;
+    for (int i = 0; i < list.size; i++) {
+        offset += 4 + strlen(list.terms[i].word) + 8;
+    }
+    unsigned char header[HEADER_SIZE];
+    memcpy(header, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    put32(header + 8, BINARY_VERSION);
+    put32(header + 12, list.size);
+    put64(header + 16, offset);
+    put64(header + 24, HEADER_SIZE);
+    bool ok = fwrite(header, HEADER_SIZE, 1, fp) == 1;
+
+    for (int i = 0; ok && i < list.size; i++) {
+        unsigned char field[8];
+        put64(field, dictionary);
+        ok = fwrite(field, 8, 1, fp) == 1;
+        dictionary += 4 + strlen(list.terms[i].word) + 8;
+    }
+
+    for (int i = 0; ok && i < list.size; i++) {
+        unsigned char field[8];
+        size_t length = strlen(list.terms[i].word);
+        put32(field, length);
+        ok = fwrite(field, 4, 1, fp) == 1 && fwrite(list.terms[i].word, 1, length, fp) == length;
+        put64(field, offset);
+        ok = ok && fwrite(field, 8, 1, fp) == 1;
+
+        offset += 8 + postings_encodedSize(list.terms[i].postings);
+    }
+
+    // One buffer, reused for every block
+    char* buf = NULL;
+    size_t cap = 0;
+    for (int i = 0; ok && i < list.size; i++) {
+        ok = write_block(fp, list.terms[i].postings, &buf, &cap);
+    }
+    free(buf);
+    mem_free(list.terms);
+    return (fclose(fp) == 0) && ok;
+}
+
+/*
+* index_load(): Reads index from file in format, with the segments listed in its manifest, if it has one
 * Params: filename to read from (filename)
 * Returns: pointer to new index, or null if error
 */
 index_t* index_load(const char* filename) {
+    index_t* index = load_file(filename);
+    if (index != NULL && (!open_segments(index, filename) || !fold_segments(index))) {
+        index_delete(index);
+        return NULL;
+    }
+    return index;
+}
+
+/*
+* load_file(): Reads an index file in either format, without the segments listed in its manifest
+* Params: filename to read from (filename)
+* Returns: pointer to new index, or null if error
+*/
+static index_t* load_file(const char* filename) {
     if (filename == NULL) {
         return NULL;
     }
@@ -223,69 +437,35 @@ index_t* index_load(const char* filename) {
         return NULL;
     }
 
-    int num_lines = file_numLines(fp);
-    if (num_lines == 0) {
+    // A binary index starts with its magic number; a text one with a word
+    char magic[sizeof(BINARY_MAGIC)];
+    if (fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
         fclose(fp);
-        return NULL;
+        return load_binary(filename);
     }
-    
-    index_t* index = index_new(num_lines);
+    rewind(fp);
+
+    // Room for one word per line; an empty file is an empty index
+    int num_lines = file_numLines(fp);
+    index_t* index = index_new(num_lines > 0 ? num_lines : 1);
     if (index == NULL) {
         fclose(fp);
         return NULL;
     }
 
+    // One buffer, reused for every line
     char* line = NULL;
     size_t len = 0;
-    ssize_t read;
 
-    while ((read = getline(&line, &len, fp)) != -1) {
-        if (read > 0 && line[read-1] == '\n') {
-            line[read-1] = '\0';
-        }
-        
+    while (file_getLine(fp, &line, &len) != -1) {
         char* saveptr;
         char* word = strtok_r(line, " ", &saveptr);
         if (word == NULL) {
             continue;
         }
 
-        // Create new word_counters structure
-        word_counters_t* wc = mem_malloc(sizeof(word_counters_t));
-        if (wc == NULL) {
-            free(line);
-            index_delete(index);
-            fclose(fp);
-            return NULL;
-        }
-        
-        // Create counter set
-        wc->ctrs = counters_new();
-        if (wc->ctrs == NULL) {
-            mem_free(wc);
-            free(line);
-            index_delete(index);
-            fclose(fp);
-            return NULL;
-        }
-        
-        // Copy word
-        wc->word = mem_malloc(strlen(word) + 1);
-        if (wc->word == NULL) {
-            counters_delete(wc->ctrs);
-            mem_free(wc);
-            free(line);
-            index_delete(index);
-            fclose(fp);
-            return NULL;
-        }
-        strcpy(wc->word, word);
-        
-        // Insert into hashtable
-        if (!hashtable_insert(index->ht, wc->word, wc)) {
-            mem_free(wc->word);
-            counters_delete(wc->ctrs);
-            mem_free(wc);
+        postings_t* postings = find_or_add(index, word);
+        if (postings == NULL) {
             free(line);
             index_delete(index);
             fclose(fp);
@@ -303,7 +483,7 @@ index_t* index_load(const char* filename) {
             int docID = atoi(id_str);
             int count = atoi(count_str);
             if (docID > 0 && count > 0) {
-                counters_set(wc->ctrs, docID, count);
+                postings_set(postings, docID, count);
             }
         }
     }
@@ -313,6 +493,587 @@ index_t* index_load(const char* filename) {
     return index;
 }
 
+/*
+* index_loadBinary(): Reads index from a file in the binary format, with the segments listed in its manifest,
+*                     if it has one
+* Params: filename to read from (filename)
+* Returns: pointer to new index, or null if the file cannot be read, or is not a binary index of a known version
+*/
+index_t* index_loadBinary(const char* filename) {
+    index_t* index = load_binary(filename);
+    if (index != NULL && (!open_segments(index, filename) || !fold_segments(index))) {
+        index_delete(index);
+        return NULL;
+    }
+    return index;
+}
+
+/*
+* load_binary(): Reads an index file in the binary format, without the segments listed in its manifest
+* Params: filename to read from (filename)
+* Returns: pointer to new index, or null if the file cannot be read, or is not a binary index of a known version
+*/
+static index_t* load_binary(const char* filename) {
+    if (filename == NULL) {
+        return NULL;
+    }
+    // Each posting is copied once, from the page cache into its list
+    index_t* index = map_binary(filename, true);
+    if (index == NULL) {
+        return NULL;
+    }
+    if (!load_all(index)) {
+        index_delete(index);
+        return NULL;
+    }
+    return index;
+}
+
+/*
+* index_merge(): Merges binary index files into one index file, reading each input once
+* Params: input filenames (filenames), how many (numFiles), filename to write to (filename),
+*         whether to write it in the binary format rather than the text format (binary)
+* Returns: true if successful; false if an input is not a binary index of version 3 or later, if the docIDs
+*          of the inputs are not in order, or on error
+*/
+bool index_merge(const char** filenames, const int numFiles, const char* filename, const bool binary) {
+    if (filenames == NULL || numFiles < 0 || filename == NULL) {
+        return false;
+    }
+    merge_run_t* runs = mem_calloc(numFiles > 0 ? numFiles : 1, sizeof(merge_run_t));
+    merge_run_t** heap = mem_calloc(numFiles > 0 ? numFiles : 1, sizeof(merge_run_t*));
+    bool ok = (runs != NULL && heap != NULL);
+
+    // Map each input, and put those with words on a heap ordered by their current word
+    int size = 0;
+    for (int i = 0; ok && i < numFiles; i++) {
+        merge_run_t* run = &runs[i];
+        run->index = map_binary(filenames[i], false);
+        if (run->index == NULL || run->index->mapVersion < 3) {
+            ok = false;
+            break;
+        }
+        madvise((void*)run->index->map, run->index->mapLength, MADV_SEQUENTIAL);
+        run->order = i;
+        run->left = run->index->mapWords;
+        run->at = run->index->dictionary;
+        run->length = 0;
+        run->dictionaryDone = page_floor(run->at);
+        run->blocksDone = page_floor(run->index->dictionaryEnd);
+        if (next_word(run)) {
+            heap[size++] = run;
+            for (int at = size - 1; at > 0 && run_before(heap[at], heap[(at - 1) / 2]); at = (at - 1) / 2) {
+                merge_run_t* parent = heap[(at - 1) / 2];
+                heap[(at - 1) / 2] = heap[at];
+                heap[at] = parent;
+            }
+        }
+        else if (run->left != 0) {
+            ok = false; // the first entry is not valid
+        }
+    }
+
+    FILE* fp = NULL;
+    merge_out_t out = { NULL, NULL, 0, 0, 0, NULL, 0 };
+    if (ok && binary) {
+        out.dictionary = tmpfile();
+        out.blocks = tmpfile();
+        ok = out.dictionary != NULL && out.blocks != NULL;
+    }
+    else if (ok) {
+        fp = fopen(filename, "w");
+        ok = fp != NULL;
+    }
+    while (ok && size > 0) {
+        // Take the smallest word, with its postings from each input that has it, in input order; the text
+        // format is written as it goes, while the binary format needs the whole list to encode
+        merge_run_t* first = heap[0];
+        const unsigned char* word = first->index->map + first->at + 4;
+        uint64_t length = first->length;
+        postings_t* postings = binary ? postings_new() : NULL;
+        ok = binary ? postings != NULL : (fwrite(word, 1, length, fp) == length && fputc(' ', fp) != EOF);
+        int last = 0;
+        while (ok) {
+            merge_run_t* run = heap[0];
+            ok = binary ? append_postings(postings, run, &last) : write_postings(fp, run, &last);
+            if (next_word(run)) {
+                sift_down(heap, size, 0);
+            }
+            else {
+                ok = ok && run->left == 0;
+                heap[0] = heap[--size];
+                sift_down(heap, size, 0);
+            }
+            if (size == 0 || heap[0]->length != length || memcmp(heap[0]->index->map + heap[0]->at + 4, word, length) != 0) {
+                break;
+            }
+        }
+        if (binary) {
+            ok = ok && write_entry(&out, word, length, postings);
+            postings_delete(postings);
+        }
+        else {
+            ok = ok && fputc('\n', fp) != EOF;
+        }
+    }
+    if (fp != NULL) {
+        ok = (fclose(fp) == 0) && ok;
+    }
+    if (binary) {
+        ok = ok && assemble(&out, filename);
+        if (out.dictionary != NULL) {
+            fclose(out.dictionary);
+        }
+        if (out.blocks != NULL) {
+            fclose(out.blocks);
+        }
+        free(out.buf);
+    }
+
+    for (int i = 0; runs != NULL && i < numFiles; i++) {
+        index_delete(runs[i].index);
+    }
+    if (runs != NULL) {
+        mem_free(runs);
+    }
+    if (heap != NULL) {
+        mem_free(heap);
+    }
+    return ok;
+}
+
+/*
+* index_open(): Opens an index file for looking words up. A binary index (version 2 or later) is mapped,
+*               not read: each word's posting list is read from the file the first time index_get asks for it,
+*               so opening takes the same time however big the index is. Any other index file is loaded whole.
+*               The segments listed in the index's manifest, if it has one, are mapped too, and searched with it.
+* Params: filename to read from (filename)
+* Returns: pointer to new index, or null if error
+*/
+index_t* index_open(const char* filename) {
+    if (filename == NULL) {
+        return NULL;
+    }
+    index_t* index = map_binary(filename, false);
+    if (index == NULL) {
+        index = load_file(filename);
+    }
+    else if (index->wordTable == 0 && !load_all(index)) {
+        index_delete(index); // Version 1 has no word table to search, so is loaded whole
+        return NULL;
+    }
+    // An index loaded whole takes its segments in whole too
+    if (index != NULL && (!open_segments(index, filename) || (index->map == NULL && !fold_segments(index)))) {
+        index_delete(index);
+        return NULL;
+    }
+    return index;
+}
+
+/*
+* open_segments(): Maps the segments listed in an index's manifest, holding a shared lock on the manifest so
+*                  none is removed by a fold while they are opened
+* Params: index pointer (index), its filename (filename)
+* Returns: true if successful, or if the index has no segments; false if a segment is not a binary index of
+*          version 3 or later, or on error
+*/
+static bool open_segments(index_t* index, const char* filename) {
+    // Most indexes have no manifest, and are not locked at all
+    segments_t* segments = segments_read(filename);
+    bool ok = (segments != NULL);
+    if (!ok || segments->count == 0) {
+        segments_delete(segments);
+        return ok;
+    }
+    segments_delete(segments);
+    int lock = segments_lock(filename, false);
+    segments = segments_read(filename);
+    ok = (segments != NULL);
+    if (ok && segments->count > 0) {
+        index->segments = mem_calloc(segments->count, sizeof(index_t*));
+        ok = (index->segments != NULL);
+    }
+    for (int i = 0; ok && i < segments->count; i++) {
+        char* name = segments_name(filename, segments->numbers[i]);
+        index_t* segment = (name != NULL) ? map_binary(name, false) : NULL;
+        if (name != NULL) {
+            mem_free(name);
+        }
+        ok = (segment != NULL && segment->mapVersion >= 3);
+        if (segment != NULL) {
+            index->segments[index->numSegments++] = segment;
+        }
+    }
+    segments_unlock(lock);
+    segments_delete(segments);
+    return ok;
+}
+
+/*
+* add_segments(): Appends a word's postings in each segment to its list, after loading the list from the index
+* Params: index pointer (index), word (word), the word's list, as loaded from the index (postings; null if it
+*         is not there, in which case a new list is added if any segment has the word)
+* Returns: pointer to the word's list, or null if no file has the word, or on error
+*/
+static postings_t* add_segments(index_t* index, const char* word, postings_t* postings) {
+    for (int i = 0; i < index->numSegments; i++) {
+        postings_cursor_t cursor;
+        if (!index_cursor(index->segments[i], word, &cursor)) {
+            continue;
+        }
+        if (postings == NULL) {
+            postings = new_list(index);
+            if (postings == NULL || !strtable_insert(index->words, word, postings)) {
+                postings_delete(postings);
+                return NULL;
+            }
+        }
+        // A segment's docIDs come after any already in the list, so each goes on the end
+        posting_t entry;
+        while (postings_next(&cursor, &entry)) {
+            if (!postings_set(postings, entry.docID, entry.count)) {
+                return NULL;
+            }
+        }
+    }
+    return postings;
+}
+
+/*
+* fold_segments(): Appends every word of each segment to the index's lists, and lets the segments go; a word
+*                  already given its segments' postings is only given them again
+* Params: index pointer (index)
+* Returns: true if successful, false if a segment is not valid or on error
+*/
+static bool fold_segments(index_t* index) {
+    bool ok = true;
+    for (int i = 0; i < index->numSegments; i++) {
+        index_t* segment = index->segments[i];
+        uint64_t at = segment->dictionary;
+        for (uint32_t w = 0; ok && w < segment->mapWords; w++) {
+            uint64_t length, block;
+            postings_cursor_t cursor;
+            ok = read_entry(segment, at, &length, &block) && open_block(segment, block, &cursor);
+            char* word = ok ? mem_malloc(length + 1) : NULL;
+            ok = ok && word != NULL;
+            if (ok) {
+                memcpy(word, segment->map + at + 4, length);
+                word[length] = '\0';
+                postings_t* postings = find_or_add(index, word);
+                posting_t entry;
+                while (ok && postings_next(&cursor, &entry)) {
+                    ok = postings != NULL && postings_set(postings, entry.docID, entry.count);
+                }
+                ok = ok && postings != NULL;
+                mem_free(word);
+            }
+            at += 4 + length + 8;
+        }
+        index_delete(segment);
+    }
+    if (index->segments != NULL) {
+        mem_free(index->segments);
+    }
+    index->segments = NULL;
+    index->numSegments = 0;
+    return ok;
+}
+
+/*
+* map_binary(): Maps a binary index file, and checks its header
+* Params: filename to read from (filename), whether the whole file will be loaded (whole), to size the index for it
+* Returns: pointer to new, empty index holding the mapping, or null if the file is not a binary index of a known version
+*/
+static index_t* map_binary(const char* filename, const bool whole) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < HEADER_SIZE_V1) {
+        close(fd);
+        return NULL;
+    }
+    // Read-only and shared, so every querier with this index open uses the same pages
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    const unsigned char* data = map;
+    size_t size = info.st_size;
+
+    uint32_t version = get32(data + 8);
+    bool valid = memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0
+                 && (version == 1 || (version >= 2 && version <= BINARY_VERSION && size >= HEADER_SIZE));
+    uint32_t numWords = valid ? get32(data + 12) : 0;
+    uint64_t dictionaryEnd = valid ? get64(data + 16) : 0;
+    uint64_t wordTable = (valid && version >= 2) ? get64(data + 24) : 0;
+    uint64_t dictionary = (version >= 2) ? wordTable + 8 * (uint64_t)numWords : HEADER_SIZE_V1;
+    if (version >= 2 && (wordTable < HEADER_SIZE || wordTable > size || numWords > (size - wordTable) / 8)) {
+        valid = false;
+    }
+    if (!valid || dictionaryEnd > size || dictionary > dictionaryEnd) {
+        munmap(map, size);
+        return NULL;
+    }
+
+    index_t* index = index_new(whole && numWords > 0 ? numWords : OPEN_WORDS);
+    if (index == NULL) {
+        munmap(map, size);
+        return NULL;
+    }
+    madvise(map, size, whole ? MADV_SEQUENTIAL : MADV_RANDOM);
+    index->map = data;
+    index->mapLength = size;
+    index->mapVersion = version;
+    index->mapWords = numWords;
+    index->wordTable = wordTable;
+    index->dictionary = dictionary;
+    index->dictionaryEnd = dictionaryEnd;
+    return index;
+}
+
+/*
+* find_entry(): Binary-searches the word table of a mapped index
+* Params: index pointer (index), word to look up (word)
+* Returns: offset of the word's dictionary entry, or 0 if the word is not in the file
+*/
+static uint64_t find_entry(const index_t* index, const char* word) {
+    size_t length = strlen(word);
+    uint32_t low = 0;
+    uint32_t high = index->mapWords;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        uint64_t at = get64(index->map + index->wordTable + 8 * (uint64_t)mid);
+        if (at < index->dictionary || at > index->dictionaryEnd - 4) {
+            return 0; // Corrupt table; treat the word as missing
+        }
+        uint64_t entryLength = get32(index->map + at);
+        if (entryLength > index->dictionaryEnd - at - 4) {
+            return 0;
+        }
+        // Compare as strcmp would, which is the order the words were written in
+        int cmp = memcmp(word, index->map + at + 4, length < entryLength ? length : entryLength);
+        if (cmp == 0) {
+            cmp = (length > entryLength) - (length < entryLength);
+        }
+        if (cmp == 0) {
+            return at;
+        }
+        if (cmp < 0) {
+            high = mid;
+        }
+        else {
+            low = mid + 1;
+        }
+    }
+    return 0;
+}
+
+/*
+* index_cursor(): Starts a cursor over the posting list for a word. A word in a mapped index that has not been
+*                 loaded is read straight from its compressed block in the file, without being loaded.
+* Params: index pointer (index), word to look up (word), cursor to start (cursor)
+* Returns: true if the word is in the index; false, leaving the cursor on an empty list, if not or on error
+*/
+bool index_cursor(index_t* index, const char* word, postings_cursor_t* cursor) {
+    if (cursor == NULL) {
+        return false;
+    }
+    postings_openCursor(cursor, NULL);
+    if (index == NULL || word == NULL) {
+        return false;
+    }
+    postings_t* postings = strtable_find(index->words, word);
+    if (postings == NULL && index->map != NULL && index->mapVersion >= 3) {
+        uint64_t at = find_entry(index, word);
+        uint64_t length, block;
+        int found = (at != 0 && read_entry(index, at, &length, &block) && open_block(index, block, cursor));
+        // A word in just one of the index and its segments is read from that file; one in several is
+        // put together in a list, once, below
+        for (int i = 0; i < index->numSegments && found < 2; i++) {
+            postings_cursor_t other;
+            if (index_cursor(index->segments[i], word, &other)) {
+                *cursor = other;
+                found++;
+            }
+        }
+        if (found < 2) {
+            return found == 1;
+        }
+    }
+    // Loaded already, or in a file whose blocks are not compressed, which lookup loads
+    postings = lookup(index, word);
+    postings_openCursor(cursor, postings);
+    return postings != NULL;
+}
+
+/*
+* read_entry(): Reads a dictionary entry of a mapped index, checking it lies within the dictionary
+* Params: index pointer (index), offset of the entry (at), where to store the word's length (length)
+*         and the offset of its posting block (block); the word itself starts at at + 4
+* Returns: true if the entry is valid, false if not
+*/
+static bool read_entry(const index_t* index, const uint64_t at, uint64_t* length, uint64_t* block) {
+    uint64_t end = index->dictionaryEnd;
+    *length = (at >= index->dictionary && at + 4 <= end) ? get32(index->map + at) : 0;
+    if (*length == 0 || *length + 12 > end - at) {
+        return false;
+    }
+    *block = get64(index->map + at + 4 + *length);
+    return *block >= end && *block <= index->mapLength - 4;
+}
+
+/*
+* open_block(): Starts a cursor over a compressed (version 3 or later) posting block of a mapped index
+* Params: index pointer (index), offset of the block (block, from read_entry), cursor to start (cursor)
+* Returns: true if the block lies within the file, false if not
+*/
+static bool open_block(const index_t* index, const uint64_t block, postings_cursor_t* cursor) {
+    if (block > index->mapLength - 8) {
+        return false;
+    }
+    uint64_t count = get32(index->map + block);
+    uint64_t length = get32(index->map + block + 4);
+    // Every posting takes at least two bytes, so a count too big for the length is corrupt
+    if (count > INT_MAX || length > index->mapLength - block - 8 || count > length / 2) {
+        return false;
+    }
+    postings_openEncoded(cursor, index->map + block + 8, length, count, index->mapVersion >= 4);
+    return true;
+}
+
+/*
+* load_entry(): Loads one word and its posting list from a mapped index, unless the word is already loaded
+* Params: index pointer (index), offset of the word's dictionary entry (at), where to store the offset of the next entry (next)
+* Returns: pointer to the word's posting list, or null if the entry is not valid or on error
+*/
+static postings_t* load_entry(index_t* index, const uint64_t at, uint64_t* next) {
+    const unsigned char* data = index->map;
+    size_t size = index->mapLength;
+    uint64_t length, block;
+    if (!read_entry(index, at, &length, &block)) {
+        return NULL;
+    }
+    *next = at + 4 + length + 8;
+
+    // Words are stored without their '\0', so each is copied out first
+    char* word = mem_malloc(length + 1);
+    if (word == NULL) {
+        return NULL;
+    }
+    memcpy(word, data + at + 4, length);
+    word[length] = '\0';
+    postings_t* postings = strtable_find(index->words, word);
+    if (postings != NULL) {
+        mem_free(word);
+        return postings;
+    }
+
+    bool ok;
+    if (index->mapVersion >= 3) {
+        postings_cursor_t cursor;
+        postings = open_block(index, block, &cursor) ? postings_fromCursor(&cursor) : NULL;
+        ok = (postings != NULL);
+    }
+    else {
+        // Uncompressed pairs; check all of them lie within the file
+        uint64_t count = get32(data + block);
+        ok = count <= (size - block - 4) / 8 && count <= INT_MAX;
+        postings = ok ? new_list(index) : NULL;
+        ok = ok && postings != NULL && postings_reserve(postings, count);
+        const unsigned char* pair = data + block + 4;
+        for (uint64_t j = 0; ok && j < count; j++, pair += 8) {
+            int docID = (int)get32(pair);
+            int docCount = (int)get32(pair + 4);
+            if (docID > 0 && docCount > 0) {
+                ok = postings_set(postings, docID, docCount);
+            }
+        }
+    }
+    ok = ok && strtable_insert(index->words, word, postings);
+    mem_free(word);
+    if (!ok) {
+        postings_delete(postings);
+        return NULL;
+    }
+    return postings;
+}
+
+/*
+* load_all(): Loads every word not yet loaded from a mapped index, then lets the mapping go, and takes in
+*             its segments, if it has any
+* Params: index pointer (index)
+* Returns: true if successful (or the index is not mapped), false if the file is not valid or on error
+*/
+static bool load_all(index_t* index) {
+    if (index->map == NULL) {
+        return true;
+    }
+    uint64_t at = index->dictionary;
+    for (uint32_t i = 0; i < index->mapWords; i++) {
+        if (load_entry(index, at, &at) == NULL) {
+            return false;
+        }
+    }
+    unmap(index);
+    return fold_segments(index);
+}
+
+/*
+* unmap(): Releases the mapped file of an index, if it has one
+* Params: index pointer (index)
+* Returns: None
+*/
+static void unmap(index_t* index) {
+    if (index->map != NULL) {
+        munmap((void*)index->map, index->mapLength);
+        index->map = NULL;
+        index->mapLength = 0;
+        index->mapWords = 0;
+    }
+}
+
+/*
+* lookup(): Finds the posting list for a word, loading it from the mapped file if it is there and not yet loaded
+* Params: index pointer (index), word to look up (word)
+* Returns: pointer to the word's posting list, or null if the word is not in the index
+*/
+static postings_t* lookup(index_t* index, const char* word) {
+    postings_t* postings = strtable_find(index->words, word);
+    if (postings != NULL || index->map == NULL) {
+        return postings;
+    }
+    uint64_t at = find_entry(index, word);
+    uint64_t next;
+    postings = (at != 0) ? load_entry(index, at, &next) : NULL;
+    return (index->numSegments > 0) ? add_segments(index, word, postings) : postings;
+}
+
+/*
+* find_or_add(): Finds the posting list for a word, adding an empty one if there is none
+* Params: index pointer (index), word to look up (word)
+* Returns: pointer to the word's posting list, or null on error
+*/
+static postings_t* find_or_add(index_t* index, const char* word) {
+    postings_t* postings = lookup(index, word);
+    if (postings != NULL) {
+        return postings;
+    }
+
+    // The table keeps its own copy of the word
+    postings = new_list(index);
+    if (postings == NULL) {
+        return NULL;
+    }
+    if (!strtable_insert(index->words, word, postings)) {
+        postings_delete(postings);
+        return NULL;
+    }
+    return postings;
+}
+
 /*
 * index_delete(): Frees all memory associated with index
 * Params: index pointer to delete (index)
@@ -322,21 +1083,291 @@ void index_delete(index_t* index) {
     if (index == NULL) {
         return;
     }
-    if (index->ht != NULL) {
-        hashtable_delete(index->ht, itemdelete);
+    // Lists from the arena all go with it, so unless index_insert took in others, none is freed alone
+    bool fromArena = (index->arena != NULL && index->heapLists == 0);
+    strtable_delete(index->words, fromArena ? NULL : postings_delete);
+    arena_delete(index->arena);
+    unmap(index);
+    for (int i = 0; i < index->numSegments; i++) {
+        index_delete(index->segments[i]);
+    }
+    if (index->segments != NULL) {
+        mem_free(index->segments);
     }
     mem_free(index);
 }
 
-static void itemdelete(void* item) {
-    if (item != NULL) {
-        word_counters_t* wc = item;
-        if (wc->word != NULL) {
-            mem_free(wc->word);
+/*
+* next_word(): Moves an input of index_merge on to its next dictionary entry, giving back what it has read
+* Params: the input (run)
+* Returns: true if there is a next entry; false at the end of the dictionary, or if the entry is not valid
+*/
+static bool next_word(merge_run_t* run) {
+    if (run->length != 0) { // past the first entry
+        run->at += 4 + run->length + 8;
+        run->left--;
+    }
+    release(run->index, &run->dictionaryDone, run->at);
+    if (run->left == 0 || !read_entry(run->index, run->at, &run->length, &run->block)) {
+        return false;
+    }
+    release(run->index, &run->blocksDone, run->block);
+    return true;
+}
+
+/*
+* run_before(): Tells whether one input of index_merge comes before another: its word sorts first or, if the
+*               words are the same, it is the earlier input
+* Params: the inputs (a, b)
+* Returns: true if a comes first
+*/
+static bool run_before(const merge_run_t* a, const merge_run_t* b) {
+    uint64_t length = (a->length < b->length) ? a->length : b->length;
+    int order = memcmp(a->index->map + a->at + 4, b->index->map + b->at + 4, length);
+    if (order != 0) {
+        return order < 0;
+    }
+    return (a->length != b->length) ? a->length < b->length : a->order < b->order;
+}
+
+/*
+* sift_down(): Moves an input down index_merge's heap until neither child comes before it
+* Params: the heap (heap), inputs on it (size), index of the input (at)
+* Returns: void
+*/
+static void sift_down(merge_run_t** heap, const int size, int at) {
+    while (2 * at + 1 < size) {
+        int child = 2 * at + 1;
+        if (child + 1 < size && run_before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!run_before(heap[child], heap[at])) {
+            return;
+        }
+        merge_run_t* swap = heap[at];
+        heap[at] = heap[child];
+        heap[child] = swap;
+        at = child;
+    }
+}
+
+/*
+* release(): Gives back the pages of a mapped index read so far, so they stop counting toward the memory in use.
+*            A fault maps in the whole of the page cache's large folio around the page it is for, which may
+*            start before pages already given back, so those behind are given back again, as far as one can reach.
+* Params: index pointer (index), page-aligned offset from which pages have not been given back (done), offset read to (upTo)
+* Returns: void
+*/
+static void release(const index_t* index, uint64_t* done, const uint64_t upTo) {
+    if (upTo >= *done + RELEASE_STEP) {
+        uint64_t from = (*done > RELEASE_BACK) ? *done - RELEASE_BACK : 0;
+        uint64_t to = page_floor(upTo);
+        madvise((void*)(index->map + from), to - from, MADV_DONTNEED);
+        *done = to;
+    }
+}
+
+/*
+* page_floor(): Rounds an offset down to a page boundary
+* Params: the offset (offset)
+* Returns: the rounded offset
+*/
+static uint64_t page_floor(const uint64_t offset) {
+    static long pageSize = 0;
+    if (pageSize == 0) {
+        pageSize = sysconf(_SC_PAGESIZE);
+    }
+    return offset / pageSize * pageSize;
+}
+
+/*
+* write_postings(): Writes the postings of an input's current word, in the text format
+* Params: file to write to (fp), the input (run), the last docID written for this word, updated (last)
+* Returns: true if successful; false if the block is not valid, its docIDs do not come after last, or on error
+*/
+static bool write_postings(FILE* fp, merge_run_t* run, int* last) {
+    postings_cursor_t cursor;
+    if (!open_block(run->index, run->block, &cursor)) {
+        return false;
+    }
+    posting_t entry;
+    while (postings_next(&cursor, &entry)) {
+        if (entry.docID <= *last) {
+            return false;
         }
-        if (wc->ctrs != NULL) {
-            counters_delete(wc->ctrs);
+        *last = entry.docID;
+        if (entry.count > 0 && fprintf(fp, "%d %d ", entry.docID, entry.count) < 0) {
+            return false;
         }
-        mem_free(wc);
     }
-}
\ No newline at end of file
+    return true;
+}
+
+/*
+* append_postings(): Appends the postings of an input's current word to a list
+* Params: the list (postings), the input (run), the last docID in the list, updated (last)
+* Returns: true if successful; false if the block is not valid, its docIDs do not come after last, or on error
+*/
+static bool append_postings(postings_t* postings, merge_run_t* run, int* last) {
+    postings_cursor_t cursor;
+    if (!open_block(run->index, run->block, &cursor)) {
+        return false;
+    }
+    posting_t entry;
+    while (postings_next(&cursor, &entry)) {
+        if (entry.docID <= *last || !postings_set(postings, entry.docID, entry.count)) {
+            return false;
+        }
+        *last = entry.docID;
+    }
+    return true;
+}
+
+/*
+* write_entry(): Writes one word of index_merge's binary output: its dictionary entry, and its posting block
+* Params: the output (out), the word (word, not ending in '\0') and its length (length), its list (postings)
+* Returns: true if successful, false on error
+*/
+static bool write_entry(merge_out_t* out, const unsigned char* word, const uint64_t length, const postings_t* postings) {
+    unsigned char field[8];
+    put32(field, length);
+    bool ok = fwrite(field, 4, 1, out->dictionary) == 1 && fwrite(word, 1, length, out->dictionary) == length;
+    put64(field, out->blocksBytes);
+    ok = ok && fwrite(field, 8, 1, out->dictionary) == 1;
+    ok = ok && write_block(out->blocks, postings, &out->buf, &out->cap);
+    out->numWords++;
+    out->dictionaryBytes += 4 + length + 8;
+    out->blocksBytes += 8 + postings_encodedSize(postings);
+    return ok;
+}
+
+/*
+* assemble(): Writes index_merge's binary output to its file: the header, then the word table, worked out from
+*             the dictionary, then the dictionary, with each block offset moved past it, then the blocks
+* Params: the output (out), filename to write to (filename)
+* Returns: true if successful, false on error
+*/
+static bool assemble(merge_out_t* out, const char* filename) {
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    uint64_t dictionary = HEADER_SIZE + 8 * (uint64_t)out->numWords;
+    uint64_t firstBlock = dictionary + out->dictionaryBytes;
+    unsigned char header[HEADER_SIZE];
+    memcpy(header, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    put32(header + 8, BINARY_VERSION);
+    put32(header + 12, out->numWords);
+    put64(header + 16, firstBlock);
+    put64(header + 24, HEADER_SIZE);
+    bool ok = fwrite(header, HEADER_SIZE, 1, fp) == 1;
+
+    // Word table: each entry's offset, stepping over the dictionary by its word lengths
+    rewind(out->dictionary);
+    unsigned char field[8];
+    for (uint32_t i = 0; ok && i < out->numWords; i++) {
+        ok = fread(field, 4, 1, out->dictionary) == 1;
+        uint64_t length = get32(field);
+        put64(field, dictionary);
+        ok = ok && fwrite(field, 8, 1, fp) == 1 && fseek(out->dictionary, length + 8, SEEK_CUR) == 0;
+        dictionary += 4 + length + 8;
+    }
+
+    // Dictionary, then blocks
+    rewind(out->dictionary);
+    for (uint32_t i = 0; ok && i < out->numWords; i++) {
+        ok = fread(field, 4, 1, out->dictionary) == 1;
+        uint64_t length = get32(field);
+        ok = ok && file_grow(&out->buf, &out->cap, length)
+             && fread(out->buf, 1, length, out->dictionary) == length
+             && fwrite(field, 4, 1, fp) == 1 && fwrite(out->buf, 1, length, fp) == length
+             && fread(field, 8, 1, out->dictionary) == 1;
+        put64(field, get64(field) + firstBlock);
+        ok = ok && fwrite(field, 8, 1, fp) == 1;
+    }
+    rewind(out->blocks);
+    ok = ok && copy_file(out->blocks, fp);
+    return (fclose(fp) == 0) && ok;
+}
+
+/*
+* copy_file(): Copies the rest of one file to another
+* Params: file to copy from (from), file to copy to (to)
+* Returns: true if successful, false on error
+*/
+static bool copy_file(FILE* from, FILE* to) {
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), from)) > 0) {
+        if (fwrite(buf, 1, n, to) != n) {
+            return false;
+        }
+    }
+    return !ferror(from);
+}
+
+/*
+* new_list(): Creates an empty posting list, from the index's arena if it has one
+* Params: index pointer (index)
+* Returns: pointer to the list, or null if out of memory
+*/
+static postings_t* new_list(index_t* index) {
+    return (index->arena != NULL) ? postings_newIn(index->arena) : postings_new();
+}
+
+// Helper for index_saveBinary, adds one word and its posting list to a term_list
+static void collect_helper(void* arg, const char* key, void* item) {
+    term_list_t* list = arg;
+    list->terms[list->size].word = key;
+    list->terms[list->size].postings = item;
+    list->size++;
+}
+
+// Helper for index_iterate, passes one word and its posting list on to the caller's function
+static void iterate_helper(void* arg, const char* key, void* item) {
+    iterate_call_t* call = arg;
+    (*call->itemfunc)(call->arg, key, item);
+}
+
+// Helper for index_saveBinary, qsort comparison of two terms by word
+static int compare_terms(const void* a, const void* b) {
+    return strcmp(((const term_t*)a)->word, ((const term_t*)b)->word);
+}
+
+/*
+* write_block(): Writes one word's posting block, compressed, leaving out postings with a count of 0
+* Params: file to write to (fp), the word's posting list (postings), scratch buffer and its capacity (buf, cap)
+* Returns: true if successful, false on error
+*/
+static bool write_block(FILE* fp, const postings_t* postings, char** buf, size_t* cap) {
+    if (!file_grow(buf, cap, 8 + postings_encodedSize(postings))) {
+        return false;
+    }
+    unsigned char* out = (unsigned char*)*buf;
+    int count;
+    size_t length = postings_encode(postings, out + 8, &count);
+    put32(out, count);
+    put32(out + 4, length);
+    return fwrite(out, 1, 8 + length, fp) == 8 + length;
+}
+
+// Encoders and decoders for the binary format's little-endian integers
+static void put32(unsigned char* p, const uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static void put64(unsigned char* p, const uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint32_t get32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get64(const unsigned char* p) {
+    return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
@@ -7,8 +7,8 @@
 #define INDEX_H
 
 #include <stdbool.h>
-#include "../libcs50/counters.h"
-#include "../libcs50/hashtable.h"
+#include <stddef.h>
+#include "postings.h"
 
 // Global types
 typedef struct index index_t;
@@ -16,12 +16,23 @@ typedef struct index index_t;
 // Functions
 
 /*
-* index_new(): Creates new index with specified hashtable size
-* Params: number of slots for hashtable (num_slots)
+* index_new(): Creates new, empty index
+* Params: number of words expected (num_slots); the index grows past it as needed
 * Returns: pointer to new index, or null if error
 */
 index_t* index_new(const int num_slots);
 
+/*
+* index_newArena(): Creates new, empty index whose posting lists, arrays and all, are allocated in large blocks
+*                   rather than one malloc each, and are all freed at once by index_delete. The arrays of a list
+*                   that grows are not freed as it outgrows them, so the index may take up to twice the memory.
+* Params: number of words expected (num_slots); the index grows past it as needed;
+*         bytes in each block (blockSize; 0 for the default, 1 MB); index_bytes counts whole blocks, so an index
+*         kept under a small budget wants small blocks
+* Returns: pointer to new index, or null if error
+*/
+index_t* index_newArena(const int num_slots, const size_t blockSize);
+
 /*
 * index_add(): Increments word occurrence for given id
 * Params: index pointer (index), word to add (word), document ID (id)
@@ -37,11 +48,50 @@ bool index_add(index_t* index, const char* word, const int id);
 bool index_set(index_t* index, const char* word, const int id, const int count);
 
 /*
-* index_get(): Retrieves counters for a given word
+* index_insert(): Adds a word with a whole posting list, which the index takes over and frees when it is deleted
+* Params: index pointer (index), word to add (word), its posting list (postings)
+* Returns: true if successful; false if the word is already in the index, or on error (the list is then the caller's)
+*/
+bool index_insert(index_t* index, const char* word, postings_t* postings);
+
+/*
+* index_get(): Retrieves the posting list for a given word
 * Params: index pointer (index), word to look up (word)
-* Returns: pointer to counters set, null if not found
+* Returns: pointer to the word's posting list, sorted by docID; null if not found
+*/
+postings_t* index_get(index_t* index, const char* word);
+
+/*
+* index_cursor(): Starts a cursor over the posting list for a word; for an index opened with index_open, a word
+*                 not yet loaded is read straight from the compressed list in the file, without loading it
+* Params: index pointer (index), word to look up (word), cursor to start (cursor)
+* Returns: true if the word is in the index; false, leaving the cursor on an empty list, if not or on error
+*/
+bool index_cursor(index_t* index, const char* word, postings_cursor_t* cursor);
+
+/*
+* index_iterate(): Calls a function on every word in the index and its posting list, in no particular order;
+*                  an index opened with index_open is loaded whole first. Several threads may iterate over one
+*                  index at once, as long as none changes it meanwhile and it was not opened with index_open
+* Params: index pointer (index), argument passed through (arg), function called on each word (itemfunc)
+* Returns: void
+*/
+void index_iterate(index_t* index, void* arg, void (*itemfunc)(void* arg, const char* word, postings_t* postings));
+
+/*
+* index_bytes(): Tells how much memory the index takes up, to keep an index being built under a budget
+* Params: index pointer (index)
+* Returns: bytes allocated for its words and, if it was made by index_newArena, its posting lists; 0 if index is null
+*/
+size_t index_bytes(index_t* index);
+
+/*
+* index_saveBytes(): Tells how much more memory index_saveBinary takes to write the index: its words, listed
+*                    and sorted, which the sort may copy
+* Params: index pointer (index)
+* Returns: bytes index_saveBinary may allocate; 0 if index is null
 */
-counters_t* index_get(index_t* index, const char* word);
+size_t index_saveBytes(index_t* index);
 
 /*
 * index_save(): Writes index to file in format
@@ -51,12 +101,55 @@ counters_t* index_get(index_t* index, const char* word);
 bool index_save(index_t* index, const char* filename);
 
 /*
-* index_load(): Reads index from file
+* index_saveBinary(): Writes index to file in the binary format: a versioned header, a dictionary of
+*                     the words in sorted order, and a length-prefixed block of postings for each word,
+*                     compressed as docID deltas and counts in varints
+* Params: index pointer (index), filename to write to (filename)
+* Returns: true if successful, false on error
+*/
+bool index_saveBinary(index_t* index, const char* filename);
+
+/*
+* index_load(): Reads index from file, in either the text format or the binary format, with the segments listed
+*               in its manifest, if it was updated with indexer -u; their postings follow the file's
 * Params: filename to read from (filename)
 * Returns: pointer to new index, null if error
 */
 index_t* index_load(const char* filename);
 
+/*
+* index_loadBinary(): Reads index from a file in the binary format, with the segments listed in its manifest, as
+*                     index_load does
+* Params: filename to read from (filename)
+* Returns: pointer to new index, null if error or if the file is not a binary index of a known version
+*/
+index_t* index_loadBinary(const char* filename);
+
+/*
+* index_merge(): Merges binary index files into one index file, with each word's postings from every input in
+*                turn. Every docID in the first input must come before every docID in the second, and so on, as
+*                when each holds the index of a later run of pages. Each input is read once, in word order, and
+*                pages of it are given back as they are read; nothing bigger than one word's postings is held in
+*                memory, so indexes far bigger than memory can be merged. The binary output is put together
+*                from temporary files, and is the same as index_saveBinary would write for the merged index.
+* Params: input filenames (filenames), binary indexes of version 3 or later; how many (numFiles);
+*         filename to write to (filename); whether to write the binary format rather than the text format (binary)
+* Returns: true if successful; false if an input is not valid, if the docIDs are not in order, or on error
+*/
+bool index_merge(const char** filenames, const int numFiles, const char* filename, const bool binary);
+
+/*
+* index_open(): Opens an index file for looking words up. A binary index is mapped rather than read, and each
+*               word's posting list is read from it only when index_get first asks for it, so opening takes the
+*               same time however big the index is; other index files are loaded whole, as by index_load.
+*               If the index has a manifest (see segments.h), the segments it lists are opened with it, and
+*               every word's postings are the index's own followed by each segment's: a word in one file only
+*               is read from that file, and one in several is put together in memory the first time it is asked for
+* Params: filename to read from (filename)
+* Returns: pointer to new index, null if error, or if a segment listed cannot be opened
+*/
+index_t* index_open(const char* filename);
+
 /*
 * index_delete(): Frees all memory associated with index and delete it
 * Params: index pointer to delete (index)
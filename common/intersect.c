@@ -0,0 +1,301 @@
+/*
+* intersect.c - Module that intersects sorted posting arrays. See intersect.h for more info.
+*
+* The SIMD kernels load a block of docIDs from each list (the counts in between are shuffled out), compare
+* every docID of a's block with every docID of b's by comparing a's block with each rotation of b's, and
+* then move past whichever block ends with the smaller docID (both, if they end the same). A docID can
+* only match within one of b's blocks, so each match is found once; the remainder is merged one at a time.
+* @author: Aniket Dey
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "intersect.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define INTERSECT_X86
+#include <immintrin.h>
+#endif
+
+// Local types
+typedef int (*merge_t)(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+
+// Global Constants
+static const int GALLOP_RATIO = 32; // gallop when the longer list is at least this many times the shorter
+static const int SPARSE_RATIO = 8; // merge by blocks when the longer list spans at least this many docIDs an entry
+
+// Global Variables
+static merge_t merge = NULL; // kernel chosen for merging sparse lists
+static const char* mergeName = NULL;
+static bool forced = false; // whether intersect_setKernel chose the kernel for dense lists too
+static pthread_once_t chosen = PTHREAD_ONCE_INIT;
+
+// Function Prototypes
+static void chooseKernel(void);
+static int mergeScalar(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+static int gallop(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+static int emitMatches(const posting_t* a, const posting_t* b, const int width, int mask, posting_t* out);
+#ifdef INTERSECT_X86
+static int mergeSSE2(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+static int mergeAVX2(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+#endif
+
+/*
+* intersect_postings: Finds the docIDs in both arrays, each with the smaller of its two counts
+* Params: a, sizeA, b, sizeB - arrays sorted by docID; out - room for the smaller of sizeA and sizeB entries
+* Returns: the number of entries written to out, in docID order
+*/
+int intersect_postings(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out) {
+    if (a == NULL || b == NULL || out == NULL || sizeA <= 0 || sizeB <= 0) {
+        return 0;
+    }
+    // The result is the same either way round, so let a be the shorter list
+    if (sizeA > sizeB) {
+        return intersect_postings(b, sizeB, a, sizeA, out);
+    }
+    if (sizeB / sizeA >= GALLOP_RATIO) {
+        return gallop(a, sizeA, b, sizeB, out);
+    }
+    pthread_once(&chosen, chooseKernel);
+    // A block merge pays only where few docIDs match; where most do, emitting them outweighs the compares saved
+    long long span = (long long)b[sizeB - 1].docID - b[0].docID + 1;
+    if (!forced && span < (long long)sizeB * SPARSE_RATIO) {
+        return mergeScalar(a, sizeA, b, sizeB, out);
+    }
+    return (*merge)(a, sizeA, b, sizeB, out);
+}
+
+/*
+* intersect_kernel: Tells which merge kernel intersect_postings uses for sparse lists
+* Params: None
+* Returns: "avx2", "sse2" or "scalar"
+*/
+const char* intersect_kernel(void) {
+    pthread_once(&chosen, chooseKernel);
+    return mergeName;
+}
+
+/*
+* intersect_setKernel: Chooses the merge kernel for all lists, dense or sparse
+* Params: name - "avx2", "sse2", "scalar", or "auto" to go back to choosing by the lists and the CPU
+* Returns: true if the kernel is chosen, false if the name is unknown or the CPU lacks the kernel
+*/
+bool intersect_setKernel(const char* name) {
+    pthread_once(&chosen, chooseKernel);
+    if (name == NULL) {
+        return false;
+    }
+    if (strcmp(name, "auto") == 0) {
+        chooseKernel();
+        return true;
+    }
+    if (strcmp(name, "scalar") == 0) {
+        merge = mergeScalar;
+        mergeName = "scalar";
+        forced = true;
+        return true;
+    }
+#ifdef INTERSECT_X86
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        merge = mergeSSE2;
+        mergeName = "sse2";
+        forced = true;
+        return true;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        merge = mergeAVX2;
+        mergeName = "avx2";
+        forced = true;
+        return true;
+    }
+#endif
+    return false;
+}
+
+/*
+* chooseKernel: Picks the widest merge kernel the CPU supports, for sparse lists
+* Params: None
+* Returns: None
+*/
+static void chooseKernel(void) {
+    merge = mergeScalar;
+    mergeName = "scalar";
+    forced = false;
+#ifdef INTERSECT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        merge = mergeAVX2;
+        mergeName = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        merge = mergeSSE2;
+        mergeName = "sse2";
+    }
+#endif
+}
+
+/*
+* mergeScalar: Merges the two arrays one entry at a time
+* Params: as for intersect_postings
+* Returns: the number of entries written to out
+*/
+static int mergeScalar(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out) {
+    int n = 0;
+    for (int i = 0, j = 0; i < sizeA && j < sizeB; ) {
+        int x = a[i].docID;
+        int y = b[j].docID;
+        if (x == y) {
+            out[n].docID = x;
+            out[n++].count = (a[i].count < b[j].count) ? a[i].count : b[j].count;
+            i++;
+            j++;
+        }
+        else if (x < y) {
+            i++;
+        }
+        else {
+            j++;
+        }
+    }
+    return n;
+}
+
+/*
+* gallop: Finds each docID of a, the much shorter array, in b, by doubling steps and then a binary search
+* Params: as for intersect_postings
+* Returns: the number of entries written to out
+*/
+static int gallop(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out) {
+    int n = 0;
+    int j = 0; // every entry of b before j is less than the docID sought
+    for (int i = 0; i < sizeA && j < sizeB; i++) {
+        int target = a[i].docID;
+        int high = j;
+        for (int step = 1; high < sizeB && b[high].docID < target; step *= 2) {
+            j = high + 1;
+            high += step;
+        }
+        // The first entry >= target is in [j, high], or is high itself
+        if (high > sizeB) {
+            high = sizeB;
+        }
+        while (j < high) {
+            int mid = j + (high - j) / 2;
+            if (b[mid].docID < target) {
+                j = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        if (j < sizeB && b[j].docID == target) {
+            out[n].docID = target;
+            out[n++].count = (a[i].count < b[j].count) ? a[i].count : b[j].count;
+            j++;
+        }
+    }
+    return n;
+}
+
+/*
+* emitMatches: Writes out the entries of a's block that the SIMD compare found in b's block
+* Params: the blocks (a, b), their width, bit k of mask set if a[k] is in b's block, out
+* Returns: the number of entries written to out
+*/
+static int emitMatches(const posting_t* a, const posting_t* b, const int width, int mask, posting_t* out) {
+    int n = 0;
+    while (mask != 0) {
+        int k = __builtin_ctz(mask);
+        mask &= mask - 1;
+        for (int t = 0; t < width; t++) {
+            if (b[t].docID == a[k].docID) {
+                out[n].docID = a[k].docID;
+                out[n++].count = (a[k].count < b[t].count) ? a[k].count : b[t].count;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+#ifdef INTERSECT_X86
+
+/*
+* mergeSSE2: Merges the two arrays 4 docIDs at a time, with SSE2
+* Params: as for intersect_postings
+* Returns: the number of entries written to out
+*/
+static int mergeSSE2(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out) {
+    int n = 0;
+    int i = 0;
+    int j = 0;
+    while (i + 4 <= sizeA && j + 4 <= sizeB) {
+        // Two loads of (docID, count) pairs each, keeping the docIDs
+        __m128 a01 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)&a[i]));
+        __m128 a23 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)&a[i + 2]));
+        __m128 b01 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)&b[j]));
+        __m128 b23 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)&b[j + 2]));
+        __m128i va = _mm_castps_si128(_mm_shuffle_ps(a01, a23, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i vb = _mm_castps_si128(_mm_shuffle_ps(b01, b23, _MM_SHUFFLE(2, 0, 2, 0)));
+
+        __m128i match = _mm_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 4; r++) {
+            vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+            match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        }
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(match));
+        if (mask != 0) {
+            n += emitMatches(&a[i], &b[j], 4, mask, &out[n]);
+        }
+
+        int lastA = a[i + 3].docID;
+        int lastB = b[j + 3].docID;
+        i += (lastA <= lastB) ? 4 : 0;
+        j += (lastB <= lastA) ? 4 : 0;
+    }
+    return n + mergeScalar(&a[i], sizeA - i, &b[j], sizeB - j, &out[n]);
+}
+
+/*
+* mergeAVX2: Merges the two arrays 8 docIDs at a time, with AVX2; only called if the CPU supports it
+* Params: as for intersect_postings
+* Returns: the number of entries written to out
+*/
+__attribute__((target("avx2")))
+static int mergeAVX2(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out) {
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    int n = 0;
+    int i = 0;
+    int j = 0;
+    while (i + 8 <= sizeA && j + 8 <= sizeB) {
+        // Within each 128-bit lane the shuffle keeps the docIDs, in the order 0 1 4 5 | 2 3 6 7;
+        // the permute puts them back in order
+        __m256 a03 = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&a[i]));
+        __m256 a47 = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&a[i + 4]));
+        __m256 b03 = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&b[j]));
+        __m256 b47 = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&b[j + 4]));
+        __m256i va = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(a03, a47, _MM_SHUFFLE(2, 0, 2, 0))),
+                                              _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i vb = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(b03, b47, _MM_SHUFFLE(2, 0, 2, 0))),
+                                              _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m256i match = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; r++) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va, vb));
+        }
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(match));
+        if (mask != 0) {
+            n += emitMatches(&a[i], &b[j], 8, mask, &out[n]);
+        }
+
+        int lastA = a[i + 7].docID;
+        int lastB = b[j + 7].docID;
+        i += (lastA <= lastB) ? 8 : 0;
+        j += (lastB <= lastA) ? 8 : 0;
+    }
+    return n + mergeScalar(&a[i], sizeA - i, &b[j], sizeB - j, &out[n]);
+}
+
+#endif // INTERSECT_X86
@@ -0,0 +1,45 @@
+/*
+* intersect.h - Header file for 'intersect.c' module
+*
+* Intersects two posting arrays sorted by docID, as AND queries need. When one list is much longer than
+* the other, each docID of the short list is found in the long one by galloping (exponential, then binary,
+* search), which skips most of the long list. Otherwise, if the lists are sparse - the longer one holds
+* fewer than 1 in 8 of the docIDs it spans, so few of them match - they are merged a block at a time with
+* SIMD compares: AVX2 (8 docIDs a block) or SSE2 (4), whichever is the widest the CPU has, chosen once at
+* run time. Dense lists, and lists on CPUs with neither, are merged one entry at a time; where most
+* docIDs match, writing out the matches costs the block merge more than its compares save.
+* @author: Aniket Dey
+*/
+
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+#include <stdbool.h>
+#include "postings.h"
+
+// Functions
+
+/*
+* intersect_postings: Finds the docIDs in both arrays, each with the smaller of its two counts
+* Params: a, sizeA, b, sizeB - arrays sorted by docID, without duplicates;
+*         out - room for the smaller of sizeA and sizeB entries (must not overlap a or b)
+* Returns: the number of entries written to out, in docID order
+*/
+int intersect_postings(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+
+/*
+* intersect_kernel: Tells which merge kernel intersect_postings uses for sparse lists
+* Params: None
+* Returns: "avx2", "sse2" or "scalar"
+*/
+const char* intersect_kernel(void);
+
+/*
+* intersect_setKernel: Chooses the merge kernel for all lists, dense or sparse, e.g. to test or time one against
+*                      another
+* Params: name - "avx2", "sse2", "scalar", or "auto" to go back to choosing by the lists and the CPU
+* Returns: true if the kernel is chosen, false if the name is unknown or the CPU lacks the kernel
+*/
+bool intersect_setKernel(const char* name);
+
+#endif // INTERSECT_H
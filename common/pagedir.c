@@ -3,9 +3,14 @@
 * @author: Aniket Dey
 */
 
+#define _DEFAULT_SOURCE // mmap, madvise
 #include <stdio.h> 
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "../libcs50/webpage.h"
 #include "../libcs50/file.h"
 #include "pagedir.h"
@@ -68,7 +73,8 @@ bool pagedir_save(const webpage_t* page, const char* pageDirectory, const int do
     }
 
     // Write the page contents
-    fprintf(fp, "%s\n%d\n%s", webpage_getURL(page), webpage_getDepth(page), webpage_getHTML(page));
+    fprintf(fp, "%s\n%d\n", webpage_getURL(page), webpage_getDepth(page));
+    fwrite(webpage_getHTML(page), 1, webpage_getHTMLLength(page), fp); // The html may be a view, not a string
     
     // Clean up
     fclose(fp);
@@ -77,19 +83,29 @@ bool pagedir_save(const webpage_t* page, const char* pageDirectory, const int do
 }
 
 /*
-* pagedir_validate: Checks if directory is a crawler-produced directory
+* pagedir_validate: Checks if directory is a crawler-produced directory, in either format
 * Params: pageDirectory - path to the directory to validate
-* Returns: true if directory contains .crawler file, false otherwise
+* Returns: true if directory contains a .crawler file naming a known format, false otherwise
 */
 bool pagedir_validate(const char* pageDirectory) {
+    return pagedir_format(pageDirectory) != PAGEDIR_NONE;
+}
+
+/*
+* pagedir_format: Detects which format a page directory uses, from its .crawler file
+* Params: pageDirectory - path to the directory
+* Returns: PAGEDIR_FILES or PAGEDIR_SEGMENT; PAGEDIR_NONE if there is no .crawler file
+*          or it names an unknown format
+*/
+pagedir_format_t pagedir_format(const char* pageDirectory) {
     if (pageDirectory == NULL) {
-        return false;
+        return PAGEDIR_NONE;
     }
     
     // Create the full path to .crawler file
     char* path = mem_malloc(strlen(pageDirectory) + strlen("/.crawler") + 1);
     if (path == NULL) {
-        return false;
+        return PAGEDIR_NONE;
     }
     
     strcpy(path, pageDirectory);
@@ -97,14 +113,23 @@ bool pagedir_validate(const char* pageDirectory) {
     
     // Try to open the file
     FILE* fp = fopen(path, "r");
+    mem_free(path);
     if (fp == NULL) {
-        mem_free(path);
-        return false;
+        return PAGEDIR_NONE;
     }
     
+    // An empty .crawler means one file per page, as the crawler has always written
+    pagedir_format_t format = PAGEDIR_NONE;
+    char* line = file_readLine(fp);
+    if (line == NULL || line[0] == '\0') {
+        format = PAGEDIR_FILES;
+    }
+    else if (strcmp(line, "segment") == 0) {
+        format = PAGEDIR_SEGMENT;
+    }
+    free(line);
     fclose(fp);
-    mem_free(path);
-    return true;
+    return format;
 }
 
 /*
@@ -134,27 +159,111 @@ webpage_t* pagedir_load(const char* pageDirectory, const int docID) {
         return NULL;
     }
 
-    // Read the page components
-    char* url = file_readLine(fp);
-    char* depth_str = file_readLine(fp);
-    char* html = file_readFile(fp);
+    // Read the whole file in bulk, then split it into its components
+    char* record = NULL;
+    size_t capacity = 0;
+    ssize_t length = file_getAll(fp, &record, &capacity);
+    fclose(fp);
+    char* urlEnd = (length > 0) ? memchr(record, '\n', length) : NULL;
+    char* depthEnd = (urlEnd != NULL) ? memchr(urlEnd + 1, '\n', record + length - (urlEnd + 1)) : NULL;
     
-    // Validate all components
-    if (url == NULL || depth_str == NULL || html == NULL) {
-        // Clean up any successfully allocated components
-        if (url != NULL) free(url);
-        if (depth_str != NULL) free(depth_str);
-        if (html != NULL) free(html);
-        fclose(fp);
+    // Validate all components; the html must not be empty
+    if (depthEnd == NULL || depthEnd + 1 == record + length) {
+        free(record);
+        return NULL;
+    }
+
+    char* url = malloc(urlEnd - record + 1);
+    if (url == NULL) {
+        free(record);
         return NULL;
     }
+    memcpy(url, record, urlEnd - record);
+    url[urlEnd - record] = '\0';
 
     // Convert depth string to integer
-    int depth = atoi(depth_str);
-    free(depth_str);
+    int depth = atoi(urlEnd + 1);
+
+    // Move the html to the front of the buffer, which becomes the page's html
+    memmove(record, depthEnd + 1, record + length - depthEnd);
     
     // Create webpage which now owns the url and html; don't free!
-    webpage_t* page = webpage_new(url, depth, html);
-    fclose(fp);
+    return webpage_new(url, depth, record);
+}
+
+/*
+* pagedir_map: Loads webpage from file in directory by mapping the file into memory; the html is not copied
+* Params: pageDirectory - directory containing page files, docID - ID of page to load
+* Returns: pointer to a webpage view (see webpage_newView) that unmaps the file when deleted; null otherwise
+*/
+webpage_t* pagedir_map(const char* pageDirectory, const int docID) {
+    if (pageDirectory == NULL || docID < 1) {
+        return NULL;
+    }
+
+    // Create the full path
+    int pathLength = snprintf(NULL, 0, "%s/%d", pageDirectory, docID) + 1;
+    char* path = mem_malloc(pathLength);
+    if (path == NULL) {
+        return NULL;
+    }
+    snprintf(path, pathLength, "%s/%d", pageDirectory, docID);
+
+    // Map the whole file; the mapping outlives the descriptor
+    int fd = open(path, O_RDONLY);
+    mem_free(path);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(map, info.st_size, MADV_SEQUENTIAL); // Pages are read front to back
+
+    webpage_t* page = pagedir_view(map, info.st_size, map, info.st_size);
+    if (page == NULL) {
+        munmap(map, info.st_size);
+    }
     return page;
-}
\ No newline at end of file
+}
+
+/*
+* pagedir_view: Makes a webpage from a page's record, "URL\ndepth\nHTML", held in memory; only the URL is copied
+* Params: record, its length (length), the mapping that holds it and its length (map, mapLength), or null
+*         and 0 if the caller keeps the record valid while the page is in use
+* Returns: pointer to a webpage view (see webpage_newView) that takes over map; null if the record is malformed
+*          or has no html, in which case map is left alone
+*/
+webpage_t* pagedir_view(const char* record, const size_t length, void* map, const size_t mapLength) {
+    if (record == NULL) {
+        return NULL;
+    }
+
+    // Find the ends of the URL and depth lines; the html is everything after
+    const char* urlEnd = memchr(record, '\n', length);
+    const char* depthEnd = (urlEnd != NULL) ? memchr(urlEnd + 1, '\n', record + length - (urlEnd + 1)) : NULL;
+    if (depthEnd == NULL || depthEnd + 1 == record + length) {
+        return NULL;
+    }
+    char* url = malloc(urlEnd - record + 1); // webpage_delete frees it with free
+    if (url == NULL) {
+        return NULL;
+    }
+    memcpy(url, record, urlEnd - record);
+    url[urlEnd - record] = '\0';
+    int depth = (int)strtol(urlEnd + 1, NULL, 10); // Stops at the newline
+
+    // Create webpage which now owns the url and the mapping
+    webpage_t* page = webpage_newView(url, depth, depthEnd + 1, record + length - (depthEnd + 1), map, mapLength);
+    if (page == NULL) {
+        free(url);
+    }
+    return page;
+}
@@ -11,6 +11,13 @@
 #include <string.h> 
 #include "../libcs50/webpage.h"
 
+// Formats in which a page directory may hold its pages; recorded in its .crawler file
+typedef enum {
+    PAGEDIR_NONE, // not a crawler-produced directory
+    PAGEDIR_FILES, // one file per page, named by docID (.crawler is empty)
+    PAGEDIR_SEGMENT // one append-only segment file plus an offset table (.crawler says "segment"); see pagestore.h
+} pagedir_format_t;
+
 /*
 * pagedir_init: Initializes directory to store pages with .crawler file
 * Params: pageDirectory - path to the directory to initialize
@@ -26,12 +33,20 @@ bool pagedir_init(const char* pageDirectory);
 bool pagedir_save(const webpage_t* page, const char* pageDirectory, const int id);
 
 /*
-* pagedir_validate: Checks if directory is a crawler-produced directory
+* pagedir_validate: Checks if directory is a crawler-produced directory, in either format
 * Params: pageDirectory - path to the directory to validate
-* Returns: true if directory contains .crawler filetype, false otherwise
+* Returns: true if directory contains a .crawler file naming a known format, false otherwise
 */
 bool pagedir_validate(const char* pageDirectory);
 
+/*
+* pagedir_format: Detects which format a page directory uses, from its .crawler file
+* Params: pageDirectory - path to the directory
+* Returns: PAGEDIR_FILES or PAGEDIR_SEGMENT; PAGEDIR_NONE if there is no .crawler file
+*          or it names an unknown format
+*/
+pagedir_format_t pagedir_format(const char* pageDirectory);
+
 /*
 * pagedir_load: Loads webpage from file in directory
 * Params: pageDirectory - directory containing page files, id - ID of page to load
@@ -39,4 +54,20 @@ bool pagedir_validate(const char* pageDirectory);
 */
 webpage_t* pagedir_load(const char* pageDirectory, const int id);
 
+/*
+* pagedir_map: Loads webpage from file in directory by mapping the file into memory; the html is not copied
+* Params: pageDirectory - directory containing page files, id - ID of page to load
+* Returns: pointer to a webpage view (see webpage_newView) that unmaps the file when deleted; null otherwise
+*/
+webpage_t* pagedir_map(const char* pageDirectory, const int id);
+
+/*
+* pagedir_view: Makes a webpage from a page's record, "URL\ndepth\nHTML", held in memory; only the URL is copied
+* Params: record, its length (length), the mapping that holds it and its length (map, mapLength), or null
+*         and 0 if the caller keeps the record valid while the page is in use
+* Returns: pointer to a webpage view (see webpage_newView) that takes over map; null if the record is malformed
+*          or has no html, in which case map is left alone
+*/
+webpage_t* pagedir_view(const char* record, const size_t length, void* map, const size_t mapLength);
+
 #endif // PAGEDIR_H
\ No newline at end of file
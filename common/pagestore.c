@@ -0,0 +1,415 @@
+/*
+* pagestore.c - Module that saves and loads pages in a page directory of either format. See pagestore.h for more info.
+* @author: Aniket Dey
+*/
+
+#define _DEFAULT_SOURCE // pread, pwrite, mmap
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../libcs50/webpage.h"
+#include "../libcs50/mem.h"
+#include "pagedir.h"
+#include "pagestore.h"
+
+// Local types
+
+// One entry of the offset table, for one docID
+typedef struct {
+    uint64_t offset; // where the page's record starts in the segment
+    uint64_t length; // its length in bytes; 0 if there is no such page
+} segentry_t;
+
+// One entry of the document table, for one docID
+typedef struct {
+    uint64_t url; // where the page's URL starts in the URL file
+    uint32_t urlLength; // its length, not counting the '\0' after it; 0 if there is no such page
+    int32_t depth;
+    uint64_t length; // bytes of html
+} docentry_t;
+
+typedef struct pagestore {
+    char* pageDirectory; // copy of the directory's path
+    pagedir_format_t format;
+    int segment; // segment file descriptor (segment format only)
+    int table; // offset table file descriptor (segment format only)
+    uint64_t end; // where the next record will be appended
+    pthread_mutex_t lock; // guards end
+    const char* segmentMap; // the segment, mapped read-only (loading only; null if empty)
+    size_t segmentLength;
+    const segentry_t* tableMap; // the offset table, mapped likewise
+    size_t tableLength; // in entries
+    int docs; // document table file descriptor (both formats; -1 if the directory has none)
+    int urls; // URL file descriptor, likewise
+    uint64_t urlsEnd; // where the next URL will be appended; guarded by lock
+    const docentry_t* docsMap; // the document table, mapped read-only (loading only; null if none)
+    size_t docsLength; // in bytes
+    const char* urlsMap; // the URL file, mapped likewise
+    size_t urlsLength;
+} pagestore_t;
+
+// Global Constants
+static const char* SEGMENT_FILE = "pages.seg";
+static const char* TABLE_FILE = "pages.idx";
+static const char* DOCS_FILE = "docs.idx";
+static const char* URLS_FILE = "docs.url";
+
+// Function Prototypes
+static pagestore_t* storeNew(const char* pageDirectory, const pagedir_format_t format);
+static int openInDirectory(const char* pageDirectory, const char* name, const int flags);
+static bool writeAll(const int fd, const char* buf, size_t len, off_t offset);
+static const void* mapFile(const int fd, size_t* length);
+static bool saveDoc(pagestore_t* store, const webpage_t* page, const int docID);
+static void openDocs(pagestore_t* store);
+
+/*
+* pagestore_create: Initializes a page directory in the given format, and opens it for saving
+* Params: pageDirectory - existing, writable directory; format - PAGEDIR_FILES or PAGEDIR_SEGMENT
+* Returns: pointer to the store, or null on error; any pages already in the directory are discarded
+*/
+pagestore_t* pagestore_create(const char* pageDirectory, const pagedir_format_t format) {
+    if (pageDirectory == NULL || (format != PAGEDIR_FILES && format != PAGEDIR_SEGMENT)) {
+        return NULL;
+    }
+    // The .crawler file marks the directory, and names its format
+    if (!pagedir_init(pageDirectory)) {
+        return NULL;
+    }
+    pagestore_t* store = storeNew(pageDirectory, format);
+    if (store == NULL) {
+        return NULL;
+    }
+    // Either format records every page in the document table
+    store->docs = openInDirectory(pageDirectory, DOCS_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    store->urls = openInDirectory(pageDirectory, URLS_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    if (store->docs < 0 || store->urls < 0) {
+        pagestore_close(store);
+        return NULL;
+    }
+    if (format == PAGEDIR_FILES) {
+        return store;
+    }
+
+    int marker = openInDirectory(pageDirectory, ".crawler", O_WRONLY | O_TRUNC);
+    bool marked = (marker >= 0 && writeAll(marker, "segment\n", strlen("segment\n"), 0));
+    if (marker >= 0) {
+        close(marker);
+    }
+    store->segment = openInDirectory(pageDirectory, SEGMENT_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    store->table = openInDirectory(pageDirectory, TABLE_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    if (!marked || store->segment < 0 || store->table < 0) {
+        pagestore_close(store);
+        return NULL;
+    }
+    return store;
+}
+
+/*
+* pagestore_open: Opens a crawler-produced page directory for loading, detecting its format
+* Params: pageDirectory - path to the directory
+* Returns: pointer to the store, or null if the directory is not valid or on error
+*/
+pagestore_t* pagestore_open(const char* pageDirectory) {
+    pagedir_format_t format = pagedir_format(pageDirectory);
+    if (format == PAGEDIR_NONE) {
+        return NULL;
+    }
+    pagestore_t* store = storeNew(pageDirectory, format);
+    if (store == NULL) {
+        return NULL;
+    }
+    openDocs(store);
+    if (format == PAGEDIR_FILES) {
+        return store;
+    }
+    // Map both files, so pages can be loaded without reading or copying their html
+    store->segment = openInDirectory(pageDirectory, SEGMENT_FILE, O_RDONLY);
+    store->table = openInDirectory(pageDirectory, TABLE_FILE, O_RDONLY);
+    if (store->segment < 0 || store->table < 0) {
+        pagestore_close(store);
+        return NULL;
+    }
+    store->segmentMap = mapFile(store->segment, &store->segmentLength);
+    store->tableMap = mapFile(store->table, &store->tableLength);
+    store->tableLength /= sizeof(segentry_t);
+    if (store->segmentMap == MAP_FAILED || store->tableMap == MAP_FAILED) {
+        pagestore_close(store);
+        return NULL;
+    }
+    return store;
+}
+
+/*
+* pagestore_format: Tells which format a store uses
+* Params: store
+* Returns: PAGEDIR_FILES or PAGEDIR_SEGMENT; PAGEDIR_NONE if store is null
+*/
+pagedir_format_t pagestore_format(const pagestore_t* store) {
+    return store != NULL ? store->format : PAGEDIR_NONE;
+}
+
+/*
+* pagestore_save: Saves a page under the given docID
+* Params: store (from pagestore_create), page - fetched page, docID - its document ID (> 0)
+* Returns: true if the page was saved, false otherwise
+*/
+bool pagestore_save(pagestore_t* store, const webpage_t* page, const int docID) {
+    if (store == NULL || page == NULL || docID < 1 || webpage_getHTML(page) == NULL) {
+        return false;
+    }
+    if (store->format == PAGEDIR_FILES) {
+        return pagedir_save(page, store->pageDirectory, docID) && saveDoc(store, page, docID);
+    }
+
+    // The record is laid out just as a per-page file would be
+    int headerLength = snprintf(NULL, 0, "%s\n%d\n", webpage_getURL(page), webpage_getDepth(page));
+    char* header = mem_malloc(headerLength + 1);
+    if (header == NULL) {
+        return false;
+    }
+    snprintf(header, headerLength + 1, "%s\n%d\n", webpage_getURL(page), webpage_getDepth(page));
+    size_t htmlLength = webpage_getHTMLLength(page);
+    segentry_t entry = { 0, headerLength + htmlLength };
+
+    // Only reserving space needs the lock; each writer then fills in its own region
+    pthread_mutex_lock(&store->lock);
+    entry.offset = store->end;
+    store->end += entry.length;
+    pthread_mutex_unlock(&store->lock);
+
+    // The table entry goes last, so a page is never visible before its record is complete
+    bool saved = writeAll(store->segment, header, headerLength, entry.offset)
+                 && writeAll(store->segment, webpage_getHTML(page), htmlLength, entry.offset + headerLength)
+                 && writeAll(store->table, (char*)&entry, sizeof(entry), (off_t)(docID - 1) * sizeof(entry));
+    mem_free(header);
+    return saved && saveDoc(store, page, docID);
+}
+
+/*
+* pagestore_load: Loads the page with the given docID
+* Params: store, docID - ID of page to load
+* Returns: pointer to a new webpage whose html is a read-only view of the stored page (see webpage_newView),
+*          which the caller must webpage_delete before closing the store; null if there is no such page
+*/
+webpage_t* pagestore_load(pagestore_t* store, const int docID) {
+    if (store == NULL || docID < 1) {
+        return NULL;
+    }
+    if (store->format == PAGEDIR_FILES) {
+        return pagedir_map(store->pageDirectory, docID);
+    }
+
+    // Find the record through the offset table; the page is a view of it
+    if ((size_t)docID > store->tableLength) {
+        return NULL;
+    }
+    segentry_t entry = store->tableMap[docID - 1];
+    if (entry.length == 0 || entry.offset > store->segmentLength
+        || entry.length > store->segmentLength - entry.offset) {
+        return NULL;
+    }
+    return pagedir_view(store->segmentMap + entry.offset, entry.length, NULL, 0);
+}
+
+/*
+* pagestore_describe: Looks a page up in the document table, without loading it
+* Params: store (from pagestore_open), docID - ID of the page, where to store its entry (doc)
+* Returns: true if the page is in the table; false if not, or if the directory has no table
+*/
+bool pagestore_describe(pagestore_t* store, const int docID, pagestore_doc_t* doc) {
+    if (store == NULL || doc == NULL || docID < 1 || store->docsMap == NULL || (size_t)docID > store->docsLength / sizeof(docentry_t)) {
+        return false;
+    }
+    // The URL, and the '\0' after it, must lie within the URL file
+    docentry_t entry = store->docsMap[docID - 1];
+    if (entry.urlLength == 0 || entry.url >= store->urlsLength || entry.urlLength >= store->urlsLength - entry.url
+        || store->urlsMap[entry.url + entry.urlLength] != '\0') {
+        return false;
+    }
+    doc->url = store->urlsMap + entry.url;
+    doc->depth = entry.depth;
+    doc->length = entry.length;
+    return true;
+}
+
+/*
+* pagestore_close: Closes the store and frees it
+* Params: store (may be null)
+* Returns: None
+*/
+void pagestore_close(pagestore_t* store) {
+    if (store != NULL) {
+        if (store->segment >= 0) {
+            close(store->segment);
+        }
+        if (store->table >= 0) {
+            close(store->table);
+        }
+        if (store->docs >= 0) {
+            close(store->docs);
+        }
+        if (store->urls >= 0) {
+            close(store->urls);
+        }
+        if (store->segmentMap != NULL && store->segmentMap != MAP_FAILED) {
+            munmap((void*)store->segmentMap, store->segmentLength);
+        }
+        if (store->tableMap != NULL && store->tableMap != MAP_FAILED) {
+            munmap((void*)store->tableMap, store->tableLength * sizeof(segentry_t));
+        }
+        if (store->docsMap != NULL) {
+            munmap((void*)store->docsMap, store->docsLength);
+        }
+        if (store->urlsMap != NULL) {
+            munmap((void*)store->urlsMap, store->urlsLength);
+        }
+        pthread_mutex_destroy(&store->lock);
+        mem_free(store->pageDirectory);
+        mem_free(store);
+    }
+}
+
+/*
+* storeNew: Allocates a store, with no files open
+* Params: pageDirectory, format
+* Returns: pointer to the store, or null on error
+*/
+static pagestore_t* storeNew(const char* pageDirectory, const pagedir_format_t format) {
+    pagestore_t* store = mem_malloc(sizeof(pagestore_t));
+    if (store == NULL) {
+        return NULL;
+    }
+    store->pageDirectory = mem_malloc(strlen(pageDirectory) + 1);
+    if (store->pageDirectory == NULL) {
+        mem_free(store);
+        return NULL;
+    }
+    strcpy(store->pageDirectory, pageDirectory);
+    store->format = format;
+    store->segment = -1;
+    store->table = -1;
+    store->end = 0;
+    store->segmentMap = NULL;
+    store->segmentLength = 0;
+    store->tableMap = NULL;
+    store->tableLength = 0;
+    store->docs = -1;
+    store->urls = -1;
+    store->urlsEnd = 0;
+    store->docsMap = NULL;
+    store->docsLength = 0;
+    store->urlsMap = NULL;
+    store->urlsLength = 0;
+    pthread_mutex_init(&store->lock, NULL);
+    return store;
+}
+
+/*
+* saveDoc: Records a saved page in the document table
+* Params: store (from pagestore_create), page, docID
+* Returns: true if successful, false on error
+*/
+static bool saveDoc(pagestore_t* store, const webpage_t* page, const int docID) {
+    const char* url = webpage_getURL(page);
+    size_t urlLength = strlen(url);
+    if (urlLength == 0 || urlLength > UINT32_MAX) {
+        return false;
+    }
+    docentry_t entry = { 0, urlLength, webpage_getDepth(page), webpage_getHTMLLength(page) };
+
+    // As in the segment, only reserving space in the URL file needs the lock
+    pthread_mutex_lock(&store->lock);
+    entry.url = store->urlsEnd;
+    store->urlsEnd += urlLength + 1;
+    pthread_mutex_unlock(&store->lock);
+
+    return writeAll(store->urls, url, urlLength + 1, entry.url)
+           && writeAll(store->docs, (char*)&entry, sizeof(entry), (off_t)(docID - 1) * sizeof(entry));
+}
+
+/*
+* openDocs: Maps the document table and URL file of a store opened for loading, if the directory has them;
+*           a directory without them (or whose files cannot be mapped) is left with no table
+* Params: store
+* Returns: None
+*/
+static void openDocs(pagestore_t* store) {
+    store->docs = openInDirectory(store->pageDirectory, DOCS_FILE, O_RDONLY);
+    store->urls = openInDirectory(store->pageDirectory, URLS_FILE, O_RDONLY);
+    if (store->docs < 0 || store->urls < 0) {
+        return;
+    }
+    const void* docsMap = mapFile(store->docs, &store->docsLength);
+    const void* urlsMap = mapFile(store->urls, &store->urlsLength);
+    if (docsMap != NULL && docsMap != MAP_FAILED && urlsMap != NULL && urlsMap != MAP_FAILED) {
+        store->docsMap = docsMap;
+        store->urlsMap = urlsMap;
+        return;
+    }
+    if (docsMap != NULL && docsMap != MAP_FAILED) {
+        munmap((void*)docsMap, store->docsLength);
+    }
+    if (urlsMap != NULL && urlsMap != MAP_FAILED) {
+        munmap((void*)urlsMap, store->urlsLength);
+    }
+    store->docsLength = 0;
+    store->urlsLength = 0;
+}
+
+/*
+* openInDirectory: Opens a file in the page directory
+* Params: pageDirectory, file name (name), open() flags
+* Returns: file descriptor, or -1 on error
+*/
+static int openInDirectory(const char* pageDirectory, const char* name, const int flags) {
+    int pathLength = snprintf(NULL, 0, "%s/%s", pageDirectory, name) + 1;
+    char* path = mem_malloc(pathLength);
+    if (path == NULL) {
+        return -1;
+    }
+    snprintf(path, pathLength, "%s/%s", pageDirectory, name);
+    int fd = open(path, flags, 0644);
+    mem_free(path);
+    return fd;
+}
+
+/*
+* writeAll: Writes len bytes at the given offset, however many calls it takes
+* Params: file descriptor (fd), bytes to write (buf, len), where to write them (offset)
+* Returns: true if all were written, false on error
+*/
+static bool writeAll(const int fd, const char* buf, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, offset);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+}
+
+/*
+* mapFile: Maps a whole file into memory, read-only
+* Params: file descriptor (fd), where to put its length in bytes (length)
+* Returns: the mapping; null if the file is empty, MAP_FAILED on error
+*/
+static const void* mapFile(const int fd, size_t* length) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return MAP_FAILED;
+    }
+    *length = info.st_size;
+    if (*length == 0) {
+        return NULL;
+    }
+    return mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+}
@@ -0,0 +1,100 @@
+/*
+* pagestore.h - Header file for 'pagestore.c' module
+*
+* A pagestore is an open page directory, for saving or loading pages by docID
+* in whichever format the directory uses (see pagedir_format_t in pagedir.h):
+*
+*   PAGEDIR_FILES   - one file per page, pageDirectory/<docID>, written and read
+*                     with pagedir_save and pagedir_load.
+*   PAGEDIR_SEGMENT - every page appended to one segment file, pageDirectory/pages.seg,
+*                     each as "URL\ndepth\nHTML" just like a per-page file; and an
+*                     offset table, pageDirectory/pages.idx, whose (docID-1)th entry
+*                     holds the 64-bit offset and 64-bit length of that page's record
+*                     (native byte order; length 0 if there is no such page).
+*
+* In either format, saving a page also records it in a document table, so a page's URL,
+* depth and length can be had without loading it (pagestore_describe): the URLs are
+* appended, each ending in '\0', to pageDirectory/docs.url, and the (docID-1)th entry of
+* pageDirectory/docs.idx holds the 64-bit offset of its URL there, the 32-bit length of
+* the URL (0 if there is no such page), the 32-bit depth, and the 64-bit length of its
+* html (native byte order). Directories crawled before the table existed have no such
+* files; they are still read, and pagestore_describe finds nothing in them.
+*
+* A store opened for loading maps its files into memory, and a loaded page's html
+* points into the mapping rather than being read and copied: in a segment store,
+* loading a page costs one lookup in the offset table and no system call at all,
+* however many pages the directory holds. Pages may be saved in any order, and
+* saving is safe from several threads at once, as is loading.
+* @author: Aniket Dey
+*/
+
+#ifndef PAGESTORE_H
+#define PAGESTORE_H
+
+#include <stdbool.h>
+#include "../libcs50/webpage.h"
+#include "pagedir.h"
+
+// Global types
+typedef struct pagestore pagestore_t;
+
+// A page's entry in the document table
+typedef struct pagestore_doc {
+    const char* url; // the page's URL, owned by the store
+    int depth; // its depth in the crawl
+    size_t length; // bytes of html
+} pagestore_doc_t;
+
+// Functions
+
+/*
+* pagestore_create: Initializes a page directory in the given format, and opens it for saving
+* Params: pageDirectory - existing, writable directory; format - PAGEDIR_FILES or PAGEDIR_SEGMENT
+* Returns: pointer to the store, or null on error; any pages already in the directory are discarded
+*/
+pagestore_t* pagestore_create(const char* pageDirectory, const pagedir_format_t format);
+
+/*
+* pagestore_open: Opens a crawler-produced page directory for loading, detecting its format
+* Params: pageDirectory - path to the directory
+* Returns: pointer to the store, or null if the directory is not valid or on error
+*/
+pagestore_t* pagestore_open(const char* pageDirectory);
+
+/*
+* pagestore_format: Tells which format a store uses
+* Params: store
+* Returns: PAGEDIR_FILES or PAGEDIR_SEGMENT; PAGEDIR_NONE if store is null
+*/
+pagedir_format_t pagestore_format(const pagestore_t* store);
+
+/*
+* pagestore_save: Saves a page under the given docID
+* Params: store (from pagestore_create), page - fetched page, docID - its document ID (> 0)
+* Returns: true if the page was saved, false otherwise
+*/
+bool pagestore_save(pagestore_t* store, const webpage_t* page, const int docID);
+
+/*
+* pagestore_load: Loads the page with the given docID
+* Params: store, docID - ID of page to load
+* Returns: pointer to a new webpage whose html is a read-only view of the stored page (see webpage_newView),
+*          which the caller must webpage_delete before closing the store; null if there is no such page
+*/
+webpage_t* pagestore_load(pagestore_t* store, const int docID);
+
+/*
+* pagestore_describe: Looks a page up in the document table, without loading it
+* Params: store (from pagestore_open), docID - ID of the page, where to store its entry (doc)
+* Returns: true if the page is in the table; false if not, or if the directory has no table
+*/
+bool pagestore_describe(pagestore_t* store, const int docID, pagestore_doc_t* doc);
+
+/*
+* pagestore_close: Closes the store and frees it
+* Params: store (may be null)
+* Returns: None
+*/
+void pagestore_close(pagestore_t* store);
+
+#endif // PAGESTORE_H
@@ -0,0 +1,684 @@
+/*
+* postings.c - Module for posting lists, sorted arrays of (docID, count). See postings.h for more info.
+* @author: Aniket Dey
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include "postings.h"
+#include "intersect.h"
+#include "../libcs50/mem.h"
+
+// Local types
+typedef struct postings {
+    posting_t* items; // sorted by docID, no duplicates
+    int size; // entries in use
+    int capacity; // entries allocated
+    arena_t* arena; // where items and the list itself come from; null if from the heap
+} postings_t;
+
+// Global Constants
+static const int MIN_CAPACITY = 4; // most words appear in only a few documents
+static const int BLOCK_SIZE = 128; // entries an encoding's block table entry covers
+static const size_t BLOCK_ENTRY = 12; // bytes in a block table entry: last docID, offset, largest count
+
+// Function Prototypes
+static int find(const postings_t* postings, const int docID);
+static bool insertAt(postings_t* postings, const int at, const int docID, const int count);
+static bool reserve(postings_t* postings, const int need);
+static bool resize(postings_t* postings, const int capacity);
+static size_t varintSize(unsigned int value);
+static unsigned char* putVarint(unsigned char* out, unsigned int value);
+static bool getVarint(postings_cursor_t* cursor, unsigned int* value);
+static int numBlocks(const int count);
+static void skipBlocks(postings_cursor_t* cursor, const int docID);
+static void put32(unsigned char* p, const uint32_t value);
+static uint32_t get32(const unsigned char* p);
+
+/*
+* postings_new: Creates a new, empty posting list
+* Params: None
+* Returns: pointer to the list, or null if out of memory
+*/
+postings_t* postings_new(void) {
+    postings_t* postings = mem_malloc(sizeof(postings_t));
+    if (postings == NULL) {
+        return NULL;
+    }
+    postings->items = NULL;
+    postings->size = 0;
+    postings->capacity = 0;
+    postings->arena = NULL;
+    return postings;
+}
+
+/*
+* postings_newIn: Creates a new, empty posting list in an arena
+* Params: the arena (arena)
+* Returns: pointer to the list, or null if out of memory
+*/
+postings_t* postings_newIn(arena_t* arena) {
+    postings_t* postings = arena_alloc(arena, sizeof(postings_t));
+    if (postings == NULL) {
+        return NULL;
+    }
+    postings->items = NULL;
+    postings->size = 0;
+    postings->capacity = 0;
+    postings->arena = arena;
+    return postings;
+}
+
+/*
+* postings_reserve: Makes room for at least need entries, so adding that many allocates at most once
+* Params: postings, need
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool postings_reserve(postings_t* postings, const int need) {
+    if (postings == NULL || need < 0) {
+        return false;
+    }
+    return need <= postings->capacity || resize(postings, need);
+}
+
+/*
+* postings_add: Adds one to the count for docID, adding docID with count 1 if it is not there
+* Params: postings, docID (> 0)
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool postings_add(postings_t* postings, const int docID) {
+    if (postings == NULL || docID <= 0) {
+        return false;
+    }
+    // Fast path: the indexer adds a document's words before moving on to the next document
+    int last = postings->size - 1;
+    if (last >= 0 && postings->items[last].docID == docID) {
+        postings->items[last].count++;
+        return true;
+    }
+    if (last < 0 || postings->items[last].docID < docID) {
+        return insertAt(postings, postings->size, docID, 1);
+    }
+
+    int at = find(postings, docID);
+    if (at < postings->size && postings->items[at].docID == docID) {
+        postings->items[at].count++;
+        return true;
+    }
+    return insertAt(postings, at, docID, 1);
+}
+
+/*
+* postings_set: Sets the count for docID, adding docID if it is not there
+* Params: postings, docID (> 0), count (>= 0)
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool postings_set(postings_t* postings, const int docID, const int count) {
+    if (postings == NULL || docID <= 0 || count < 0) {
+        return false;
+    }
+    int at = (postings->size > 0 && postings->items[postings->size - 1].docID < docID)
+             ? postings->size : find(postings, docID);
+    if (at < postings->size && postings->items[at].docID == docID) {
+        postings->items[at].count = count;
+        return true;
+    }
+    return insertAt(postings, at, docID, count);
+}
+
+/*
+* postings_get: Finds the count for docID
+* Params: postings, docID
+* Returns: the count, or 0 if docID is not in the list or postings is null
+*/
+int postings_get(const postings_t* postings, const int docID) {
+    if (postings == NULL) {
+        return 0;
+    }
+    int at = find(postings, docID);
+    return (at < postings->size && postings->items[at].docID == docID) ? postings->items[at].count : 0;
+}
+
+/*
+* postings_size: Tells how many documents are in the list
+* Params: postings
+* Returns: the number of entries, or 0 if postings is null
+*/
+int postings_size(const postings_t* postings) {
+    return (postings != NULL) ? postings->size : 0;
+}
+
+/*
+* postings_array: Gives read-only access to the entries, e.g. for merging lists
+* Params: postings
+* Returns: pointer to postings_size entries, sorted by docID; valid until the list is next changed
+*/
+const posting_t* postings_array(const postings_t* postings) {
+    return (postings != NULL) ? postings->items : NULL;
+}
+
+/*
+* postings_iterate: Calls itemfunc on every entry, in increasing order of docID
+* Params: postings, arg passed through to itemfunc, itemfunc
+* Returns: None
+*/
+void postings_iterate(const postings_t* postings, void* arg,
+                      void (*itemfunc)(void* arg, const int docID, const int count)) {
+    if (postings == NULL || itemfunc == NULL) {
+        return;
+    }
+    for (int i = 0; i < postings->size; i++) {
+        (*itemfunc)(arg, postings->items[i].docID, postings->items[i].count);
+    }
+}
+
+/*
+* postings_intersect: Makes the list of documents in both a and b, each with the smaller of its two counts
+* Params: a, b (either may be null, meaning empty)
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_intersect(const postings_t* a, const postings_t* b) {
+    postings_t* result = postings_new();
+    int sizeA = postings_size(a);
+    int sizeB = postings_size(b);
+    if (result == NULL || !reserve(result, sizeA < sizeB ? sizeA : sizeB)) {
+        postings_delete(result);
+        return NULL;
+    }
+    if (sizeA > 0 && sizeB > 0) {
+        result->size = intersect_postings(a->items, sizeA, b->items, sizeB, result->items);
+    }
+    return result;
+}
+
+/*
+* postings_union: Makes the list of documents in a or b, each with the sum of its counts
+* Params: a, b (either may be null, meaning empty)
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_union(const postings_t* a, const postings_t* b) {
+    postings_t* result = postings_new();
+    int sizeA = postings_size(a);
+    int sizeB = postings_size(b);
+    if (result == NULL || !reserve(result, sizeA + sizeB)) {
+        postings_delete(result);
+        return NULL;
+    }
+    // Merge the two sorted lists, adding the counts of docIDs found in both
+    int i = 0;
+    int j = 0;
+    while (i < sizeA || j < sizeB) {
+        posting_t* out = &result->items[result->size++];
+        if (j == sizeB || (i < sizeA && a->items[i].docID < b->items[j].docID)) {
+            *out = a->items[i++];
+        }
+        else if (i == sizeA || b->items[j].docID < a->items[i].docID) {
+            *out = b->items[j++];
+        }
+        else {
+            out->docID = a->items[i].docID;
+            out->count = a->items[i++].count + b->items[j++].count;
+        }
+    }
+    return result;
+}
+
+/*
+* postings_encodedSize: Tells how many bytes postings_encode will write for the list
+* Params: postings
+* Returns: the size of the encoding in bytes
+*/
+size_t postings_encodedSize(const postings_t* postings) {
+    size_t size = 0;
+    int previous = 0;
+    int count = 0;
+    for (int i = 0; i < postings_size(postings); i++) {
+        if (postings->items[i].count > 0) {
+            size += varintSize(postings->items[i].docID - previous) + varintSize(postings->items[i].count);
+            previous = postings->items[i].docID;
+            count++;
+        }
+    }
+    return size + numBlocks(count) * BLOCK_ENTRY;
+}
+
+/*
+* postings_encode: Compresses the list as docID deltas and counts, each a varint (see postings.h)
+* Params: postings, out (room for postings_encodedSize bytes), where to store the number of entries encoded (count)
+* Returns: the number of bytes written
+*/
+size_t postings_encode(const postings_t* postings, unsigned char* out, int* count) {
+    int entries = 0;
+    for (int i = 0; i < postings_size(postings); i++) {
+        entries += (postings->items[i].count > 0);
+    }
+    int blocks = numBlocks(entries);
+    unsigned char* start = out;
+    unsigned char* deltas = out + blocks * BLOCK_ENTRY; // the table is filled in as its blocks are written
+    out = deltas;
+
+    int previous = 0;
+    int largest = 0;
+    *count = 0;
+    // Most docIDs in a list are close to the one before, so most deltas and counts fit in one byte
+    for (int i = 0; i < postings_size(postings); i++) {
+        const posting_t* item = &postings->items[i];
+        if (item->count > 0) {
+            unsigned char* block = start + (*count / BLOCK_SIZE) * BLOCK_ENTRY;
+            if (blocks > 0 && *count % BLOCK_SIZE == 0) {
+                put32(block + 4, out - deltas);
+                largest = 0;
+            }
+            out = putVarint(out, item->docID - previous);
+            out = putVarint(out, item->count);
+            previous = item->docID;
+            largest = (item->count > largest) ? item->count : largest;
+            (*count)++;
+            if (blocks > 0 && (*count % BLOCK_SIZE == 0 || *count == entries)) {
+                put32(block, item->docID);
+                put32(block + 8, largest);
+            }
+        }
+    }
+    return out - start;
+}
+
+/*
+* postings_openCursor: Starts a cursor at the first entry of a list
+* Params: cursor, postings (null means an empty list)
+* Returns: None
+*/
+void postings_openCursor(postings_cursor_t* cursor, const postings_t* postings) {
+    cursor->items = postings_array(postings);
+    cursor->next = NULL;
+    cursor->end = NULL;
+    cursor->remaining = postings_size(postings);
+    cursor->docID = 0;
+    cursor->size = cursor->remaining;
+    cursor->deltas = NULL;
+    cursor->blocks = NULL;
+    cursor->numBlocks = 0;
+}
+
+/*
+* postings_openEncoded: Starts a cursor at the first entry of an encoded list
+* Params: cursor, the encoding (data, length bytes), and the number of entries it holds (count)
+* Returns: None
+*/
+void postings_openEncoded(postings_cursor_t* cursor, const unsigned char* data, const size_t length, const int count,
+                          const bool blocked) {
+    cursor->items = NULL;
+    cursor->remaining = (count > 0) ? count : 0;
+    cursor->docID = 0;
+    cursor->blocks = NULL;
+    cursor->numBlocks = blocked ? numBlocks(cursor->remaining) : 0;
+    size_t table = cursor->numBlocks * BLOCK_ENTRY;
+    if (table > length) {
+        cursor->remaining = 0; // Corrupt; the table does not fit
+        table = 0;
+        cursor->numBlocks = 0;
+    }
+    if (cursor->numBlocks > 0) {
+        cursor->blocks = data;
+    }
+    cursor->size = cursor->remaining;
+    cursor->deltas = data + table;
+    cursor->next = cursor->deltas;
+    cursor->end = data + length;
+}
+
+/*
+* postings_next: Reads the cursor's next entry
+* Params: cursor, where to store the entry (entry)
+* Returns: true if there was one, false at the end of the list or if the encoding is corrupt
+*/
+bool postings_next(postings_cursor_t* cursor, posting_t* entry) {
+    if (cursor->remaining <= 0) {
+        return false;
+    }
+    cursor->remaining--;
+    if (cursor->items != NULL) {
+        *entry = *cursor->items++;
+        return true;
+    }
+
+    unsigned int delta, count;
+    if (!getVarint(cursor, &delta) || !getVarint(cursor, &count)
+        || delta == 0 || delta > (unsigned int)(INT_MAX - cursor->docID) || count == 0 || count > INT_MAX) {
+        cursor->remaining = 0; // Corrupt; end the list here
+        return false;
+    }
+    cursor->docID += delta;
+    entry->docID = cursor->docID;
+    entry->count = count;
+    return true;
+}
+
+/*
+* postings_seek: Reads the cursor's first entry whose docID is at least docID, passing over those before it
+* Params: cursor, docID, where to store the entry (entry)
+* Returns: true if there was one, false if the list has no such entry left or the encoding is corrupt
+*/
+bool postings_seek(postings_cursor_t* cursor, const int docID, posting_t* entry) {
+    if (cursor->items != NULL) {
+        // Gallop to a range holding the first entry >= docID, then search it
+        const posting_t* items = cursor->items;
+        int low = 0;
+        int high = 0;
+        for (int step = 1; high < cursor->remaining && items[high].docID < docID; step *= 2) {
+            low = high + 1;
+            high += step;
+        }
+        if (high > cursor->remaining) {
+            high = cursor->remaining;
+        }
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            if (items[mid].docID < docID) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        cursor->items += low;
+        cursor->remaining -= low;
+    }
+    else if (cursor->blocks != NULL) {
+        skipBlocks(cursor, docID);
+    }
+    while (postings_next(cursor, entry)) {
+        if (entry->docID >= docID) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+* postings_remaining: Tells how many entries a cursor has not yet read
+* Params: cursor
+* Returns: the number of entries left, 0 at the end of the list
+*/
+int postings_remaining(const postings_cursor_t* cursor) {
+    return cursor->remaining;
+}
+
+/*
+* postings_bound: Tells the largest count among the entries a cursor has not yet read, or more
+* Params: cursor
+* Returns: the bound, 0 for an empty list
+*/
+int postings_bound(const postings_cursor_t* cursor) {
+    int bound = 0;
+    if (cursor->items == NULL && cursor->blocks != NULL) {
+        // The largest count of every block not yet passed
+        if (cursor->remaining > 0) {
+            for (int block = (cursor->size - cursor->remaining) / BLOCK_SIZE; block < cursor->numBlocks; block++) {
+                uint32_t largest = get32(cursor->blocks + block * BLOCK_ENTRY + 8);
+                if (largest > (uint32_t)bound) {
+                    bound = (largest > INT_MAX) ? INT_MAX : (int)largest;
+                }
+            }
+        }
+        return bound;
+    }
+    postings_cursor_t scan = *cursor;
+    posting_t entry;
+    while (postings_next(&scan, &entry)) {
+        bound = (entry.count > bound) ? entry.count : bound;
+    }
+    return bound;
+}
+
+/*
+* postings_fromCursor: Makes a list of the entries a cursor has not yet read, reading them all
+* Params: cursor
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_fromCursor(postings_cursor_t* cursor) {
+    postings_t* result = postings_new();
+    if (result == NULL || !reserve(result, cursor->remaining)) {
+        postings_delete(result);
+        return NULL;
+    }
+    // Entries come in docID order, so each is an append
+    posting_t entry;
+    while (postings_next(cursor, &entry)) {
+        result->items[result->size++] = entry;
+    }
+    return result;
+}
+
+/*
+* postings_intersectCursor: Like postings_intersect, with the second list read through a cursor, which it uses up
+* Params: a (may be null, meaning empty), cursor over b
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_intersectCursor(const postings_t* a, postings_cursor_t* b) {
+    postings_t* result = postings_new();
+    int sizeA = postings_size(a);
+    if (result == NULL || !reserve(result, sizeA < b->remaining ? sizeA : b->remaining)) {
+        postings_delete(result);
+        return NULL;
+    }
+    // A list in memory is intersected in place; only an encoded one has to be read an entry at a time
+    if (b->items != NULL) {
+        if (sizeA > 0 && b->remaining > 0) {
+            result->size = intersect_postings(a->items, sizeA, b->items, b->remaining, result->items);
+        }
+        b->items += b->remaining;
+        b->remaining = 0;
+        return result;
+    }
+    // Seeking reads b in order, as a merge would, but jumps any block that ends before the docID sought
+    posting_t y = { 0, 0 };
+    for (int i = 0; i < sizeA; i++) {
+        const posting_t* x = &a->items[i];
+        if (y.docID < x->docID && !postings_seek(b, x->docID, &y)) {
+            break;
+        }
+        if (y.docID == x->docID) {
+            posting_t* out = &result->items[result->size++];
+            out->docID = x->docID;
+            out->count = (x->count < y.count) ? x->count : y.count;
+        }
+    }
+    return result;
+}
+
+/*
+* postings_delete: Frees the list
+* Params: postings (may be null; void* so it can be used as a hashtable itemdelete)
+* Returns: None
+*/
+void postings_delete(void* postings) {
+    postings_t* list = postings;
+    if (list != NULL && list->arena == NULL) {
+        free(list->items); // Grown with realloc, so not counted by mem
+        mem_free(list);
+    }
+}
+
+/*
+* find: Binary search for docID
+* Params: postings, docID
+* Returns: the index of docID's entry if it is there; otherwise the index at which to insert it
+*/
+static int find(const postings_t* postings, const int docID) {
+    int low = 0;
+    int high = postings->size;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (postings->items[mid].docID < docID) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/*
+* insertAt: Inserts a new entry at the given index, moving later entries up
+* Params: postings, at (index, from find), docID, count
+* Returns: true if successful, false if out of memory
+*/
+static bool insertAt(postings_t* postings, const int at, const int docID, const int count) {
+    if (!reserve(postings, postings->size + 1)) {
+        return false;
+    }
+    memmove(&postings->items[at + 1], &postings->items[at], (postings->size - at) * sizeof(posting_t));
+    postings->items[at].docID = docID;
+    postings->items[at].count = count;
+    postings->size++;
+    return true;
+}
+
+/*
+* reserve: Makes room for at least need entries, doubling the capacity as needed
+* Params: postings, need
+* Returns: true if successful, false if out of memory
+*/
+static bool reserve(postings_t* postings, const int need) {
+    if (need <= postings->capacity) {
+        return true;
+    }
+    int capacity = (postings->capacity > 0) ? postings->capacity : MIN_CAPACITY;
+    while (capacity < need) {
+        capacity = (capacity <= INT_MAX / 2) ? capacity * 2 : need;
+    }
+    return resize(postings, capacity);
+}
+
+/*
+* resize: Moves the entries to an array of the given capacity, from the heap or from the list's arena
+* Params: postings, capacity (at least its size)
+* Returns: true if successful, false if out of memory
+*/
+static bool resize(postings_t* postings, const int capacity) {
+    posting_t* items;
+    if (postings->arena != NULL) {
+        items = arena_alloc(postings->arena, (size_t)capacity * sizeof(posting_t));
+        if (items != NULL && postings->size > 0) {
+            memcpy(items, postings->items, (size_t)postings->size * sizeof(posting_t));
+        }
+    }
+    else {
+        items = realloc(postings->items, (size_t)capacity * sizeof(posting_t));
+    }
+    if (items == NULL) {
+        return false;
+    }
+    postings->items = items;
+    postings->capacity = capacity;
+    return true;
+}
+
+/*
+* varintSize: Tells how many bytes a value takes as a varint
+* Params: value
+* Returns: 1 to 5
+*/
+static size_t varintSize(unsigned int value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/*
+* putVarint: Writes a value as a varint
+* Params: out (room for varintSize(value) bytes), value
+* Returns: pointer to the byte after the varint
+*/
+static unsigned char* putVarint(unsigned char* out, unsigned int value) {
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+/*
+* numBlocks: Tells how many entries the block table of an encoding of count entries has
+* Params: count
+* Returns: 0 if the list fits in one block, else one for each block of BLOCK_SIZE entries
+*/
+static int numBlocks(const int count) {
+    return (count > BLOCK_SIZE) ? (count - 1) / BLOCK_SIZE + 1 : 0;
+}
+
+/*
+* skipBlocks: Moves an encoded cursor to the start of the first block that can hold docID, if that is past the
+*             block it is in; a block holds docID if its last docID is docID or more
+* Params: cursor (with a block table), docID
+* Returns: None
+*/
+static void skipBlocks(postings_cursor_t* cursor, const int docID) {
+    int block = (cursor->size - cursor->remaining) / BLOCK_SIZE; // block of the next entry
+    if (cursor->remaining <= 0 || get32(cursor->blocks + block * BLOCK_ENTRY) >= (uint32_t)docID) {
+        return;
+    }
+    int low = block + 1;
+    int high = cursor->numBlocks;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (get32(cursor->blocks + mid * BLOCK_ENTRY) < (uint32_t)docID) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    if (low == cursor->numBlocks) {
+        cursor->remaining = 0; // Every docID left is smaller
+        return;
+    }
+
+    // The block's deltas continue from the last docID of the block before
+    uint32_t base = get32(cursor->blocks + (low - 1) * BLOCK_ENTRY);
+    uint32_t offset = get32(cursor->blocks + low * BLOCK_ENTRY + 4);
+    if (base > INT_MAX || offset > (size_t)(cursor->end - cursor->deltas)) {
+        cursor->remaining = 0; // Corrupt
+        return;
+    }
+    cursor->next = cursor->deltas + offset;
+    cursor->docID = base;
+    cursor->remaining = cursor->size - low * BLOCK_SIZE;
+}
+
+// Encoders and decoders for the block table's little-endian integers
+static void put32(unsigned char* p, const uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint32_t get32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/*
+* getVarint: Reads a varint from an encoded cursor
+* Params: cursor, where to store the value (value)
+* Returns: true if successful, false if the varint runs past the end of the encoding or is too long
+*/
+static bool getVarint(postings_cursor_t* cursor, unsigned int* value) {
+    *value = 0;
+    for (int shift = 0; shift < 35 && cursor->next < cursor->end; shift += 7) {
+        unsigned char byte = *cursor->next++;
+        *value |= (unsigned int)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
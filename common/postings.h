@@ -0,0 +1,218 @@
+/*
+* postings.h - Header file for 'postings.c' module
+*
+* A posting list holds, for one word, the (docID, count) pair of every document the word
+* appears in, in one contiguous array sorted by docID. Looking up a docID is a binary search,
+* and adding to the last docID or a larger one - the order in which the indexer reads
+* pages - is an append, so building an index this way never walks a list. A list made with
+* postings_newIn lives in an arena, array and all, and is freed with the arena rather than alone.
+* @author: Aniket Dey
+*/
+
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../libcs50/arena.h"
+
+// Global types
+
+// One document's entry in a posting list
+typedef struct posting {
+    int docID; // document the word appears in (> 0)
+    int count; // how many times it appears there
+} posting_t;
+
+typedef struct postings postings_t;
+
+/*
+* A cursor reads a posting list one entry at a time, in increasing order of docID, either from a postings_t
+* or straight from the list's compressed encoding (see postings_encode), so a list stored compressed - in a
+* mapped index file, say - can be merged with others without first being decoded into memory. A cursor can
+* also seek ahead to a docID (postings_seek), jumping over whole blocks of an encoding by its block table.
+* The fields are private; they are here only so a cursor can live on the stack.
+*/
+typedef struct postings_cursor {
+    const posting_t* items; // next entry of a postings_t; null if reading an encoding
+    const unsigned char* next; // next byte of an encoding
+    const unsigned char* end; // end of the encoding
+    int remaining; // entries not yet read
+    int docID; // docID last read from an encoding, to which the next delta is added
+    int size; // entries in the whole list
+    const unsigned char* deltas; // first entry of an encoding, after its block table
+    const unsigned char* blocks; // block table of an encoding; null if it has none
+    int numBlocks; // entries in the block table
+} postings_cursor_t;
+
+// Functions
+
+/*
+* postings_new: Creates a new, empty posting list
+* Params: None
+* Returns: pointer to the list, or null if out of memory
+*/
+postings_t* postings_new(void);
+
+/*
+* postings_newIn: Creates a new, empty posting list in an arena; as it grows, each larger array comes from the
+*                 arena too, and the smaller one stays there, unused, until the arena is deleted
+* Params: the arena (arena), which must outlive the list
+* Returns: pointer to the list, or null if out of memory
+*/
+postings_t* postings_newIn(arena_t* arena);
+
+/*
+* postings_reserve: Makes room for at least need entries, so adding that many allocates at most once
+* Params: postings, need
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool postings_reserve(postings_t* postings, const int need);
+
+/*
+* postings_add: Adds one to the count for docID, adding docID with count 1 if it is not there
+* Params: postings, docID (> 0)
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool postings_add(postings_t* postings, const int docID);
+
+/*
+* postings_set: Sets the count for docID, adding docID if it is not there
+* Params: postings, docID (> 0), count (>= 0)
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool postings_set(postings_t* postings, const int docID, const int count);
+
+/*
+* postings_get: Finds the count for docID
+* Params: postings, docID
+* Returns: the count, or 0 if docID is not in the list or postings is null
+*/
+int postings_get(const postings_t* postings, const int docID);
+
+/*
+* postings_size: Tells how many documents are in the list
+* Params: postings
+* Returns: the number of entries, or 0 if postings is null
+*/
+int postings_size(const postings_t* postings);
+
+/*
+* postings_array: Gives read-only access to the entries, e.g. for merging lists
+* Params: postings
+* Returns: pointer to postings_size entries, sorted by docID; valid until the list is next changed
+*/
+const posting_t* postings_array(const postings_t* postings);
+
+/*
+* postings_iterate: Calls itemfunc on every entry, in increasing order of docID
+* Params: postings, arg passed through to itemfunc, itemfunc
+* Returns: None
+*/
+void postings_iterate(const postings_t* postings, void* arg,
+                      void (*itemfunc)(void* arg, const int docID, const int count));
+
+/*
+* postings_intersect: Makes the list of documents in both a and b, each with the smaller of its two counts
+* Params: a, b (either may be null, meaning empty)
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_intersect(const postings_t* a, const postings_t* b);
+
+/*
+* postings_union: Makes the list of documents in a or b, each with the sum of its counts
+* Params: a, b (either may be null, meaning empty)
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_union(const postings_t* a, const postings_t* b);
+
+/*
+* postings_encodedSize: Tells how many bytes postings_encode will write for the list
+* Params: postings
+* Returns: the size of the encoding in bytes
+*/
+size_t postings_encodedSize(const postings_t* postings);
+
+/*
+* postings_encode: Compresses the list: for each entry with a count above 0, in docID order, the difference
+*                  between its docID and the previous one (the first counts from 0) and then its count, each
+*                  as a varint - 7 bits a byte, low bits first, with the high bit set on all but the last byte.
+*                  A list of more than 128 entries starts with a block table, so a cursor can skip over entries:
+*                  for each block of 128 entries, its last docID, the offset of its first byte from the end of
+*                  the table, and its largest count, each 32 bits, little-endian
+* Params: postings, out (room for postings_encodedSize bytes), where to store the number of entries encoded (count)
+* Returns: the number of bytes written
+*/
+size_t postings_encode(const postings_t* postings, unsigned char* out, int* count);
+
+/*
+* postings_openCursor: Starts a cursor at the first entry of a list
+* Params: cursor, postings (null means an empty list); the list must not change while the cursor is in use
+* Returns: None
+*/
+void postings_openCursor(postings_cursor_t* cursor, const postings_t* postings);
+
+/*
+* postings_openEncoded: Starts a cursor at the first entry of an encoded list
+* Params: cursor, the encoding (data, length bytes, which must stay in place while the cursor is in use),
+*         the number of entries it holds (count), and whether it has a block table (blocked; older encodings do not)
+* Returns: None
+*/
+void postings_openEncoded(postings_cursor_t* cursor, const unsigned char* data, const size_t length, const int count,
+                          const bool blocked);
+
+/*
+* postings_next: Reads the cursor's next entry
+* Params: cursor, where to store the entry (entry)
+* Returns: true if there was one, false at the end of the list or if the encoding is corrupt
+*/
+bool postings_next(postings_cursor_t* cursor, posting_t* entry);
+
+/*
+* postings_seek: Reads the cursor's first entry whose docID is at least docID, passing over those before it -
+*                by galloping through a list in memory, or by the block table of an encoding
+* Params: cursor, docID, where to store the entry (entry)
+* Returns: true if there was one, false if the list has no such entry left or the encoding is corrupt
+*/
+bool postings_seek(postings_cursor_t* cursor, const int docID, posting_t* entry);
+
+/*
+* postings_remaining: Tells how many entries a cursor has not yet read
+* Params: cursor
+* Returns: the number of entries left, 0 at the end of the list
+*/
+int postings_remaining(const postings_cursor_t* cursor);
+
+/*
+* postings_bound: Tells the largest count among the entries a cursor has not yet read, or more - an upper
+*                 bound on any score the list can contribute. An encoding's block table gives it without
+*                 decoding; a short or older encoding, or a list in memory, is scanned.
+* Params: cursor
+* Returns: the bound, 0 for an empty list
+*/
+int postings_bound(const postings_cursor_t* cursor);
+
+/*
+* postings_fromCursor: Makes a list of the entries a cursor has not yet read, reading them all
+* Params: cursor
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_fromCursor(postings_cursor_t* cursor);
+
+/*
+* postings_intersectCursor: Like postings_intersect, with the second list read through a cursor, which it uses up;
+*                            an encoded list is sought through for each docID of a, so when a is the shorter
+*                            list most of b is never decoded
+* Params: a (may be null, meaning empty), cursor over b
+* Returns: pointer to a new list, which the caller must postings_delete; null if out of memory
+*/
+postings_t* postings_intersectCursor(const postings_t* a, postings_cursor_t* b);
+
+/*
+* postings_delete: Frees the list; a list in an arena is left for arena_delete to free
+* Params: postings (may be null; void* so it can be used as a hashtable itemdelete)
+* Returns: None
+*/
+void postings_delete(void* postings);
+
+#endif // POSTINGS_H
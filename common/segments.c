@@ -0,0 +1,310 @@
+/*
+* segments.c - Module that keeps the manifest of an incrementally updated index. See segments.h for more info.
+*
+* The manifest is text: a line with the highest docID indexed and the number for the next segment, and then,
+* if they are recorded, that page's html length and URL; then one line with the number of each segment, in
+* docID order.
+* @author: Aniket Dey
+*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include "segments.h"
+#include "../libcs50/mem.h"
+
+// Function Prototypes
+static char* sideName(const char* indexFilename, const char* suffix);
+static int lockFile(const char* indexFilename, const char* suffix, const int how);
+
+/*
+* segments_read: Reads the manifest of an index
+* Params: indexFilename, the base index file
+* Returns: pointer to the manifest, which the caller must segments_delete; one with no segments and lastDocID 0
+*          if the index has no manifest; null if the manifest is not valid or out of memory
+*/
+segments_t* segments_read(const char* indexFilename) {
+    if (indexFilename == NULL) {
+        return NULL;
+    }
+    segments_t* segments = mem_calloc(1, sizeof(segments_t));
+    char* name = sideName(indexFilename, ".segments");
+    if (segments == NULL || name == NULL) {
+        if (name != NULL) {
+            mem_free(name);
+        }
+        segments_delete(segments);
+        return NULL;
+    }
+    segments->nextNumber = 1;
+    FILE* fp = fopen(name, "r");
+    mem_free(name);
+    if (fp == NULL) {
+        return segments; // No manifest: nothing recorded yet
+    }
+
+    // The first line; a manifest from before pages were recorded has only the two numbers
+    char* line = NULL;
+    size_t capacity = 0;
+    bool ok = getline(&line, &capacity, fp) > 0;
+    int url = 0; // where the URL starts in line
+    int fields = ok ? sscanf(line, "%d %d %zu %n", &segments->lastDocID, &segments->nextNumber,
+                             &segments->lastLength, &url) : 0;
+    ok = ok && fields >= 2 && segments->lastDocID >= 0 && segments->nextNumber >= 1;
+    if (ok && fields == 3) {
+        line[url + strcspn(line + url, " \t\r\n")] = '\0';
+        ok = line[url] != '\0' && segments_setLast(segments, segments->lastDocID, line + url, segments->lastLength);
+    }
+    free(line);
+
+    // Segment numbers are all below the next one
+    int number;
+    int result = EOF;
+    while (ok && (result = fscanf(fp, "%d", &number)) == 1) {
+        ok = number > 0 && number < segments->nextNumber && segments_add(segments, number);
+    }
+    ok = ok && result == EOF && !ferror(fp);
+    fclose(fp);
+    if (!ok) {
+        segments_delete(segments);
+        return NULL;
+    }
+    return segments;
+}
+
+/*
+* segments_write: Replaces the manifest of an index, by writing a new one beside it and renaming it over it
+* Params: segments, indexFilename
+* Returns: true if successful, false on error, leaving the old manifest as it was
+*/
+bool segments_write(const segments_t* segments, const char* indexFilename) {
+    if (segments == NULL || indexFilename == NULL) {
+        return false;
+    }
+    char* name = sideName(indexFilename, ".segments");
+    char* temporary = sideName(indexFilename, ".segments.new");
+    bool ok = (name != NULL && temporary != NULL);
+    FILE* fp = ok ? fopen(temporary, "w") : NULL;
+    ok = ok && fp != NULL;
+
+    if (ok) {
+        if (segments->lastURL != NULL) {
+            ok = fprintf(fp, "%d %d %zu %s\n", segments->lastDocID, segments->nextNumber, segments->lastLength,
+                         segments->lastURL) > 0;
+        }
+        else {
+            ok = fprintf(fp, "%d %d\n", segments->lastDocID, segments->nextNumber) > 0;
+        }
+        for (int i = 0; ok && i < segments->count; i++) {
+            ok = fprintf(fp, "%d\n", segments->numbers[i]) > 0;
+        }
+        ok = (fclose(fp) == 0) && ok;
+        // Readers see the old manifest or the new one, never part of one
+        ok = ok && rename(temporary, name) == 0;
+        if (!ok) {
+            remove(temporary);
+        }
+    }
+    if (name != NULL) {
+        mem_free(name);
+    }
+    if (temporary != NULL) {
+        mem_free(temporary);
+    }
+    return ok;
+}
+
+/*
+* segments_add: Adds a segment to the end of the list
+* Params: segments, number of the segment
+* Returns: true if successful, false if out of memory
+*/
+bool segments_add(segments_t* segments, const int number) {
+    if (segments == NULL) {
+        return false;
+    }
+    if (segments->count == segments->capacity) {
+        int capacity = (segments->capacity > 0) ? 2 * segments->capacity : 8;
+        int* numbers = mem_malloc(capacity * sizeof(int));
+        if (numbers == NULL) {
+            return false;
+        }
+        if (segments->numbers != NULL) {
+            memcpy(numbers, segments->numbers, segments->count * sizeof(int));
+            mem_free(segments->numbers);
+        }
+        segments->numbers = numbers;
+        segments->capacity = capacity;
+    }
+    segments->numbers[segments->count++] = number;
+    return true;
+}
+
+/*
+* segments_setLast: Records the highest docID indexed, and which page it was
+* Params: segments, lastDocID, the page's URL (url; null, or with white space in it, records none) and html length
+* Returns: true if successful, false if out of memory
+*/
+bool segments_setLast(segments_t* segments, const int lastDocID, const char* url, const size_t length) {
+    if (segments == NULL) {
+        return false;
+    }
+    char* copy = NULL;
+    // The manifest separates fields by white space, so a URL with some in it cannot be read back
+    if (url != NULL && url[strcspn(url, " \t\r\n")] == '\0') {
+        copy = mem_malloc(strlen(url) + 1);
+        if (copy == NULL) {
+            return false;
+        }
+        strcpy(copy, url);
+    }
+    if (segments->lastURL != NULL) {
+        mem_free(segments->lastURL);
+    }
+    segments->lastDocID = lastDocID;
+    segments->lastURL = copy;
+    segments->lastLength = (copy != NULL) ? length : 0;
+    return true;
+}
+
+/*
+* segments_name: Names a segment file
+* Params: indexFilename, number of the segment
+* Returns: the filename, indexFilename.segN, which the caller must mem_free; null if out of memory
+*/
+char* segments_name(const char* indexFilename, const int number) {
+    if (indexFilename == NULL) {
+        return NULL;
+    }
+    char* name = mem_malloc(strlen(indexFilename) + sizeof(".seg") + 11);
+    if (name != NULL) {
+        sprintf(name, "%s.seg%d", indexFilename, number);
+    }
+    return name;
+}
+
+/*
+* segments_remove: Removes an index's manifest and every segment it lists, as when the index is built afresh
+* Params: indexFilename
+* Returns: None
+*/
+void segments_remove(const char* indexFilename) {
+    if (indexFilename == NULL) {
+        return;
+    }
+    char* name = sideName(indexFilename, ".segments");
+    if (name == NULL || access(name, F_OK) != 0) {
+        if (name != NULL) {
+            mem_free(name); // No manifest, so no segments, and nothing to lock
+        }
+        return;
+    }
+    int lock = segments_lock(indexFilename, true);
+    segments_t* segments = segments_read(indexFilename);
+    for (int i = 0; segments != NULL && i < segments->count; i++) {
+        char* segment = segments_name(indexFilename, segments->numbers[i]);
+        if (segment != NULL) {
+            remove(segment);
+            mem_free(segment);
+        }
+    }
+    remove(name);
+    mem_free(name);
+    segments_delete(segments);
+    segments_unlock(lock);
+}
+
+/*
+* segments_lock: Locks an index's manifest, waiting for any other process's lock that conflicts
+* Params: indexFilename, whether to lock it exclusively, to change it, or shared, to read it (exclusive)
+* Returns: the lock, to give to segments_unlock; -1 if the lock file cannot be opened
+*/
+int segments_lock(const char* indexFilename, const bool exclusive) {
+    return lockFile(indexFilename, ".lock", exclusive ? LOCK_EX : LOCK_SH);
+}
+
+/*
+* segments_lockUpdate: Claims the right to add a segment to an index, waiting for any other process adding one
+* Params: indexFilename
+* Returns: the lock, to give to segments_unlock; -1 on error
+*/
+int segments_lockUpdate(const char* indexFilename) {
+    return lockFile(indexFilename, ".update", LOCK_EX);
+}
+
+/*
+* segments_lockFold: Claims the right to fold an index's segments, without waiting
+* Params: indexFilename
+* Returns: the lock, to give to segments_unlock; -1 if another process is folding them, or on error
+*/
+int segments_lockFold(const char* indexFilename) {
+    return lockFile(indexFilename, ".fold", LOCK_EX | LOCK_NB);
+}
+
+/*
+* segments_unlock: Releases a lock
+* Params: lock, as segments_lock or segments_lockFold gave it (may be -1)
+* Returns: None
+*/
+void segments_unlock(const int lock) {
+    if (lock >= 0) {
+        close(lock); // Closing the file releases its lock
+    }
+}
+
+/*
+* segments_delete: Frees the manifest
+* Params: segments (may be null)
+* Returns: None
+*/
+void segments_delete(segments_t* segments) {
+    if (segments != NULL) {
+        if (segments->numbers != NULL) {
+            mem_free(segments->numbers);
+        }
+        if (segments->lastURL != NULL) {
+            mem_free(segments->lastURL);
+        }
+        mem_free(segments);
+    }
+}
+
+/*
+* sideName: Names a file kept beside the index
+* Params: indexFilename, suffix
+* Returns: the filename, which the caller must mem_free; null if out of memory
+*/
+static char* sideName(const char* indexFilename, const char* suffix) {
+    char* name = mem_malloc(strlen(indexFilename) + strlen(suffix) + 1);
+    if (name != NULL) {
+        strcpy(name, indexFilename);
+        strcat(name, suffix);
+    }
+    return name;
+}
+
+/*
+* lockFile: Opens a lock file beside the index, creating it if need be, and locks it
+* Params: indexFilename, suffix of the lock file, how to lock it (as for flock)
+* Returns: the open lock file, or -1 if it cannot be opened or locked
+*/
+static int lockFile(const char* indexFilename, const char* suffix, const int how) {
+    if (indexFilename == NULL) {
+        return -1;
+    }
+    char* name = sideName(indexFilename, suffix);
+    if (name == NULL) {
+        return -1;
+    }
+    int fd = open(name, O_RDONLY | O_CREAT, 0644);
+    mem_free(name);
+    if (fd >= 0 && flock(fd, how) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
@@ -0,0 +1,117 @@
+/*
+* segments.h - Header file for 'segments.c' module
+*
+* Keeps track of an index that is kept up to date incrementally. Beside the base index file, a manifest,
+* indexFilename.segments, records the highest docID indexed so far, with the URL and html length of that page -
+* so an update can tell whether the page directory has been crawled again since, its docIDs starting over -
+* and lists the segments: binary index files,
+* indexFilename.segN, each holding the pages indexed by one later update (or, once folded, several). Every
+* docID in a segment comes after every docID in the base index and in the segments listed before it, so a
+* word's postings are those of the base followed by those of each segment in turn.
+*
+* The manifest is replaced whole, by renaming a new one over it, and is read and written under a lock on
+* indexFilename.lock: shared to open the segments it lists, exclusive to change it. That lock is only held
+* for moments; one process at a time may add a segment (indexFilename.update), and one may fold segments
+* together (indexFilename.fold), each holding its own lock throughout.
+* @author: Aniket Dey
+*/
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Global types
+
+typedef struct segments {
+    int lastDocID; // highest docID indexed, in the base index or a segment; 0 if none is recorded
+    char* lastURL; // URL of the page lastDocID was when indexed; null if not recorded
+    size_t lastLength; // bytes of that page's html
+    int nextNumber; // number for the next segment file
+    int* numbers; // the segments, by number, in docID order; a folded one may be numbered above those after it
+    int count; // entries in numbers
+    int capacity; // entries allocated
+} segments_t;
+
+// Functions
+
+/*
+* segments_read: Reads the manifest of an index
+* Params: indexFilename, the base index file
+* Returns: pointer to the manifest, which the caller must segments_delete; one with no segments and lastDocID 0
+*          if the index has no manifest; null if the manifest is not valid or out of memory
+*/
+segments_t* segments_read(const char* indexFilename);
+
+/*
+* segments_write: Replaces the manifest of an index, by writing a new one beside it and renaming it over it
+* Params: segments, indexFilename
+* Returns: true if successful, false on error, leaving the old manifest as it was
+*/
+bool segments_write(const segments_t* segments, const char* indexFilename);
+
+/*
+* segments_add: Adds a segment to the end of the list
+* Params: segments, number of the segment
+* Returns: true if successful, false if out of memory
+*/
+bool segments_add(segments_t* segments, const int number);
+
+/*
+* segments_setLast: Records the highest docID indexed, and which page it was
+* Params: segments, lastDocID, the page's URL (url; null, or with white space in it, records none) and html length
+* Returns: true if successful, false if out of memory
+*/
+bool segments_setLast(segments_t* segments, const int lastDocID, const char* url, const size_t length);
+
+/*
+* segments_name: Names a segment file
+* Params: indexFilename, number of the segment
+* Returns: the filename, indexFilename.segN, which the caller must mem_free; null if out of memory
+*/
+char* segments_name(const char* indexFilename, const int number);
+
+/*
+* segments_remove: Removes an index's manifest and every segment it lists, as when the index is built afresh
+* Params: indexFilename
+* Returns: None
+*/
+void segments_remove(const char* indexFilename);
+
+/*
+* segments_lock: Locks an index's manifest, waiting for any other process's lock that conflicts
+* Params: indexFilename, whether to lock it exclusively, to change it, or shared, to read it (exclusive)
+* Returns: the lock, to give to segments_unlock; -1 if the lock file cannot be opened
+*/
+int segments_lock(const char* indexFilename, const bool exclusive);
+
+/*
+* segments_lockUpdate: Claims the right to add a segment to an index, waiting for any other process adding one
+* Params: indexFilename
+* Returns: the lock, to give to segments_unlock; -1 on error
+*/
+int segments_lockUpdate(const char* indexFilename);
+
+/*
+* segments_lockFold: Claims the right to fold an index's segments, without waiting
+* Params: indexFilename
+* Returns: the lock, to give to segments_unlock; -1 if another process is folding them, or on error
+*/
+int segments_lockFold(const char* indexFilename);
+
+/*
+* segments_unlock: Releases a lock
+* Params: lock, as segments_lock or segments_lockFold gave it (may be -1)
+* Returns: None
+*/
+void segments_unlock(const int lock);
+
+/*
+* segments_delete: Frees the manifest
+* Params: segments (may be null)
+* Returns: None
+*/
+void segments_delete(segments_t* segments);
+
+#endif // SEGMENTS_H
@@ -0,0 +1,248 @@
+/*
+* termtable.c - Module that counts the words of one document. See termtable.h for more info.
+*
+* The words are kept in an array in the order first added, their text packed end to end in one buffer.
+* A power-of-two array of slots, kept under half full, finds a word's entry by linear probing from its
+* hash; each slot holds 1 + the entry's index, or 0 if empty. Entries never move, so clearing the table
+* empties just the slots its entries took, rather than the whole array.
+* @author: Aniket Dey
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "termtable.h"
+#include "../libcs50/hash.h"
+#include "../libcs50/mem.h"
+
+// Local types
+typedef struct term {
+    uint32_t hash; // low bits of hash_bytes(word)
+    int length; // bytes of word
+    size_t offset; // where the word starts in text
+    int count;
+    uint32_t slot; // the slot pointing here
+} term_t;
+
+typedef struct termtable {
+    uint32_t* slots; // 1 + index into terms, or 0 if empty
+    uint32_t numSlots; // a power of two
+    term_t* terms; // in the order first added
+    int size; // entries of terms in use
+    int capacity; // entries of terms allocated
+    char* text; // each word, then '\0'
+    size_t textUsed;
+    size_t textCapacity;
+} termtable_t;
+
+// Global Constants
+static const uint32_t MIN_SLOTS = 1024; // room for 512 distinct words before growing
+static const size_t MIN_TEXT = 8192; // bytes of text to start with
+
+// Function Prototypes
+static bool growSlots(termtable_t* table);
+static bool growTerms(termtable_t* table);
+static bool growText(termtable_t* table, const size_t need);
+
+/*
+* termtable_new: Creates an empty table
+* Params: None
+* Returns: pointer to the table, or null if out of memory
+*/
+termtable_t* termtable_new(void) {
+    termtable_t* table = mem_malloc(sizeof(termtable_t));
+    if (table == NULL) {
+        return NULL;
+    }
+    table->numSlots = MIN_SLOTS;
+    table->slots = mem_calloc(MIN_SLOTS, sizeof(uint32_t));
+    table->capacity = MIN_SLOTS / 2;
+    table->terms = mem_malloc(table->capacity * sizeof(term_t));
+    table->textCapacity = MIN_TEXT;
+    table->text = mem_malloc(MIN_TEXT);
+    table->size = 0;
+    table->textUsed = 0;
+    if (table->slots == NULL || table->terms == NULL || table->text == NULL) {
+        termtable_delete(table);
+        return NULL;
+    }
+    return table;
+}
+
+/*
+* termtable_add: Adds one to a word's count, adding the word with a count of 1 if it is not there
+* Params: table, word (need not end in '\0'), its length in bytes (length)
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool termtable_add(termtable_t* table, const char* word, const int length) {
+    if (table == NULL || word == NULL || length < 0) {
+        return false;
+    }
+    uint32_t hash = (uint32_t)hash_bytes(word, length);
+    uint32_t mask = table->numSlots - 1;
+    uint32_t at = hash & mask;
+    for ( ; table->slots[at] != 0; at = (at + 1) & mask) {
+        term_t* term = &table->terms[table->slots[at] - 1];
+        if (term->hash == hash && term->length == length && memcmp(&table->text[term->offset], word, length) == 0) {
+            term->count++;
+            return true;
+        }
+    }
+
+    // A new word: make room, then take the empty slot the probe ended on (or, after growing, a new one)
+    if (table->size == table->capacity && !growTerms(table)) {
+        return false;
+    }
+    if (!growText(table, table->textUsed + length + 1)) {
+        return false;
+    }
+    if ((uint32_t)(table->size + 1) > table->numSlots / 2) {
+        if (!growSlots(table)) {
+            return false;
+        }
+        mask = table->numSlots - 1;
+        at = hash & mask;
+        while (table->slots[at] != 0) {
+            at = (at + 1) & mask;
+        }
+    }
+    term_t* term = &table->terms[table->size];
+    term->hash = hash;
+    term->length = length;
+    term->offset = table->textUsed;
+    term->count = 1;
+    term->slot = at;
+    memcpy(&table->text[table->textUsed], word, length);
+    table->text[table->textUsed + length] = '\0';
+    table->textUsed += length + 1;
+    table->slots[at] = ++table->size;
+    return true;
+}
+
+/*
+* termtable_size: Tells how many distinct words are in the table
+* Params: table
+* Returns: the number of words, or 0 if table is null
+*/
+int termtable_size(const termtable_t* table) {
+    return (table != NULL) ? table->size : 0;
+}
+
+/*
+* termtable_iterate: Calls a function on every word in the table with its count, in the order first added
+* Params: table, argument passed through (arg), function called on each word (itemfunc)
+* Returns: None
+*/
+void termtable_iterate(const termtable_t* table, void* arg,
+                       void (*itemfunc)(void* arg, const char* word, const int count)) {
+    if (table == NULL || itemfunc == NULL) {
+        return;
+    }
+    for (int i = 0; i < table->size; i++) {
+        (*itemfunc)(arg, &table->text[table->terms[i].offset], table->terms[i].count);
+    }
+}
+
+/*
+* termtable_clear: Empties the table, keeping its memory for the next document
+* Params: table
+* Returns: None
+*/
+void termtable_clear(termtable_t* table) {
+    if (table == NULL) {
+        return;
+    }
+    for (int i = 0; i < table->size; i++) {
+        table->slots[table->terms[i].slot] = 0;
+    }
+    table->size = 0;
+    table->textUsed = 0;
+}
+
+/*
+* termtable_delete: Frees the table
+* Params: table (may be null)
+* Returns: None
+*/
+void termtable_delete(termtable_t* table) {
+    if (table == NULL) {
+        return;
+    }
+    if (table->slots != NULL) {
+        mem_free(table->slots);
+    }
+    if (table->terms != NULL) {
+        mem_free(table->terms);
+    }
+    if (table->text != NULL) {
+        mem_free(table->text);
+    }
+    mem_free(table);
+}
+
+/*
+* growSlots: Doubles the slots, placing every entry anew by its hash
+* Params: table
+* Returns: true if successful; false, leaving the table unchanged, if out of memory
+*/
+static bool growSlots(termtable_t* table) {
+    uint32_t numSlots = table->numSlots * 2;
+    uint32_t* slots = mem_calloc(numSlots, sizeof(uint32_t));
+    if (slots == NULL) {
+        return false;
+    }
+    for (int i = 0; i < table->size; i++) {
+        uint32_t at = table->terms[i].hash & (numSlots - 1);
+        while (slots[at] != 0) {
+            at = (at + 1) & (numSlots - 1);
+        }
+        slots[at] = i + 1;
+        table->terms[i].slot = at;
+    }
+    mem_free(table->slots);
+    table->slots = slots;
+    table->numSlots = numSlots;
+    return true;
+}
+
+/*
+* growTerms: Doubles the room for entries
+* Params: table
+* Returns: true if successful; false, leaving the table unchanged, if out of memory
+*/
+static bool growTerms(termtable_t* table) {
+    term_t* terms = mem_malloc(2 * (size_t)table->capacity * sizeof(term_t));
+    if (terms == NULL) {
+        return false;
+    }
+    memcpy(terms, table->terms, table->size * sizeof(term_t));
+    mem_free(table->terms);
+    table->terms = terms;
+    table->capacity *= 2;
+    return true;
+}
+
+/*
+* growText: Makes room for at least need bytes of text, doubling as needed
+* Params: table, need
+* Returns: true if successful; false, leaving the table unchanged, if out of memory
+*/
+static bool growText(termtable_t* table, const size_t need) {
+    if (need <= table->textCapacity) {
+        return true;
+    }
+    size_t capacity = 2 * table->textCapacity;
+    while (capacity < need) {
+        capacity *= 2;
+    }
+    char* text = mem_malloc(capacity);
+    if (text == NULL) {
+        return false;
+    }
+    memcpy(text, table->text, table->textUsed);
+    mem_free(table->text);
+    table->text = text;
+    table->textCapacity = capacity;
+    return true;
+}
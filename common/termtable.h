@@ -0,0 +1,65 @@
+/*
+* termtable.h - Header file for 'termtable.c' module
+*
+* Counts the words of one document before they go into the index, so the index is touched once for each
+* distinct word with its final count (index_set), rather than once for each time the word appears. The
+* table is small and stays in cache, and is cleared rather than freed between documents, so once it has
+* grown to the longest document it allocates nothing. Each thread indexing documents keeps its own.
+* @author: Aniket Dey
+*/
+
+#ifndef TERMTABLE_H
+#define TERMTABLE_H
+
+#include <stdbool.h>
+
+// Global types
+
+typedef struct termtable termtable_t;
+
+// Functions
+
+/*
+* termtable_new: Creates an empty table
+* Params: None
+* Returns: pointer to the table, or null if out of memory
+*/
+termtable_t* termtable_new(void);
+
+/*
+* termtable_add: Adds one to a word's count, adding the word with a count of 1 if it is not there
+* Params: table, word (need not end in '\0'), its length in bytes (length)
+* Returns: true if successful, false on bad arguments or out of memory
+*/
+bool termtable_add(termtable_t* table, const char* word, const int length);
+
+/*
+* termtable_size: Tells how many distinct words are in the table
+* Params: table
+* Returns: the number of words, or 0 if table is null
+*/
+int termtable_size(const termtable_t* table);
+
+/*
+* termtable_iterate: Calls a function on every word in the table with its count, in the order first added
+* Params: table, argument passed through (arg), function called on each word (itemfunc); the word ends in '\0'
+* Returns: None
+*/
+void termtable_iterate(const termtable_t* table, void* arg,
+                       void (*itemfunc)(void* arg, const char* word, const int count));
+
+/*
+* termtable_clear: Empties the table, keeping its memory for the next document
+* Params: table
+* Returns: None
+*/
+void termtable_clear(termtable_t* table);
+
+/*
+* termtable_delete: Frees the table
+* Params: table (may be null)
+* Returns: None
+*/
+void termtable_delete(termtable_t* table);
+
+#endif // TERMTABLE_H
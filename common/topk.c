@@ -0,0 +1,151 @@
+/*
+* topk.c - Module that keeps the k best-scoring documents. See topk.h for more info.
+* @author: Aniket Dey
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "topk.h"
+#include "../libcs50/mem.h"
+
+// Local types
+typedef struct topk {
+    posting_t* heap; // the documents kept, each with its score as its count; the worst is at the root
+    int size; // entries in use
+    int k; // entries allocated
+} topk_t;
+
+// Function Prototypes
+static bool worse(const posting_t* a, const posting_t* b);
+static void siftDown(posting_t* heap, const int size, int at);
+
+/*
+* topk_new: Creates an empty top-k list
+* Params: k (> 0), the number of documents to keep
+* Returns: pointer to the list, or null on bad arguments or out of memory
+*/
+topk_t* topk_new(const int k) {
+    if (k <= 0) {
+        return NULL;
+    }
+    topk_t* topk = mem_malloc(sizeof(topk_t));
+    if (topk == NULL) {
+        return NULL;
+    }
+    topk->heap = mem_malloc((size_t)k * sizeof(posting_t));
+    if (topk->heap == NULL) {
+        mem_free(topk);
+        return NULL;
+    }
+    topk->size = 0;
+    topk->k = k;
+    return topk;
+}
+
+/*
+* topk_offer: Offers a document, which is kept if it is among the k best offered so far
+* Params: topk, docID, score
+* Returns: true if the document was kept, false if not
+*/
+bool topk_offer(topk_t* topk, const int docID, const int score) {
+    if (topk == NULL) {
+        return false;
+    }
+    posting_t entry = { docID, score };
+    if (topk->size < topk->k) {
+        // Sift the new entry up from the bottom
+        int at = topk->size++;
+        while (at > 0 && worse(&entry, &topk->heap[(at - 1) / 2])) {
+            topk->heap[at] = topk->heap[(at - 1) / 2];
+            at = (at - 1) / 2;
+        }
+        topk->heap[at] = entry;
+        return true;
+    }
+    if (!worse(&topk->heap[0], &entry)) {
+        return false;
+    }
+    // Replace the worst kept
+    topk->heap[0] = entry;
+    siftDown(topk->heap, topk->size, 0);
+    return true;
+}
+
+/*
+* topk_threshold: Tells the score a document must beat to be kept
+* Params: topk
+* Returns: the worst score kept once k documents are kept; 0 until then
+*/
+int topk_threshold(const topk_t* topk) {
+    return (topk != NULL && topk->size == topk->k) ? topk->heap[0].count : 0;
+}
+
+/*
+* topk_size: Tells how many documents are kept
+* Params: topk
+* Returns: the number kept, at most k
+*/
+int topk_size(const topk_t* topk) {
+    return (topk != NULL) ? topk->size : 0;
+}
+
+/*
+* topk_sort: Sorts the documents kept best first; no more may be offered after
+* Params: topk
+* Returns: the topk_size documents kept, each with its score as its count, best first; owned by the list
+*/
+const posting_t* topk_sort(topk_t* topk) {
+    if (topk == NULL) {
+        return NULL;
+    }
+    // Heapsort: each pass moves the worst left to the end of what remains
+    for (int last = topk->size - 1; last > 0; last--) {
+        posting_t worst = topk->heap[0];
+        topk->heap[0] = topk->heap[last];
+        topk->heap[last] = worst;
+        siftDown(topk->heap, last, 0);
+    }
+    return topk->heap;
+}
+
+/*
+* topk_delete: Frees the list
+* Params: topk (may be null)
+* Returns: None
+*/
+void topk_delete(topk_t* topk) {
+    if (topk != NULL) {
+        mem_free(topk->heap);
+        mem_free(topk);
+    }
+}
+
+/*
+* worse: Tells whether one document ranks below another: a lower score, or the same score and a higher docID
+* Params: a, b
+* Returns: true if a ranks below b
+*/
+static bool worse(const posting_t* a, const posting_t* b) {
+    return a->count < b->count || (a->count == b->count && a->docID > b->docID);
+}
+
+/*
+* siftDown: Moves an entry down the heap until neither child is worse than it
+* Params: heap, size (entries in use), at (index of the entry)
+* Returns: None
+*/
+static void siftDown(posting_t* heap, const int size, int at) {
+    posting_t entry = heap[at];
+    while (2 * at + 1 < size) {
+        int child = 2 * at + 1;
+        if (child + 1 < size && worse(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!worse(&heap[child], &entry)) {
+            break;
+        }
+        heap[at] = heap[child];
+        at = child;
+    }
+    heap[at] = entry;
+}
@@ -0,0 +1,65 @@
+/*
+* topk.h - Header file for 'topk.c' module
+*
+* Keeps the k best-scoring documents offered to it, in a min-heap of k entries whose root is the worst one
+* kept, so each offer costs O(log k) and ranking n documents costs O(n log k) rather than a scan of all n
+* for each result. A higher score is better; between equal scores, the lower docID is.
+* @author: Aniket Dey
+*/
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <stdbool.h>
+#include "postings.h"
+
+// Global types
+
+typedef struct topk topk_t;
+
+// Functions
+
+/*
+* topk_new: Creates an empty top-k list
+* Params: k (> 0), the number of documents to keep
+* Returns: pointer to the list, or null on bad arguments or out of memory
+*/
+topk_t* topk_new(const int k);
+
+/*
+* topk_offer: Offers a document, which is kept if it is among the k best offered so far
+* Params: topk, docID, score
+* Returns: true if the document was kept, false if not
+*/
+bool topk_offer(topk_t* topk, const int docID, const int score);
+
+/*
+* topk_threshold: Tells the score a document must beat to be kept. Documents offered in increasing order of
+*                 docID lose every tie with those kept, so one scoring no more than this can be passed over.
+* Params: topk
+* Returns: the worst score kept once k documents are kept; 0 until then
+*/
+int topk_threshold(const topk_t* topk);
+
+/*
+* topk_size: Tells how many documents are kept
+* Params: topk
+* Returns: the number kept, at most k
+*/
+int topk_size(const topk_t* topk);
+
+/*
+* topk_sort: Sorts the documents kept best first; no more may be offered after
+* Params: topk
+* Returns: the topk_size documents kept, each with its score as its count, best first; owned by the list
+*/
+const posting_t* topk_sort(topk_t* topk);
+
+/*
+* topk_delete: Frees the list
+* Params: topk (may be null)
+* Returns: None
+*/
+void topk_delete(topk_t* topk);
+
+#endif // TOPK_H
@@ -1,11 +1,28 @@
 /*
-* word.c - Word module for TSE, provides functions for normalizing words.
+* word.c - Word module for TSE, provides functions for normalizing words, and for scanning them out of html.
+*
+* A byte c is a letter if (c | 0x20) - 'a' < 26, taken unsigned; for a letter, c | 0x20 is its lower case.
+* The SSE2 paths test 16 bytes at once that way: with no unsigned byte compare, they also subtract 128 (mod 256)
+* and compare signed against 26 - 128. They only ever load 16 bytes that lie within the html.
 * @author: Aniket Dey
 */
 
 #include <ctype.h>
 #include <string.h>
+#include <stdbool.h>
 #include "word.h"
+#include "../libcs50/mem.h"
+
+#if defined(__SSE2__)
+#define WORD_SSE2
+#include <emmintrin.h>
+#endif
+
+// Function Prototypes
+static bool isLetter(const unsigned char c);
+static size_t skipToLetter(const char* doc, const size_t len, size_t at);
+static bool foldWord(wordscan_t* scan, const char* doc, const size_t len, size_t* at);
+static bool reserveWord(wordscan_t* scan, const size_t used, const size_t need);
 
 /*
 * normalizeWord(): Converts all characters in word to lowercase.
@@ -20,4 +37,183 @@ void normalizeWord(char* word) {
     for (int i = 0; word[i] != '\0'; i++) {
         word[i] = tolower(word[i]);
     }
-}
\ No newline at end of file
+}
+
+/*
+* wordscan_open(): Starts a scan over the words of some html
+* Params: scanner to start (scan), the html (html), its length in bytes (length),
+*         the fewest letters a word must have to be found (minLength)
+* Returns: void
+*/
+void wordscan_open(wordscan_t* scan, const char* html, const size_t length, const int minLength) {
+    if (scan == NULL) {
+        return;
+    }
+    scan->html = html;
+    scan->length = (html != NULL) ? length : 0;
+    scan->at = 0;
+    scan->minLength = (minLength > 0) ? minLength : 1;
+    scan->word = scan->buffer;
+    scan->capacity = WORDSCAN_BUFFER;
+}
+
+/*
+* wordscan_next(): Finds the next word of at least minLength letters, lower-casing it as it goes
+* Params: scanner (scan), where to store the word's length (length; may be null)
+* Returns: the word, owned by the scanner until the next call; null once there are no more words, or if out of memory
+*/
+const char* wordscan_next(wordscan_t* scan, int* length) {
+    if (scan == NULL || scan->html == NULL) {
+        return NULL;
+    }
+    const char* doc = scan->html;
+    const size_t len = scan->length;
+    size_t at = scan->at;
+
+    while ((at = skipToLetter(doc, len, at)) < len) {
+        // doc[at] begins a word; copy it lower-cased up to the first byte that is not a letter
+        const size_t beg = at;
+        if (!foldWord(scan, doc, len, &at)) {
+            return NULL;
+        }
+        if (at - beg >= (size_t)scan->minLength) {
+            scan->word[at - beg] = '\0';
+            scan->at = at;
+            if (length != NULL) {
+                *length = at - beg;
+            }
+            return scan->word;
+        }
+    }
+    scan->at = len;
+    return NULL;
+}
+
+/*
+* wordscan_close(): Ends a scan, freeing anything it allocated for a long word
+* Params: scanner (scan)
+* Returns: void
+*/
+void wordscan_close(wordscan_t* scan) {
+    if (scan != NULL && scan->word != scan->buffer) {
+        mem_free(scan->word);
+        scan->word = scan->buffer;
+        scan->capacity = WORDSCAN_BUFFER;
+    }
+}
+
+/*
+* isLetter(): Tells whether a byte is an ASCII letter, as isalpha does in the C locale
+* Params: the byte (c)
+* Returns: true if it is a letter
+*/
+static bool isLetter(const unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+/*
+* skipToLetter(): Skips bytes that are not letters, and whole <...> tags, as webpage_getNextWord does
+* Params: the html (doc), its length (len), where to start (at)
+* Returns: the offset of the next letter outside a tag; len if there is none, or if a tag is never closed
+*/
+static size_t skipToLetter(const char* doc, const size_t len, size_t at) {
+#ifdef WORD_SSE2
+    const __m128i bias = _mm_set1_epi8('a' - 128);
+    const __m128i limit = _mm_set1_epi8(26 - 128);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('<');
+#endif
+    while (at < len) {
+#ifdef WORD_SSE2
+        // Jump to the first letter or '<' in each 16 bytes, if there is one
+        if (at + 16 <= len) {
+            __m128i c = _mm_loadu_si128((const __m128i*)&doc[at]);
+            __m128i letter = _mm_cmplt_epi8(_mm_sub_epi8(_mm_or_si128(c, caseBit), bias), limit);
+            int stop = _mm_movemask_epi8(_mm_or_si128(letter, _mm_cmpeq_epi8(c, open)));
+            if (stop == 0) {
+                at += 16;
+                continue;
+            }
+            at += __builtin_ctz(stop);
+        }
+#endif
+        if (isLetter(doc[at])) {
+            return at;
+        }
+        if (doc[at] == '<') {
+            // Skip the tag; memchr is vectorized already
+            const char* end = memchr(&doc[at], '>', len - at);
+            if (end == NULL) {
+                return len;
+            }
+            at = end + 1 - doc;
+        }
+        else {
+            at++;
+        }
+    }
+    return len;
+}
+
+/*
+* foldWord(): Copies the word starting at *at into the scanner, lower-cased, moving *at past it
+* Params: scanner (scan), the html (doc), its length (len), offset of the word's first letter (at)
+* Returns: true if successful, false if out of memory
+*/
+static bool foldWord(wordscan_t* scan, const char* doc, const size_t len, size_t* at) {
+    const size_t beg = *at;
+    size_t end = beg;
+#ifdef WORD_SSE2
+    const __m128i bias = _mm_set1_epi8('a' - 128);
+    const __m128i limit = _mm_set1_epi8(26 - 128);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    while (end + 16 <= len) {
+        // Store all 16 bytes, the letters lower-cased; those past the word are overwritten or cut off after
+        if (!reserveWord(scan, end - beg, end - beg + 16 + 1)) {
+            return false;
+        }
+        __m128i c = _mm_loadu_si128((const __m128i*)&doc[end]);
+        __m128i letter = _mm_cmplt_epi8(_mm_sub_epi8(_mm_or_si128(c, caseBit), bias), limit);
+        _mm_storeu_si128((__m128i*)&scan->word[end - beg], _mm_or_si128(c, _mm_and_si128(letter, caseBit)));
+        int notLetter = ~_mm_movemask_epi8(letter) & 0xffff;
+        if (notLetter != 0) {
+            *at = end + __builtin_ctz(notLetter);
+            return true;
+        }
+        end += 16;
+    }
+#endif
+    // One byte at a time, near the end of the html
+    for ( ; end < len && isLetter(doc[end]); end++) {
+        if (!reserveWord(scan, end - beg, end - beg + 1 + 1)) {
+            return false;
+        }
+        scan->word[end - beg] = doc[end] | 0x20;
+    }
+    *at = end;
+    return true;
+}
+
+/*
+* reserveWord(): Makes room for at least need bytes of word, moving to an allocation once the buffer is too small
+* Params: scanner (scan), bytes of word already copied (used), bytes needed (need)
+* Returns: true if successful, false if out of memory
+*/
+static bool reserveWord(wordscan_t* scan, const size_t used, const size_t need) {
+    if (need <= scan->capacity) {
+        return true;
+    }
+    size_t capacity = 2 * scan->capacity;
+    while (capacity < need) {
+        capacity *= 2;
+    }
+    char* word = mem_malloc(capacity);
+    if (word == NULL) {
+        return false;
+    }
+    memcpy(word, scan->word, used);
+    wordscan_close(scan);
+    scan->word = word;
+    scan->capacity = capacity;
+    return true;
+}
@@ -1,11 +1,37 @@
 /* 
 * word.h - Header file for 'word.c' module.
+*
+* Besides normalizing a word, this module scans the words out of a page's html (see wordscan_next) in one
+* pass, with no allocation: each word is lower-cased as it is found, into a buffer in the scanner, and
+* words shorter than a minimum are passed over without being handed back. On x86 the runs between words,
+* and the words themselves, are scanned 16 bytes at a time with SSE2.
 * @author: Aniket Dey
 */
 
 #ifndef WORD_H
 #define WORD_H
 
+#include <stddef.h>
+
+// Global types
+
+enum { WORDSCAN_BUFFER = 128 }; // bytes of word a scanner holds without allocating
+
+/*
+* A scan over the words of some html. A word is a run of ASCII letters outside any <...> tag, as for
+* webpage_getNextWord. The fields are private; they are here only so a scanner can live on the stack.
+* A scanner points into itself, so it must not be copied once opened.
+*/
+typedef struct wordscan {
+    const char* html; // the html, which need not end in '\0'
+    size_t length; // bytes of html
+    size_t at; // where the scan goes on from
+    int minLength; // words shorter than this are passed over
+    char* word; // the word last found, lower-cased and '\0'-terminated: buffer, or an allocation for a longer word
+    size_t capacity; // bytes at word
+    char buffer[WORDSCAN_BUFFER];
+} wordscan_t;
+
 // Functions
 
 /*
@@ -15,4 +41,27 @@
 */
 void normalizeWord(char* word);
 
-#endif // WORD_H
\ No newline at end of file
+/*
+* wordscan_open(): Starts a scan over the words of some html
+* Params: scanner to start (scan), the html (html), its length in bytes (length),
+*         the fewest letters a word must have to be found (minLength)
+* Returns: void
+*/
+void wordscan_open(wordscan_t* scan, const char* html, const size_t length, const int minLength);
+
+/*
+* wordscan_next(): Finds the next word of at least minLength letters
+* Params: scanner (scan), where to store the word's length (length; may be null)
+* Returns: the word, lower-cased; it belongs to the scanner and lasts until the next call.
+*          Null once there are no more words, or if out of memory
+*/
+const char* wordscan_next(wordscan_t* scan, int* length);
+
+/*
+* wordscan_close(): Ends a scan, freeing anything it allocated for a long word
+* Params: scanner (scan)
+* Returns: void
+*/
+void wordscan_close(wordscan_t* scan);
+
+#endif // WORD_H
@@ -3,24 +3,52 @@
  * @author: Aniket Dey
  */
 
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "hashtable.h"
-#include "hashtable.c"
-#include "hash.h"
-#include "set.h"
+#include <time.h>
+#include <pthread.h>
 #include "mem.h"
 #include "webpage.h"
 #include "unistd.h"
-#include "bag.h"
+#include "dnscache.h"
+#include "fetcher.h"
+#include "frontier.h"
 #include "../common/pagedir.h"
+#include "../common/pagestore.h"
+
+// Local Types
+
+// Everything a fetch worker needs; shared by all workers in a crawl
+typedef struct crawlArgs {
+    frontier_t* frontier; // pages to crawl and URLs seen, shared by all workers
+    pagestore_t* store; // page directory to save pages in
+    int maxDepth; // max crawling depth
+} crawlArgs_t;
+
+// Command-line options, beyond the three required arguments
+typedef struct crawlOptions {
+    int numWorkers; // -t: number of threads fetching with blocking webpage_fetch
+    int numConnections; // -c: fetches kept in flight by one event-driven thread; 0 if not used
+    int delayMs; // -d: least time between fetches from the same host
+    bool segment; // -s: save pages to one segment file plus offset table, not a file per page
+} crawlOptions_t;
+
+// Global Constants
+static const int MAX_WORKERS = 64; // upper bound on the -t option
+static const int MAX_CONNECTIONS = 512; // upper bound on the -c option
+static const int MAX_DELAY = 60000; // upper bound on the -d option
 
 // Function Prototypes
 static void parseArgs(const int argc, char* argv[],
-                      char** seedURL, char** pageDirectory, int* maxDepth);
-static void crawl(char* seedURL, char* pageDirectory, const int maxDepth);
-static void pageScan(webpage_t* page, bag_t* pagesToCrawl, hashtable_t* pagesSeen);
+                      char** seedURL, char** pageDirectory, int* maxDepth, crawlOptions_t* options);
+static void crawl(char* seedURL, char* pageDirectory, const int maxDepth, const crawlOptions_t* options);
+static void* crawlWorker(void* arg);
+static void crawlEvents(crawlArgs_t* args, const int numConnections);
+static void processPage(webpage_t* page, const bool fetched, crawlArgs_t* args);
+static bool worthRetrying(const webpage_t* page);
+static void pageScan(webpage_t* page, frontier_t* frontier);
 
 
 /*
@@ -32,24 +60,77 @@ int main(const int argc, char* argv[]) {
     char* seedURL; // Points to normalized seed URL
     char* pageDirectory; // Points to path for storing
     int maxDepth = 0; // Max crawling depth
+    crawlOptions_t options = { 1, 0, 1000, false }; // One blocking worker, one fetch per host per second, a file per page
 
-    parseArgs(argc, argv, &seedURL, &pageDirectory, &maxDepth);
-    crawl(seedURL, pageDirectory, maxDepth);
+    parseArgs(argc, argv, &seedURL, &pageDirectory, &maxDepth, &options);
+    crawl(seedURL, pageDirectory, maxDepth, &options);
     exit(0); // Successful completion of program
 }
 
 /*
  * parseArgs: Parses and validates command-line arguments
- * Params: argc, argv, seedURL, pageDirectory, maxDepth
+ * Params: argc, argv, seedURL, pageDirectory, maxDepth, options
  * Returns: Only returns if arguments are valid; exits otherwise
  */
 static void parseArgs(const int argc, char* argv[],
-                      char** seedURL, char** pageDirectory, int* maxDepth) {
-    // Check validity of usage - four arguments only
-    if (argc != 4) {
-        fprintf(stderr, "Usage: ./crawler seedURL pageDirectory maxDepth\n");
+                      char** seedURL, char** pageDirectory, int* maxDepth, crawlOptions_t* options) {
+    const char* usage = "Usage: ./crawler [-t numWorkers | -c numConnections] [-d delayMs] [-H hostsFile] [-s] seedURL pageDirectory maxDepth\n";
+    char* endptr;
+    int opt;
+    bool workersGiven = false; // whether -t was given, even as -t 1
+    // Parse options first; -t sets the number of blocking fetch workers,
+    // -c instead fetches from one thread with that many connections in flight,
+    // -d sets the politeness delay between fetches from one host,
+    // -H names a hosts file whose entries override DNS,
+    // and -s saves pages to a segment store rather than one file per page
+    while ((opt = getopt(argc, argv, "t:c:d:H:s")) != -1) {
+        switch (opt) {
+        case 't':
+            options->numWorkers = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || options->numWorkers < 1 || options->numWorkers > MAX_WORKERS) {
+                fprintf(stderr, "numWorkers must be an integer between 1 and %d\n", MAX_WORKERS);
+                exit(1);
+            }
+            workersGiven = true;
+            break;
+        case 'c':
+            options->numConnections = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || options->numConnections < 1 || options->numConnections > MAX_CONNECTIONS) {
+                fprintf(stderr, "numConnections must be an integer between 1 and %d\n", MAX_CONNECTIONS);
+                exit(1);
+            }
+            break;
+        case 'd':
+            options->delayMs = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || options->delayMs < 0 || options->delayMs > MAX_DELAY) {
+                fprintf(stderr, "delayMs must be an integer between 0 and %d\n", MAX_DELAY);
+                exit(1);
+            }
+            break;
+        case 'H':
+            if (!dnscache_loadHosts(optarg)) {
+                fprintf(stderr, "Unable to read hosts file %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 's':
+            options->segment = true;
+            break;
+        default:
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+    }
+    if (workersGiven && options->numConnections > 0) {
+        fprintf(stderr, "-t and -c cannot be used together\n");
+        exit(1);
+    }
+    // Check validity of usage - three positional arguments only
+    if (argc - optind != 3) {
+        fprintf(stderr, "%s", usage);
         exit(1);
     }
+    argv += optind - 1; // So the positional arguments are argv[1..3], as before
     // Normalize the URL; return error if failure 
     char* normURL = normalizeURL(argv[1]); // normalize the URL
     if (normURL == NULL || !isInternalURL(normURL)) {
@@ -68,7 +149,7 @@ static void parseArgs(const int argc, char* argv[],
     // If successful, assign values to pointers
     *seedURL = normURL;
     *pageDirectory = argv[2];
-    char* endptr; // Convert maxDepth to an integer
+    // Convert maxDepth to an integer
     *maxDepth = strtol(argv[3], &endptr, 10);
     if (*endptr != '\0' || *maxDepth < 0 || *maxDepth > 10) { // If maxDepth is not an integer between 0-10, return an error
         fprintf(stderr, "maxDepth must be an integer between 0 and 10\n"); 
@@ -78,76 +159,174 @@ static void parseArgs(const int argc, char* argv[],
 }
 
 /*
- * crawl: Manages the crawling process
- * Params: seedURL (start URL), pageDirectory (directory to write to), maxDepth (to crawl)
+ * crawl: Manages the crawling process, sharing the frontier among the fetch workers,
+ *        or feeding it to the event-driven fetcher
+ * Params: seedURL (start URL), pageDirectory (directory to write to), maxDepth (to crawl), options
  * Returns: None, exits if error
  */
-static void crawl(char* seedURL, char* pageDirectory, const int maxDepth) {
-    hashtable_t *seen = hashtable_new(200); // Hashtable to keep track of seen pages
-    bag_t *pagesToCheck = bag_new();  // Bag to manage pages to crawl
-    // Check if the hashtable and bag were created successfully
-    if (seen == NULL || pagesToCheck == NULL) { 
+static void crawl(char* seedURL, char* pageDirectory, const int maxDepth, const crawlOptions_t* options) {
+    frontier_t* frontier = frontier_new(200, options->delayMs); // Pages to crawl, plus the set of seen URLs
+    if (frontier == NULL) {
         fprintf(stderr, "Failed to create data structures for crawling\n");
         exit(1);
     }
-    // Insert seed URL into hashtable to mark as seen
-    if (!hashtable_insert(seen, seedURL, "")) {
+    // Insert seed URL into the seen-set
+    if (!frontier_markSeen(frontier, seedURL)) {
         fprintf(stderr, "Failed to insert seed URL into hashtable\n");
-        bag_delete(pagesToCheck, webpage_delete); // Clean up the bag & hashtable
-        hashtable_delete(seen, NULL);
+        frontier_delete(frontier);
         exit(1);
     }
     // Create a webpage for the seed URL; depth starts at 0
     webpage_t* seedPage = webpage_new(seedURL, 0, NULL);
-    if (seedPage == NULL) { // If the webpage ceration fails, clena up bag and hashtable
+    if (seedPage == NULL) { // If the webpage creation fails, clean up the frontier
         fprintf(stderr, "Failed to create webpage for seed URL\n");
-        bag_delete(pagesToCheck, webpage_delete);
-        hashtable_delete(seen, NULL);
+        frontier_delete(frontier);
         exit(1);
     }
+    frontier_insert(frontier, seedPage); // Insert seed webpage into the frontier to crawl
 
-    
-    bag_insert(pagesToCheck, seedPage); // Insert seed webpage into the bag to crawl
-    int docID = 1;
+    pagestore_t* store = pagestore_create(pageDirectory, options->segment ? PAGEDIR_SEGMENT : PAGEDIR_FILES);
+    if (store == NULL) {
+        fprintf(stderr, "Failed to create page store in %s\n", pageDirectory);
+        frontier_delete(frontier);
+        exit(1);
+    }
+
+    crawlArgs_t args = { frontier, store, maxDepth };
+    if (options->numConnections > 0) {
+        crawlEvents(&args, options->numConnections);
+        dnscache_flush(); // Free the cached host lookups
+        pagestore_close(store);
+        frontier_delete(frontier);
+        return;
+    }
+
+    // Start the extra workers; this thread is always worker 0
+    const int numWorkers = options->numWorkers;
+    pthread_t* workers = mem_malloc_assert(numWorkers * sizeof(pthread_t), "workers");
+    int started = 1;
+    for (; started < numWorkers; started++) {
+        if (pthread_create(&workers[started], NULL, crawlWorker, &args) != 0) {
+            fprintf(stderr, "Could only start %d of %d workers\n", started, numWorkers);
+            break;
+        }
+    }
+    crawlWorker(&args);
+    for (int i = 1; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    mem_free(workers);
+    webpage_closeConnections(); // Close the connections kept open between fetches
+    dnscache_flush(); // Free the cached host lookups
+    pagestore_close(store); // Close the page store, so everything saved is on disk
+    frontier_delete(frontier); // Clean the frontier and its seen-set
+}
+
+/*
+ * crawlWorker: Fetches, saves, and scans pages from the frontier until the crawl is over
+ * Params: pointer to the crawl's shared crawlArgs_t (arg)
+ * Returns: null; exits if a page cannot be saved
+ */
+static void* crawlWorker(void* arg) {
+    crawlArgs_t* args = arg;
     webpage_t* page; // Variable to hold current webpage
 
     // Loops until there are no more pages to check
-    while ((page = bag_extract(pagesToCheck)) != NULL) {
+    while ((page = frontier_extract(args->frontier)) != NULL) {
         // Log fetched page with depth and URL
         printf("%d   Fetched: %s\n", webpage_getDepth(page), webpage_getURL(page));
+        bool fetched = webpage_fetch(page); // Attempt to fetch the content
+        processPage(page, fetched, args);
+    }
+    return NULL;
+}
 
-        // Attempt to fetch the content
-        if (webpage_fetch(page)) {
-            printf("%d  Scanning: %s\n", webpage_getDepth(page), webpage_getURL(page)); // Log the page being scanned
-            if (!pagedir_save(page, pageDirectory, docID)) { // Save the fetched page to the page directory
-                fprintf(stderr, "Failed to save page with docID %d\n", docID);
-                webpage_delete(page); // Clean up the current page, bag, and hashtable before exiting
-                bag_delete(pagesToCheck, webpage_delete);
-                hashtable_delete(seen, NULL);
-                exit(1);
-            }
-            docID++; // If successfully svaed, increment document ID
-            if (webpage_getDepth(page) < maxDepth) { // If the depth is less than maxDepth, for new URLs
-                pageScan(page, pagesToCheck, seen);
+/*
+ * crawlEvents: Crawls from this one thread, keeping up to numConnections fetches in flight
+ * Params: the crawl's crawlArgs_t (args), most fetches to have in progress at once (numConnections)
+ * Returns: None; exits if the fetcher cannot be created or a page cannot be saved
+ */
+static void crawlEvents(crawlArgs_t* args, const int numConnections) {
+    fetcher_t* fetcher = fetcher_new(numConnections);
+    if (fetcher == NULL) {
+        fprintf(stderr, "Failed to create fetcher\n");
+        exit(1);
+    }
+    webpage_t* page;
+    bool fetched;
+    while (true) {
+        // Top up the fetcher from the frontier
+        while (fetcher_inFlight(fetcher) < numConnections
+               && (page = frontier_tryExtract(args->frontier)) != NULL) {
+            printf("%d   Fetched: %s\n", webpage_getDepth(page), webpage_getURL(page));
+            fetcher_submit(fetcher, page);
+        }
+        // Wait for a fetch to finish, but no longer than until the frontier has a page ready
+        // for a free connection (it may be held back by its host's politeness delay)
+        int waitMs = (fetcher_inFlight(fetcher) < numConnections) ? frontier_waitTime(args->frontier) : -1;
+        if (fetcher_inFlight(fetcher) == 0) {
+            if (waitMs < 0) {
+                break; // Nothing in flight, and nothing left to fetch
             }
-        } 
-        else {
-            fprintf(stderr, "Failed to fetch %s\n", webpage_getURL(page));// If fetching page fails, log error 
+            struct timespec pause = { waitMs / 1000, (waitMs % 1000) * 1000000L };
+            nanosleep(&pause, NULL);
+        }
+        else if ((page = fetcher_next(fetcher, waitMs, &fetched)) != NULL) {
+            processPage(page, fetched, args);
         }
-        webpage_delete(page); // Free memory
     }
-    // Clean the bag and hashtable
-    bag_delete(pagesToCheck, webpage_delete); 
-    hashtable_delete(seen, NULL); 
+    fetcher_delete(fetcher);
+}
+
+/*
+ * processPage: Saves and scans a page that was just fetched, then frees it; a page that failed in a way
+ *              that may pass (see worthRetrying) is put back to be retried, and one that failed otherwise,
+ *              or too often, is logged and freed
+ * Params: page, whether its fetch succeeded (fetched), the crawl's crawlArgs_t (args)
+ * Returns: None; exits if the page cannot be saved
+ */
+static void processPage(webpage_t* page, const bool fetched, crawlArgs_t* args) {
+    if (fetched) {
+        printf("%d  Scanning: %s\n", webpage_getDepth(page), webpage_getURL(page)); // Log the page being scanned
+        // docIDs are only handed out for pages we fetched, so they stay dense
+        int docID = frontier_nextDocID(args->frontier);
+        if (!pagestore_save(args->store, page, docID)) { // Save the fetched page to the page directory
+            fprintf(stderr, "Failed to save page with docID %d\n", docID);
+            exit(1);
+        }
+        if (webpage_getDepth(page) < args->maxDepth) { // If the depth is less than maxDepth, for new URLs
+            pageScan(page, args->frontier);
+        }
+    } 
+    else if (worthRetrying(page) && frontier_retry(args->frontier, page)) {
+        page = NULL; // The frontier will hand it out again once its backoff has passed
+    }
+    else {
+        fprintf(stderr, "Failed to fetch %s\n", webpage_getURL(page));// If fetching page fails, log error 
+    }
+    webpage_delete(page); // Free memory
+    frontier_done(args->frontier); // Only now may other workers conclude the crawl is over
+}
+
+/*
+ * worthRetrying: Tells whether a failed fetch may succeed if tried again: it failed in transport, with no
+ *                whole response, or the server answered that it is busy (429) or failed itself (5xx).
+ *                Any other answer, such as 404, will be the same next time
+ * Params: page whose fetch failed
+ * Returns: true if the page should be retried
+ */
+static bool worthRetrying(const webpage_t* page) {
+    int status = webpage_getStatus(page);
+    return status == 0 || status == 429 || status >= 500;
 }
 
 
 /*
- * pageScan: Extracts URLs from a webpage and adds new internal URLs to the bag
- * Params: page - current web page to crawl, pagesToCrawl - bag of pages to crawls, pagesSeen - hashtable of seen URLs
+ * pageScan: Extracts URLs from a webpage and adds new internal URLs to the frontier
+ * Params: page - current web page to crawl, frontier - pages to crawl and URLs seen
  * Returns: None
  */
-static void pageScan(webpage_t* page, bag_t* pagesToCrawl, hashtable_t* pagesSeen) {
+static void pageScan(webpage_t* page, frontier_t* frontier) {
     int position = 0; // Tracks position for extraction
     char* url; // Pointer to hold extracted 
     
@@ -157,13 +336,16 @@ static void pageScan(webpage_t* page, bag_t* pagesToCrawl, hashtable_t* pagesSee
         mem_free(url); // Free memory for the old URL
 
         if (normalizedURL && isInternalURL(normalizedURL)) { // Check validity of the the URL
-            if (hashtable_insert(pagesSeen, normalizedURL, "")) {  //Insert into the hastable; if succesful print "found" and "added" messages
+            if (frontier_markSeen(frontier, normalizedURL)) {  //Insert into the seen-set; if succesful print "found" and "added" messages
                 printf("%d     Found: %s\n", webpage_getDepth(page), normalizedURL);
                 printf("%d     Added: %s\n", webpage_getDepth(page), normalizedURL);
 
                 webpage_t* newPage = webpage_new(normalizedURL, webpage_getDepth(page) + 1, NULL);
                 if (newPage != NULL) {
-                    bag_insert(pagesToCrawl, newPage); // Insert a new webPage into teh document to check and crawl later
+                    if (!frontier_insert(frontier, newPage)) { // Insert a new webPage into the frontier to crawl later
+                        fprintf(stderr, "Failed to queue URL: %s\n", normalizedURL);
+                        webpage_delete(newPage); // Also frees normalizedURL
+                    }
                 } 
                 else { 
                     fprintf(stderr, "Failed to create webpage for URL: %s\n", normalizedURL); // IF failure, print an error message and free memory
@@ -0,0 +1,72 @@
+/*
+* fetchtest.c - Test program for the event-driven fetcher: fetches every URL
+*               given, all at once, and reports each as it completes.
+* @author: Aniket Dey
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fetcher.h"
+#include "webpage.h"
+
+/*
+* main(): Validates arguments, submits each URL to a fetcher, and prints the results
+* Params: number of command-line arguments (argc), array of command-line arguments (argv)
+* Returns: 0 if every URL was fetched, 1 if any argument is bad or any fetch failed
+*/
+int main(int argc, char* argv[]) {
+    // Check for correct number of arguments, correct usage if incorrect or none
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s maxInFlight URL...\n", argv[0]);
+        return 1;
+    }
+    char* endptr;
+    int maxInFlight = strtol(argv[1], &endptr, 10);
+    if (*endptr != '\0' || maxInFlight < 1) {
+        fprintf(stderr, "Error: maxInFlight must be a positive integer\n");
+        return 1;
+    }
+
+    fetcher_t* fetcher = fetcher_new(maxInFlight);
+    if (fetcher == NULL) {
+        fprintf(stderr, "Error: failed to create fetcher\n");
+        return 1;
+    }
+
+    int next = 2; // Next argument to submit
+    int failures = 0;
+    webpage_t* page;
+    bool fetched;
+    do {
+        // Keep the fetcher as full as it will take
+        while (next < argc && fetcher_inFlight(fetcher) < maxInFlight) {
+            char* url = malloc(strlen(argv[next]) + 1); // webpage_delete frees it with free
+            if (url == NULL) {
+                fprintf(stderr, "Error: out of memory\n");
+                return 1;
+            }
+            strcpy(url, argv[next++]);
+            page = webpage_new(url, 0, NULL);
+            if (page == NULL || !fetcher_submit(fetcher, page)) {
+                fprintf(stderr, "Error: failed to submit %s\n", url);
+                webpage_delete(page);
+                failures++;
+            }
+        }
+        // Report the next fetch to finish, in whatever order they do
+        if ((page = fetcher_next(fetcher, -1, &fetched)) != NULL) {
+            if (fetched) {
+                printf("ok %s (%zu bytes)\n", webpage_getURL(page), strlen(webpage_getHTML(page)));
+            } else {
+                printf("failed %s (status %d)\n", webpage_getURL(page), webpage_getStatus(page));
+                failures++;
+            }
+            webpage_delete(page);
+        }
+    } while (page != NULL || next < argc);
+
+    // Clean up and exit
+    fetcher_delete(fetcher);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,453 @@
+/*
+ * frontier.c - Module for the crawler's shared frontier. See frontier.h for more info.
+ * @author: Aniket Dey
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "frontier.h"
+#include "bag.h"
+#include "hashtable.h"
+#include "strtable.h"
+#include "mem.h"
+#include "webpage.h"
+
+// Local types
+
+// A failed page waiting to be fetched again
+typedef struct retry {
+    webpage_t* page;
+    long long readyAt; // not to be fetched before this time (ms)
+    struct retry* next; // list is kept in order of readyAt
+} retry_t;
+
+// The pages waiting for one host, and when that host may next be fetched from
+typedef struct host {
+    bag_t* pages; // new pages for this host
+    int numPages; // number of pages in the bag
+    retry_t* retries; // failed pages for this host, earliest first
+    long long nextReady; // no fetch from this host may start before this time (ms)
+} host_t;
+
+typedef struct frontier {
+    hashtable_t* hostTable; // "hostname:port" -> host_t*
+    host_t** hosts; // every host seen, for scanning; grows by doubling
+    int numHosts, maxHosts;
+    int nextHost; // where the next scan of hosts starts, so hosts take turns
+    int waiting; // number of pages in all hosts' queues
+    strtable_t* seen; // URLs already seen (keys only; items are "")
+    hashtable_t* failures; // URL -> int* count of failed fetches, for pages that have failed
+    int delayMs; // least time between fetches from one host
+    int busy; // number of extracted pages not yet marked done
+    int nextDocID; // next docID to hand out
+    pthread_mutex_t lock; // guards all of the above
+    pthread_cond_t changed; // signalled when a page is inserted or the crawl may be over
+} frontier_t;
+
+// Global Constants
+static const int HOST_SLOTS = 31; // slots in the host hashtable
+static const int MAX_RETRIES = 2; // fetches of a page after its first fails
+static const int RETRY_BASE_MS = 1000; // wait before the first retry; doubles for each one after
+static const long long NEVER = -1; // no page is waiting
+#define MAX_HOSTNAME 253 // longest DNS name; sizes the host key buffer
+
+// Function Prototypes
+static long long nowMs(void);
+static host_t* findHost(frontier_t* frontier, webpage_t* page);
+static webpage_t* takeReady(frontier_t* frontier, const long long now, long long* wakeAt);
+static long long readyAt(const host_t* host, const long long now);
+static void deleteHost(void* item);
+static void freeItem(void* item);
+
+/*
+ * frontier_new: Creates a new, empty frontier
+ * Params: number of URLs expected to be seen (seenSlots); the seen-set grows past it as needed,
+ *         least time in milliseconds between fetches from the same host (delayMs)
+ * Returns: pointer to new frontier, or null on error
+ */
+frontier_t* frontier_new(const int seenSlots, const int delayMs) {
+    frontier_t* frontier = mem_calloc(1, sizeof(frontier_t));
+    if (frontier == NULL) {
+        return NULL;
+    }
+    frontier->hostTable = hashtable_new(HOST_SLOTS);
+    frontier->seen = strtable_new(seenSlots);
+    frontier->failures = hashtable_new(HOST_SLOTS);
+    if (frontier->hostTable == NULL || frontier->seen == NULL || frontier->failures == NULL) {
+        hashtable_delete(frontier->hostTable, NULL); // Any may be null; deletes ignore null
+        strtable_delete(frontier->seen, NULL);
+        hashtable_delete(frontier->failures, NULL);
+        mem_free(frontier);
+        return NULL;
+    }
+    frontier->delayMs = delayMs > 0 ? delayMs : 0;
+    frontier->nextDocID = 1;
+    pthread_mutex_init(&frontier->lock, NULL);
+    // Timed waits are measured on the same monotonic clock as the host delays
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&frontier->changed, &attr);
+    pthread_condattr_destroy(&attr);
+    return frontier;
+}
+
+/*
+ * frontier_markSeen: Records a URL as seen, if it has not been seen before
+ * Params: frontier, normalized URL (url); the frontier keeps its own copy
+ * Returns: true if the URL is new, false if already seen or on error
+ */
+bool frontier_markSeen(frontier_t* frontier, const char* url) {
+    if (frontier == NULL || url == NULL) {
+        return false;
+    }
+    // Check-and-insert must be one step, so two workers can't both claim a URL
+    pthread_mutex_lock(&frontier->lock);
+    bool added = strtable_insert(frontier->seen, url, "");
+    pthread_mutex_unlock(&frontier->lock);
+    return added;
+}
+
+/*
+ * frontier_insert: Adds a page to be crawled, and wakes one waiting worker
+ * Params: frontier, page to crawl (the frontier takes ownership)
+ * Returns: true if successful, false on error
+ */
+bool frontier_insert(frontier_t* frontier, webpage_t* page) {
+    if (frontier == NULL || page == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    host_t* host = findHost(frontier, page);
+    if (host != NULL) {
+        bag_insert(host->pages, page);
+        host->numPages++;
+        frontier->waiting++;
+        pthread_cond_signal(&frontier->changed);
+    }
+    pthread_mutex_unlock(&frontier->lock);
+    return host != NULL;
+}
+
+/*
+ * frontier_retry: Puts back a page whose fetch failed, to be tried again after a backoff
+ * Params: frontier, page that failed (the frontier takes ownership only if it returns true)
+ * Returns: true if the page will be retried; false if it has failed too often, or on error
+ */
+bool frontier_retry(frontier_t* frontier, webpage_t* page) {
+    if (frontier == NULL || page == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    bool retried = false;
+    int* count = hashtable_find(frontier->failures, webpage_getURL(page));
+    if (count == NULL && (count = mem_calloc(1, sizeof(int))) != NULL
+        && !hashtable_insert(frontier->failures, webpage_getURL(page), count)) {
+        mem_free(count);
+        count = NULL;
+    }
+    host_t* host = findHost(frontier, page);
+    retry_t* retry;
+    if (count != NULL && host != NULL && ++*count <= MAX_RETRIES
+        && (retry = mem_malloc(sizeof(retry_t))) != NULL) {
+        // Back off for this page alone; other pages, and other hosts, carry on meanwhile
+        retry->page = page;
+        retry->readyAt = nowMs() + ((long long)RETRY_BASE_MS << (*count - 1));
+        retry_t** prev = &host->retries;
+        while (*prev != NULL && (*prev)->readyAt <= retry->readyAt) {
+            prev = &(*prev)->next;
+        }
+        retry->next = *prev;
+        *prev = retry;
+        frontier->waiting++;
+        pthread_cond_signal(&frontier->changed);
+        retried = true;
+    }
+    pthread_mutex_unlock(&frontier->lock);
+    return retried;
+}
+
+/*
+ * frontier_extract: Takes the next page to crawl, waiting until one is ready
+ * Params: frontier
+ * Returns: a page, now owned by the caller, who must later call frontier_done;
+ *          null once the frontier is empty and no other worker is busy
+ */
+webpage_t* frontier_extract(frontier_t* frontier) {
+    if (frontier == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    webpage_t* page;
+    long long wakeAt;
+    // An empty frontier only means the crawl is over once nobody can refill it
+    while ((page = takeReady(frontier, nowMs(), &wakeAt)) == NULL
+           && (wakeAt != NEVER || frontier->busy > 0)) {
+        if (wakeAt == NEVER) {
+            pthread_cond_wait(&frontier->changed, &frontier->lock);
+        }
+        else {
+            // Pages are waiting on their hosts' delays; sleep until the first is due
+            struct timespec until = { wakeAt / 1000, (wakeAt % 1000) * 1000000 };
+            pthread_cond_timedwait(&frontier->changed, &frontier->lock, &until);
+        }
+    }
+    if (page != NULL) {
+        frontier->busy++;
+    }
+    else {
+        pthread_cond_broadcast(&frontier->changed); // Let any other waiters see the end too
+    }
+    pthread_mutex_unlock(&frontier->lock);
+    return page;
+}
+
+/*
+ * frontier_tryExtract: Takes the next page to crawl, if one is ready now
+ * Params: frontier
+ * Returns: a page, now owned by the caller, who must later call frontier_done;
+ *          null if no page is ready at the moment
+ */
+webpage_t* frontier_tryExtract(frontier_t* frontier) {
+    if (frontier == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    long long wakeAt;
+    webpage_t* page = takeReady(frontier, nowMs(), &wakeAt);
+    if (page != NULL) {
+        frontier->busy++;
+    }
+    pthread_mutex_unlock(&frontier->lock);
+    return page;
+}
+
+/*
+ * frontier_waitTime: Tells how long until frontier_tryExtract could next return a page
+ * Params: frontier
+ * Returns: milliseconds until a waiting page is ready (0 if one is ready now);
+ *          -1 if no page is waiting at all
+ */
+int frontier_waitTime(frontier_t* frontier) {
+    if (frontier == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    long long now = nowMs();
+    long long wakeAt = NEVER;
+    for (int i = 0; i < frontier->numHosts; i++) {
+        long long at = readyAt(frontier->hosts[i], now);
+        if (at != NEVER && (wakeAt == NEVER || at < wakeAt)) {
+            wakeAt = at;
+        }
+    }
+    pthread_mutex_unlock(&frontier->lock);
+    if (wakeAt == NEVER) {
+        return -1;
+    }
+    return wakeAt > now ? (int)(wakeAt - now) : 0;
+}
+
+/*
+ * frontier_done: Reports that the caller has finished with an extracted page
+ * Params: frontier
+ * Returns: None
+ */
+void frontier_done(frontier_t* frontier) {
+    if (frontier == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    if (--frontier->busy == 0) {
+        pthread_cond_broadcast(&frontier->changed); // Waiters may now find the crawl finished
+    }
+    pthread_mutex_unlock(&frontier->lock);
+}
+
+/*
+ * frontier_nextDocID: Reserves the next unique document ID
+ * Params: frontier
+ * Returns: a docID, starting from 1 and never handed out twice
+ */
+int frontier_nextDocID(frontier_t* frontier) {
+    if (frontier == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&frontier->lock);
+    int docID = frontier->nextDocID++;
+    pthread_mutex_unlock(&frontier->lock);
+    return docID;
+}
+
+/*
+ * frontier_delete: Frees the frontier, its seen-set, and any pages left in it
+ * Params: frontier
+ * Returns: None
+ */
+void frontier_delete(frontier_t* frontier) {
+    if (frontier != NULL) {
+        hashtable_delete(frontier->hostTable, deleteHost);
+        free(frontier->hosts); // Grown with realloc
+        strtable_delete(frontier->seen, NULL);
+        hashtable_delete(frontier->failures, freeItem);
+        pthread_mutex_destroy(&frontier->lock);
+        pthread_cond_destroy(&frontier->changed);
+        mem_free(frontier);
+    }
+}
+
+/*
+ * nowMs: Reads the monotonic clock
+ * Params: None
+ * Returns: the time in milliseconds
+ */
+static long long nowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * findHost: Finds the host a page's URL names, adding it if it is new; caller holds the lock
+ * Params: frontier, page
+ * Returns: the page's host, or null if its URL cannot be parsed or on error
+ */
+static host_t* findHost(frontier_t* frontier, webpage_t* page) {
+    char* hostname;
+    char* pathname;
+    int port;
+    if (!burstURL(webpage_getURL(page), &hostname, &port, &pathname)) {
+        return NULL;
+    }
+    // No host has a longer name, and the key must fit its fixed buffer
+    char key[MAX_HOSTNAME + 16];
+    bool valid = strlen(hostname) <= MAX_HOSTNAME;
+    if (valid) {
+        sprintf(key, "%s:%d", hostname, port);
+    }
+    free(hostname);
+    free(pathname);
+    if (!valid) {
+        return NULL;
+    }
+
+    host_t* host = hashtable_find(frontier->hostTable, key);
+    if (host != NULL) {
+        return host;
+    }
+    // Grow the array of hosts by doubling
+    if (frontier->numHosts == frontier->maxHosts) {
+        int maxHosts = frontier->maxHosts > 0 ? 2 * frontier->maxHosts : 8;
+        host_t** hosts = realloc(frontier->hosts, maxHosts * sizeof(host_t*));
+        if (hosts == NULL) {
+            return NULL;
+        }
+        frontier->hosts = hosts;
+        frontier->maxHosts = maxHosts;
+    }
+    if ((host = mem_calloc(1, sizeof(host_t))) == NULL || (host->pages = bag_new()) == NULL) {
+        mem_free(host);
+        return NULL;
+    }
+    if (!hashtable_insert(frontier->hostTable, key, host)) {
+        deleteHost(host);
+        return NULL;
+    }
+    frontier->hosts[frontier->numHosts++] = host;
+    return host;
+}
+
+/*
+ * readyAt: Finds when a host next has a page that may be fetched; caller holds the lock
+ * Params: host, current time (now)
+ * Returns: that time in milliseconds, or NEVER if the host has no pages waiting
+ */
+static long long readyAt(const host_t* host, const long long now) {
+    long long at;
+    if (host->numPages > 0) {
+        at = now;
+    }
+    else if (host->retries != NULL) {
+        at = host->retries->readyAt;
+    }
+    else {
+        return NEVER;
+    }
+    return at > host->nextReady ? at : host->nextReady;
+}
+
+/*
+ * takeReady: Takes a page from the next host that may be fetched from now; caller holds the lock
+ * Params: frontier, current time (now), where to store when the next page will be ready (wakeAt)
+ * Returns: a page, or null if none is ready now (with *wakeAt set, or NEVER if none is waiting)
+ */
+static webpage_t* takeReady(frontier_t* frontier, const long long now, long long* wakeAt) {
+    *wakeAt = NEVER;
+    if (frontier->waiting == 0) {
+        return NULL;
+    }
+    // Start each scan just past the host chosen last time, so hosts take turns
+    for (int n = 0; n < frontier->numHosts; n++) {
+        int i = (frontier->nextHost + n) % frontier->numHosts;
+        host_t* host = frontier->hosts[i];
+        long long at = readyAt(host, now);
+        if (at == NEVER) {
+            continue;
+        }
+        if (at > now) {
+            if (*wakeAt == NEVER || at < *wakeAt) {
+                *wakeAt = at;
+            }
+            continue;
+        }
+        // Due retries go first, since they have waited longest
+        webpage_t* page;
+        if (host->retries != NULL && host->retries->readyAt <= now) {
+            retry_t* retry = host->retries;
+            host->retries = retry->next;
+            page = retry->page;
+            mem_free(retry);
+        }
+        else {
+            page = bag_extract(host->pages);
+            host->numPages--;
+        }
+        host->nextReady = now + frontier->delayMs;
+        frontier->nextHost = (i + 1) % frontier->numHosts;
+        frontier->waiting--;
+        return page;
+    }
+    return NULL;
+}
+
+/*
+ * deleteHost: Frees a host and any pages still waiting for it
+ * Params: host (as void*, for hashtable_delete)
+ * Returns: None
+ */
+static void deleteHost(void* item) {
+    host_t* host = item;
+    if (host != NULL) {
+        bag_delete(host->pages, webpage_delete);
+        while (host->retries != NULL) {
+            retry_t* retry = host->retries;
+            host->retries = retry->next;
+            webpage_delete(retry->page);
+            mem_free(retry);
+        }
+        mem_free(host);
+    }
+}
+
+/*
+ * freeItem: Frees a hashtable item allocated with mem_malloc
+ * Params: item
+ * Returns: None
+ */
+static void freeItem(void* item) {
+    mem_free(item);
+}
@@ -0,0 +1,106 @@
+/*
+ * frontier.h - Header file for the crawler's shared frontier module
+ *
+ * A frontier holds the pages still waiting to be crawled, together with the
+ * set of URLs the crawl has already seen. It is safe for use by several fetch
+ * workers at once: every operation takes the frontier's lock, and
+ * frontier_extract blocks until a page is available or the crawl is over.
+ *
+ * The frontier is also the crawl's politeness scheduler. Pages wait in one
+ * queue per host (hostname and port), and a page is only handed out once its
+ * host's delay has passed since the last fetch from that host began; pages for
+ * other hosts proceed meanwhile. A page whose fetch failed may be put back with
+ * frontier_retry, to be tried again after a backoff that only it waits for.
+ *
+ * The crawl is over when the frontier is empty and no worker is still busy
+ * with a page it extracted (since a busy worker may yet add new pages).
+ * @author: Aniket Dey
+ */
+
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <stdbool.h>
+#include "webpage.h"
+
+// Global types
+typedef struct frontier frontier_t;
+
+// Functions
+
+/*
+ * frontier_new: Creates a new, empty frontier
+ * Params: number of URLs expected to be seen (seenSlots); the seen-set grows past it as needed,
+ *         least time in milliseconds between fetches from the same host (delayMs)
+ * Returns: pointer to new frontier, or null on error
+ */
+frontier_t* frontier_new(const int seenSlots, const int delayMs);
+
+/*
+ * frontier_markSeen: Records a URL as seen, if it has not been seen before
+ * Params: frontier, normalized URL (url); the frontier keeps its own copy
+ * Returns: true if the URL is new, false if already seen or on error
+ */
+bool frontier_markSeen(frontier_t* frontier, const char* url);
+
+/*
+ * frontier_insert: Adds a page to be crawled, and wakes one waiting worker
+ * Params: frontier, page to crawl (the frontier takes ownership)
+ * Returns: true if successful, false on error
+ */
+bool frontier_insert(frontier_t* frontier, webpage_t* page);
+
+/*
+ * frontier_retry: Puts back a page whose fetch failed, to be tried again after a backoff
+ * Params: frontier, page that failed (the frontier takes ownership only if it returns true)
+ * Returns: true if the page will be retried; false if it has failed too often, or on error
+ */
+bool frontier_retry(frontier_t* frontier, webpage_t* page);
+
+/*
+ * frontier_extract: Takes the next page to crawl, waiting until one is ready
+ * Params: frontier
+ * Returns: a page, now owned by the caller, who must later call frontier_done;
+ *          null once the frontier is empty and no other worker is busy
+ */
+webpage_t* frontier_extract(frontier_t* frontier);
+
+/*
+ * frontier_tryExtract: Takes the next page to crawl, if one is ready now
+ * Params: frontier
+ * Returns: a page, now owned by the caller, who must later call frontier_done;
+ *          null if no page is ready at the moment
+ */
+webpage_t* frontier_tryExtract(frontier_t* frontier);
+
+/*
+ * frontier_waitTime: Tells how long until frontier_tryExtract could next return a page
+ * Params: frontier
+ * Returns: milliseconds until a waiting page is ready (0 if one is ready now);
+ *          -1 if no page is waiting at all
+ */
+int frontier_waitTime(frontier_t* frontier);
+
+/*
+ * frontier_done: Reports that the caller has finished with an extracted page,
+ *                after inserting any new pages found on it
+ * Params: frontier
+ * Returns: None
+ */
+void frontier_done(frontier_t* frontier);
+
+/*
+ * frontier_nextDocID: Reserves the next unique document ID
+ * Params: frontier
+ * Returns: a docID, starting from 1 and never handed out twice
+ */
+int frontier_nextDocID(frontier_t* frontier);
+
+/*
+ * frontier_delete: Frees the frontier, its seen-set, and any pages left in it
+ * Params: frontier
+ * Returns: None
+ */
+void frontier_delete(frontier_t* frontier);
+
+#endif // FRONTIER_H
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# stubserver.py - A small local HTTP/1.1 server standing in for cs50tse.cs.dartmouth.edu in testing.sh
+# @author: Aniket Dey
+#
+# Usage: python3 stubserver.py portFile logFile
+#   Listens on 127.0.0.1, on a port the system chooses, and writes that port to portFile once it is
+#   listening. Each request is logged to logFile as "connection N GET path", numbering connections in
+#   the order they were accepted, so a test can tell whether connections were kept alive and reused.
+# Usage: python3 stubserver.py --print URL
+#   Prints the body the server sends for URL's path, so a test can compare a saved page with it.
+#
+# The pages, all under /tse/stub/, cover each way a response may come:
+#   index.html, one.html, four.html    Content-Length (four.html is big, to come in many reads)
+#   two.html, three.html               chunked transfer encoding, in small chunks
+#   missing.html, and any other path   404 Not Found
+#   busy.html                          503 Service Unavailable, every time
+# Connections are kept alive unless the client asks to close them.
+
+import http.server
+import itertools
+import os
+import socketserver
+import sys
+import threading
+from urllib.parse import urlsplit
+
+PREFIX = "/tse/stub/"
+CHUNK = 100  # bytes in each chunk of a chunked response
+
+# page name -> (links, words, chunked)
+PAGES = {
+    "index.html": (["one.html", "two.html", "missing.html"], "home page of the stub server", False),
+    "one.html": (["two.html", "three.html", "index.html"], "first page sent with a length", False),
+    "two.html": (["three.html"], "second page sent in chunks", True),
+    "three.html": (["four.html", "https://en.wikipedia.org/wiki/Algorithm"], "third page in chunks", True),
+    "four.html": ([], "fourth page big enough for many reads " * 2000, False),
+}
+
+
+def body(path):
+    """Return the body of the page at path, or None if there is none."""
+    if not path.startswith(PREFIX) or path[len(PREFIX):] not in PAGES:
+        return None
+    name = path[len(PREFIX):]
+    links, words, _ = PAGES[name]
+    anchors = " ".join(f'<a href="{link}">{link}</a>' for link in links)
+    return f"<html><title>{name}</title>{words} {anchors}</html>\n".encode()
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # keep connections alive
+
+    def setup(self):
+        super().setup()
+        self.connection_number = next(self.server.connections)
+
+    def log_message(self, format, *args):
+        pass  # requests are logged to the log file instead
+
+    def do_GET(self):
+        with self.server.lock:
+            self.server.log.write(f"connection {self.connection_number} GET {self.path}\n")
+            self.server.log.flush()
+        if self.path == PREFIX + "busy.html":
+            self.send_empty(503)
+            return
+        page = body(self.path)
+        if page is None:
+            self.send_empty(404)
+            return
+        self.send_response(200)
+        self.send_header("Content-Type", "text/html")
+        if PAGES[self.path[len(PREFIX):]][2]:
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            for at in range(0, len(page), CHUNK):
+                chunk = page[at:at + CHUNK]
+                self.wfile.write(b"%x\r\n" % len(chunk) + chunk + b"\r\n")
+            self.wfile.write(b"0\r\n\r\n")
+        else:
+            self.send_header("Content-Length", str(len(page)))
+            self.end_headers()
+            self.wfile.write(page)
+
+    def send_empty(self, code):
+        self.send_response(code)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == "--print":
+        page = body(urlsplit(sys.argv[2]).path)
+        if page is None:
+            sys.exit(1)
+        sys.stdout.buffer.write(page)
+        return
+    if len(sys.argv) != 3:
+        sys.stderr.write("Usage: python3 stubserver.py portFile logFile | --print URL\n")
+        sys.exit(1)
+
+    server = Server(("127.0.0.1", 0), Handler)
+    server.connections = itertools.count(1)
+    server.lock = threading.Lock()
+    server.log = open(sys.argv[2], "w")
+    # Written whole, by renaming, so a reader never sees part of the port
+    with open(sys.argv[1] + ".new", "w") as portFile:
+        portFile.write(f"{server.server_address[1]}\n")
+    os.rename(sys.argv[1] + ".new", sys.argv[1])
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
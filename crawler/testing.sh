@@ -75,6 +75,144 @@ mkdir -p ../data/wikipedia-1
 ./crawler http://cs50tse.cs.dartmouth.edu/tse/wikipedia/ ../data/wikipedia-1 1
 echo ""
 
+#### Local stub server
+# The tests from here on fetch from crawler/stubserver.py, not the real server: it serves pages with
+# Content-Length and chunked bodies, a 404 and a 503, keeps connections alive, and logs every request
+# with the connection it came on. A hosts file sends cs50tse.cs.dartmouth.edu to it, on its own port.
+mkdir -p ../data
+rm -f ../data/stub.port
+python3 stubserver.py ../data/stub.port ../data/stub.log &
+STUB_PID=$!
+trap 'kill $STUB_PID 2>/dev/null' EXIT
+while [ ! -s ../data/stub.port ]; do sleep 0.1; done
+STUB_PORT=$(cat ../data/stub.port)
+printf '127.0.0.1:%s cs50tse.cs.dartmouth.edu\n' "$STUB_PORT" > ../data/stub-hosts
+STUB=http://cs50tse.cs.dartmouth.edu/tse/stub
+
+# checkSaved: Reports how many pages a crawl saved into a directory, and whether each is what the stub
+# server sent for its URL
+checkSaved() {
+    local saved=0 differ=0
+    for page in "$1"/[0-9]*; do
+        [ -f "$page" ] || continue
+        saved=$((saved + 1))
+        if ! tail -n +3 "$page" | cmp -s - <(python3 stubserver.py --print "$(head -1 "$page")"); then
+            echo "$(head -1 "$page") differs from what the server sent!"
+            differ=$((differ + 1))
+        fi
+    done
+    echo "$saved pages saved in $1, $differ differing from the server's"
+}
+
+# requestsSince: Prints the requests the stub server has logged after the first n lines
+requestsSince() {
+    tail -n +$(($1 + 1)) ../data/stub.log
+}
+
+#### Concurrent crawl
+# Test 12: Invalid numWorkers
+echo "Test 12: Invalid numWorkers (zero workers)"
+./crawler -t 0 http://cs50tse.cs.dartmouth.edu/tse/letters/index.html ../data/letters-t0 1
+echo ""
+
+# Test 13: the stub site, depth 3, with 8 fetch workers: all five pages, none from the 404
+echo "Test 13: Stub site depth 3 with 8 workers"
+rm -rf ../data/stub-t8 && mkdir -p ../data/stub-t8
+./crawler -t 8 -d 0 -H ../data/stub-hosts $STUB/index.html ../data/stub-t8 3 | sort
+checkSaved ../data/stub-t8
+echo ""
+
+#### Event-driven crawl
+# Test 14: -t and -c together, in either order, even when -t asks for the one worker there would be anyway
+echo "Test 14: Invalid options (-t with -c)"
+./crawler -t 4 -c 16 http://cs50tse.cs.dartmouth.edu/tse/letters/index.html ../data/letters-c16 1
+./crawler -c 16 -t 1 http://cs50tse.cs.dartmouth.edu/tse/letters/index.html ../data/letters-c16 1
+echo ""
+
+# Test 15: fetchtest, with a page sent with a length, two in chunks, a big one, a 404 and a 503
+echo "Test 15: fetchtest with 4 in flight"
+./fetchtest 4 http://127.0.0.1:$STUB_PORT/tse/stub/index.html http://127.0.0.1:$STUB_PORT/tse/stub/two.html \
+    http://127.0.0.1:$STUB_PORT/tse/stub/three.html http://127.0.0.1:$STUB_PORT/tse/stub/four.html \
+    http://127.0.0.1:$STUB_PORT/tse/stub/missing.html http://127.0.0.1:$STUB_PORT/tse/stub/busy.html | sed "s/:$STUB_PORT/:PORT/" | sort
+echo ""
+
+# Test 16: the stub site, depth 3, with 32 connections in flight
+echo "Test 16: Stub site depth 3 with 32 connections"
+rm -rf ../data/stub-c32 && mkdir -p ../data/stub-c32
+./crawler -c 32 -d 0 -H ../data/stub-hosts $STUB/index.html ../data/stub-c32 3 | sort
+checkSaved ../data/stub-c32
+echo ""
+
+#### Politeness delay
+# Test 17: Invalid delayMs
+echo "Test 17: Invalid delayMs (negative)"
+./crawler -d -5 http://cs50tse.cs.dartmouth.edu/tse/letters/index.html ../data/letters-d 1
+echo ""
+
+# Test 18: the stub site with 4 workers and 200ms between fetches: 6 fetches from one host take 1s or more
+echo "Test 18: Stub site depth 3 with 4 workers, 200ms delay"
+rm -rf ../data/stub-d200 && mkdir -p ../data/stub-d200
+START=$(date +%s%N)
+./crawler -t 4 -d 200 -H ../data/stub-hosts $STUB/index.html ../data/stub-d200 3 > /dev/null
+ELAPSED_MS=$((($(date +%s%N) - START) / 1000000))
+[ $ELAPSED_MS -ge 1000 ] && echo "6 fetches took 1s or more" || echo "6 fetches took only ${ELAPSED_MS}ms!"
+checkSaved ../data/stub-d200
+echo ""
+
+# Test 19: A page that does not exist is reported at once, not retried, since asking again won't help
+echo "Test 19: A missing page is not retried"
+rm -rf ../data/missing && mkdir -p ../data/missing
+LOGGED=$(wc -l < ../data/stub.log)
+./crawler -H ../data/stub-hosts $STUB/missing.html ../data/missing 0
+requestsSince $LOGGED | cut -d' ' -f3-
+echo ""
+
+#### Persistent connections
+# Test 20: the stub site with no delay; every fetch reuses one kept-alive connection
+echo "Test 20: Stub site depth 3, no delay, one connection"
+rm -rf ../data/stub-d0 && mkdir -p ../data/stub-d0
+LOGGED=$(wc -l < ../data/stub.log)
+./crawler -d 0 -H ../data/stub-hosts $STUB/index.html ../data/stub-d0 3 > /dev/null
+echo "$(requestsSince $LOGGED | wc -l) requests on $(requestsSince $LOGGED | cut -d' ' -f2 | sort -u | wc -l) connection(s)"
+checkSaved ../data/stub-d0
+echo ""
+
+#### DNS cache and hosts-file override
+# Test 21: Unreadable hosts file
+echo "Test 21: Invalid hosts file"
+./crawler -H ../data/no-such-hosts-file http://cs50tse.cs.dartmouth.edu/tse/letters/index.html ../data/letters-1 1
+echo ""
+
+# Test 22: A hosts file overrides DNS; it sends the server's name to the stub's address and port, so the pages are saved
+echo "Test 22: Hosts file pointing the server at the stub server"
+rm -rf ../data/stub-hosts-crawl && mkdir -p ../data/stub-hosts-crawl
+./crawler -d 0 -H ../data/stub-hosts $STUB/index.html ../data/stub-hosts-crawl 1 | sort
+checkSaved ../data/stub-hosts-crawl
+echo ""
+
+#### Segment page store
+# Test 23: the stub site saved to one segment file plus offset table, instead of a file per page
+echo "Test 23: Stub site depth 3 into a segment store"
+rm -rf ../data/stub-seg && mkdir -p ../data/stub-seg
+./crawler -d 0 -s -H ../data/stub-hosts $STUB/index.html ../data/stub-seg 3 > /dev/null
+cat ../data/stub-seg/.crawler
+ls ../data/stub-seg
+echo ""
+
+# Test 24: every page saved is in the document table, which the querier reads URLs from
+echo "Test 24: URLs in the document table of the segment store"
+tr '\0' '\n' < ../data/stub-seg/docs.url
+echo ""
+
+#### Retries
+# Test 25: A server that answers 503 may answer next time, so the page is tried three times, with backoff
+echo "Test 25: A 503 is retried"
+rm -rf ../data/busy && mkdir -p ../data/busy
+LOGGED=$(wc -l < ../data/stub.log)
+./crawler -H ../data/stub-hosts $STUB/busy.html ../data/busy 0
+requestsSince $LOGGED | cut -d' ' -f3-
+echo ""
+
 echo "All tests completed successfully."
 echo ""
 exit 0
@@ -0,0 +1,195 @@
+/*
+* hashbench.c - Microbenchmark of the string hashes and tables, over the vocabulary of an index file.
+*               Compares hash_jenkins (one byte at a time, then a modulus) with hash_string (eight bytes
+*               at a time, then a mask), and times lookups of every word in a hashtable and a strtable.
+* @author: Aniket Dey
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../libcs50/file.h"
+#include "../libcs50/hash.h"
+#include "../libcs50/hashtable.h"
+#include "../libcs50/strtable.h"
+
+// Global Constants
+static const int DEFAULT_ROUNDS = 1000; // passes over the vocabulary per measurement
+
+// Function Prototypes
+static char** loadWords(const char* indexFilename, int* numWords);
+static double nowNs(void);
+static void chainStats(const int* counts, const int slots, int* used, int* longest);
+
+/*
+* main(): Loads the vocabulary, then times each hash and table over it
+* Params: number of command-line arguments (argc), array of command-line arguments (argv)
+* Returns: 0 if successful, 1 if any errors occur
+*/
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s indexFilename [rounds]\n", argv[0]);
+        return 1;
+    }
+    int rounds = (argc == 3) ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) {
+        fprintf(stderr, "Error: rounds must be a positive integer\n");
+        return 1;
+    }
+
+    int numWords;
+    char** words = loadWords(argv[1], &numWords);
+    if (words == NULL || numWords == 0) {
+        fprintf(stderr, "Error: no words in index file '%s'\n", argv[1]);
+        free(words);
+        return 1;
+    }
+    size_t bytes = 0;
+    for (int i = 0; i < numWords; i++) {
+        bytes += strlen(words[i]);
+    }
+    printf("%d words, average length %.1f, %d rounds\n", numWords, (double)bytes / numWords, rounds);
+
+    // Tables sized as index_load sizes them: one slot per word (hashtable rounds up to a power of two)
+    int mask = 1;
+    while (mask < numWords) {
+        mask *= 2;
+    }
+    mask--;
+    hashtable_t* ht = hashtable_new(numWords);
+    strtable_t* st = strtable_new(numWords);
+    int* jenkinsCounts = calloc(numWords, sizeof(int));
+    int* maskCounts = calloc(mask + 1, sizeof(int));
+    if (ht == NULL || st == NULL || jenkinsCounts == NULL || maskCounts == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < numWords; i++) {
+        hashtable_insert(ht, words[i], words[i]);
+        strtable_insert(st, words[i], words[i]);
+        jenkinsCounts[hash_jenkins(words[i], numWords)]++;
+        maskCounts[hash_string(words[i], NULL) & mask]++;
+    }
+
+    // Each loop folds its results into sink, so none of the work can be optimized away
+    volatile uint64_t sink = 0;
+    uint64_t acc = 0;
+    double start = nowNs();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < numWords; i++) {
+            acc += hash_jenkins(words[i], numWords);
+        }
+    }
+    double jenkinsNs = (nowNs() - start) / ((double)rounds * numWords);
+
+    start = nowNs();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < numWords; i++) {
+            acc += hash_string(words[i], NULL) & mask;
+        }
+    }
+    double stringNs = (nowNs() - start) / ((double)rounds * numWords);
+
+    start = nowNs();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < numWords; i++) {
+            acc += (uintptr_t)hashtable_find(ht, words[i]);
+        }
+    }
+    double hashtableNs = (nowNs() - start) / ((double)rounds * numWords);
+
+    start = nowNs();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < numWords; i++) {
+            acc += (uintptr_t)strtable_find(st, words[i]);
+        }
+    }
+    double strtableNs = (nowNs() - start) / ((double)rounds * numWords);
+    sink = acc;
+    (void)sink;
+
+    int used, longest;
+    chainStats(jenkinsCounts, numWords, &used, &longest);
+    printf("hash_jenkins %% %-7d %6.1f ns/word  %d of %d slots used, longest chain %d\n",
+           numWords, jenkinsNs, used, numWords, longest);
+    chainStats(maskCounts, mask + 1, &used, &longest);
+    printf("hash_string & %-7d %6.1f ns/word  %d of %d slots used, longest chain %d\n",
+           mask, stringNs, used, mask + 1, longest);
+    printf("hashtable_find         %6.1f ns/word\n", hashtableNs);
+    printf("strtable_find          %6.1f ns/word\n", strtableNs);
+
+    hashtable_delete(ht, NULL);
+    strtable_delete(st, NULL);
+    free(jenkinsCounts);
+    free(maskCounts);
+    for (int i = 0; i < numWords; i++) {
+        free(words[i]);
+    }
+    free(words);
+    return 0;
+}
+
+/*
+* loadWords(): Reads the first word of every line of an index file
+* Params: index file name (indexFilename), where to store the number of words (numWords)
+* Returns: array of numWords strings, which the caller frees; null if the file cannot be read
+*/
+static char** loadWords(const char* indexFilename, int* numWords) {
+    *numWords = 0;
+    FILE* fp = fopen(indexFilename, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    int lines = file_numLines(fp);
+    char** words = calloc(lines > 0 ? lines : 1, sizeof(char*));
+    char* line = NULL;
+    size_t cap = 0;
+    while (words != NULL && *numWords < lines && file_getLine(fp, &line, &cap) != -1) {
+        size_t len = strcspn(line, " \n");
+        if (len == 0) {
+            continue;
+        }
+        words[*numWords] = malloc(len + 1);
+        if (words[*numWords] == NULL) {
+            break;
+        }
+        memcpy(words[*numWords], line, len);
+        words[(*numWords)++][len] = '\0';
+    }
+    free(line);
+    fclose(fp);
+    return words;
+}
+
+/*
+* nowNs(): Reads the monotonic clock
+* Params: None
+* Returns: the time in nanoseconds
+*/
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+* chainStats(): Summarizes how evenly a hash spread the words over the slots
+* Params: words per slot (counts), number of slots (slots), where to store the slots in use (used)
+*         and the most words in any one slot (longest)
+* Returns: None
+*/
+static void chainStats(const int* counts, const int slots, int* used, int* longest) {
+    *used = 0;
+    *longest = 0;
+    for (int i = 0; i < slots; i++) {
+        if (counts[i] > 0) {
+            (*used)++;
+        }
+        if (counts[i] > *longest) {
+            *longest = counts[i];
+        }
+    }
+}
@@ -7,15 +7,92 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "../libcs50/webpage.h"
 #include "../libcs50/mem.h"
+#include "../libcs50/hash.h"
+#include "../libcs50/strtable.h"
 #include "../common/pagedir.h"
+#include "../common/pagestore.h"
 #include "../common/index.h"
 #include "../common/word.h"
+#include "../common/termtable.h"
+#include "../common/segments.h"
+
+// Local types
+
+// One word of a partial index and its posting list
+typedef struct term {
+    const char* word; // owned by the partial index
+    postings_t* postings;
+} term_t;
+
+// A document whose counted words are going into the index
+typedef struct flush {
+    index_t* index;
+    int docID;
+} flush_t;
+
+// A thread indexing one range of docIDs into its own partial index
+typedef struct indexWorker {
+    pagestore_t* store; // shared; loading pages from it is safe from several threads
+    int first; // first docID of the range
+    int last; // one past the last docID of the range
+    int missing; // first docID of the range that failed to load; last if none did
+    index_t* partial; // words of the pages loaded, thread-local
+    termtable_t* terms; // counts the words of the page being indexed, thread-local
+    int numShards;
+    term_t** shards; // the partial's words split by hash, shards[s] holding shardSizes[s] of them
+    int* shardSizes;
+    bool ok;
+} indexWorker_t;
+
+// A thread merging one shard of every partial index
+typedef struct mergeWorker {
+    indexWorker_t* workers; // all of them, in docID order
+    int numWorkers;
+    int shard; // which shard to merge
+    int end; // docIDs from here on were not indexed
+    strtable_t* merged; // word -> postings_t*, every word of this shard
+    index_t* index; // the index the merged lists then move into
+    bool ok;
+} mergeWorker_t;
+
+// Global Constants
+static const int MAX_THREADS = 64; // upper bound on the -t option
+static const int MAX_MEMORY_MB = 1 << 20; // upper bound on the -m option
+static const int MAX_SEGMENTS = 4; // an update leaving more segments than this folds some together
+static const size_t ARENA_BLOCK = 1 << 20; // largest arena block for an index built in runs
+static const size_t RUN_MEMORY = 1 << 19; // memory a run being merged may hold: pages read but not yet given back
 
 // Function prototypes
 bool index_build(index_t* index, const char* pageDirectory);
-void index_page(index_t* index, webpage_t* page, int docID);
+bool index_buildParallel(index_t* index, const char* pageDirectory, const int numThreads);
+bool index_buildRuns(const char* pageDirectory, const char* indexFilename, const size_t budget);
+static bool addRun(const char* indexFilename, const int number, char*** runs, int* numRuns);
+static void removeRuns(char** runs, const int numRuns);
+bool index_update(const char* pageDirectory, const char* indexFilename);
+static int highestDocID(const char* indexFilename);
+static bool samePage(pagestore_t* store, const int docID, const char* url, const size_t length);
+static bool recordLast(segments_t* segments, pagestore_t* store, const int last);
+static void foldInBackground(const char* indexFilename);
+static bool foldSegments(const char* indexFilename, const int folding);
+static long fileSize(const char* filename);
+static void max_helper(void* arg, const char* word, postings_t* postings);
+void index_page(index_t* index, termtable_t* terms, webpage_t* page, int docID);
+static void flush_helper(void* arg, const char* word, const int count);
+static int countPages(pagestore_t* store);
+static bool pageExists(pagestore_t* store, const int docID);
+static void* indexRange(void* arg);
+static bool splitShards(indexWorker_t* worker);
+static void count_helper(void* arg, const char* word, postings_t* postings);
+static void split_helper(void* arg, const char* word, postings_t* postings);
+static void* mergeShard(void* arg);
+static void adopt_helper(void* arg, const char* key, void* item);
+static void freeWorkers(indexWorker_t* workers, const int numWorkers);
 
 /*
 * main(): Parses arguments, checks validity and initializes other modules.
@@ -23,14 +100,54 @@ void index_page(index_t* index, webpage_t* page, int docID);
 * Returns: 1 if any errors, 0 if successful
 */
 int main(int argc, char* argv[]) {
+    // Parse options first; -t indexes with that many threads,
+    // -m keeps the index in memory under that many megabytes, writing it to disk in runs,
+    // and -u indexes only the pages added since the index was last built or updated
+    const char* usage = "Usage: %s [-t numThreads | -m memoryMB | -u] pageDirectory indexFilename\n";
+    int numThreads = 1;
+    int memoryMB = 0;
+    bool update = false;
+    bool threadsGiven = false; // whether -t was given, even as -t 1
+    char* endptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:m:u")) != -1) {
+        switch (opt) {
+        case 'u':
+            update = true;
+            break;
+        case 't':
+            numThreads = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || numThreads < 1 || numThreads > MAX_THREADS) {
+                fprintf(stderr, "numThreads must be an integer between 1 and %d\n", MAX_THREADS);
+                return 1;
+            }
+            threadsGiven = true;
+            break;
+        case 'm':
+            memoryMB = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || memoryMB < 1 || memoryMB > MAX_MEMORY_MB) {
+                fprintf(stderr, "memoryMB must be an integer between 1 and %d\n", MAX_MEMORY_MB);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, usage, argv[0]);
+            return 1;
+        }
+    }
+    if (threadsGiven + (memoryMB > 0) + update > 1) {
+        fprintf(stderr, "-t, -m and -u cannot be used together\n");
+        return 1;
+    }
+
     // Check the argument count and correct usage if incorrect
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s pageDirectory indexFilename\n", argv[0]);
+    if (argc - optind != 2) {
+        fprintf(stderr, usage, argv[0]);
         return 1;
     }
     
-    char* pageDirectory = argv[1];
-    char* indexFilename = argv[2];
+    char* pageDirectory = argv[optind];
+    char* indexFilename = argv[optind + 1];
     
     // Check if pageDirectory is valid and contains .crawler file
     if (!pagedir_validate(pageDirectory)) {
@@ -38,23 +155,45 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Verify indexFilename is writable
-    FILE* fp = fopen(indexFilename, "w");
+    // Verify indexFilename is writable; an update adds to the index, so must not empty it
+    FILE* fp = fopen(indexFilename, update ? "a" : "w");
     if (fp == NULL) {
         fprintf(stderr, "Error: cannot write to '%s'\n", indexFilename);
         return 1;
     }
     fclose(fp);
+
+    if (update) {
+        if (!index_update(pageDirectory, indexFilename)) {
+            fprintf(stderr, "Error: failed to update index '%s' from '%s'\n", indexFilename, pageDirectory);
+            return 1;
+        }
+        return 0;
+    }
+    // Any other build covers every page, so the segments of an earlier index go
+    segments_remove(indexFilename);
     
-    // Initialize index with a starting size of 500
-    index_t* index = index_new(500);
+    // With a budget, the index is written in runs and merged into the file as it is built
+    if (memoryMB > 0) {
+        if (!index_buildRuns(pageDirectory, indexFilename, (size_t)memoryMB << 20)) {
+            fprintf(stderr, "Error: failed to build index from '%s'\n", pageDirectory);
+            return 1;
+        }
+        return 0;
+    }
+
+    // Initialize index with room for 500 words; it grows as the vocabulary does. Built by one thread, its
+    // lists come from an arena, freed at once; built by several, they come from the merge threads instead
+    index_t* index = (numThreads > 1) ? index_new(500) : index_newArena(500, 0);
     if (index == NULL) {
         fprintf(stderr, "Error: failed to create index (out of memory)\n");
         return 1;
     }
     
     // Build index from page directory files
-    if (!index_build(index, pageDirectory)) {
+    bool built = (numThreads > 1) ? index_buildParallel(index, pageDirectory, numThreads)
+                                  : index_build(index, pageDirectory);
+    if (!built) {
         fprintf(stderr, "Error: failed to build index from '%s'\n", pageDirectory);
         index_delete(index);
         return 1;
@@ -72,7 +211,7 @@ int main(int argc, char* argv[]) {
 }
 
 /*
-* index_build(): Creates index from page directory files
+* index_build(): Creates index from the pages in a page directory, in either format
 * Params: pointer to index structure (index), directory path containing pages (pageDirectory)
 * Returns: true if successful, false on error
 */
@@ -81,38 +220,724 @@ bool index_build(index_t* index, const char* pageDirectory) {
         return false;
     }
     
+    pagestore_t* store = pagestore_open(pageDirectory);
+    if (store == NULL) {
+        return false;
+    }
+
+    termtable_t* terms = termtable_new();
+    if (terms == NULL) {
+        pagestore_close(store);
+        return false;
+    }
+
     int docID = 1;
     webpage_t* page;
     
-    // Process each page file until one fails to load
-    while ((page = pagedir_load(pageDirectory, docID)) != NULL) {
-        index_page(index, page, docID); // Add page's words to index
+    // Process each page until one fails to load
+    while ((page = pagestore_load(store, docID)) != NULL) {
+        index_page(index, terms, page, docID); // Add page's words to index
         webpage_delete(page); // Clean up webpage
         docID++; // Move to next page
     }
     
+    termtable_delete(terms);
+    pagestore_close(store);
+    return true;
+}
+
+/*
+* index_buildParallel(): Creates the same index as index_build, with several threads. Each indexes its own
+*                        range of docIDs into a partial index; then each merges one shard of the words of
+*                        every partial, in docID order, so no two threads ever touch the same posting list.
+* Params: pointer to index structure (index), directory path containing pages (pageDirectory),
+*         number of threads (numThreads)
+* Returns: true if successful, false on error
+*/
+bool index_buildParallel(index_t* index, const char* pageDirectory, const int numThreads) {
+    if (index == NULL || pageDirectory == NULL || numThreads < 1) {
+        return false;
+    }
+
+    pagestore_t* store = pagestore_open(pageDirectory);
+    if (store == NULL) {
+        return false;
+    }
+    int numPages = countPages(store);
+    int numWorkers = (numPages < numThreads) ? ((numPages > 0) ? numPages : 1) : numThreads;
+
+    indexWorker_t* workers = mem_calloc(numWorkers, sizeof(indexWorker_t));
+    mergeWorker_t* mergers = mem_calloc(numWorkers, sizeof(mergeWorker_t));
+    pthread_t* threads = mem_calloc(numWorkers, sizeof(pthread_t));
+    if (workers == NULL || mergers == NULL || threads == NULL) {
+        freeWorkers(workers, 0);
+        if (mergers != NULL) {
+            mem_free(mergers);
+        }
+        if (threads != NULL) {
+            mem_free(threads);
+        }
+        pagestore_close(store);
+        return false;
+    }
+
+    // Index: worker w takes docIDs [first, last), a near-equal share of 1..numPages
+    bool ok = true;
+    for (int w = 0; w < numWorkers; w++) {
+        workers[w].store = store;
+        workers[w].first = 1 + (int)((long)numPages * w / numWorkers);
+        workers[w].last = 1 + (int)((long)numPages * (w + 1) / numWorkers);
+        workers[w].numShards = numWorkers;
+    }
+    int started = 0;
+    for ( ; started < numWorkers; started++) {
+        if (pthread_create(&threads[started], NULL, indexRange, &workers[started]) != 0) {
+            ok = false;
+            break;
+        }
+    }
+    for (int w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+        ok = ok && workers[w].ok;
+    }
+
+    // As index_build stops at the first page that fails to load, drop every docID from there on
+    int end = numPages + 1;
+    for (int w = 0; w < numWorkers && end > numPages; w++) {
+        if (workers[w].missing < workers[w].last) {
+            end = workers[w].missing;
+        }
+    }
+
+    // Merge: thread s gathers shard s of each partial that holds docIDs before end
+    started = 0;
+    for ( ; ok && started < numWorkers; started++) {
+        mergers[started].workers = workers;
+        mergers[started].numWorkers = numWorkers;
+        mergers[started].shard = started;
+        mergers[started].end = end;
+        mergers[started].index = index;
+        if (pthread_create(&threads[started], NULL, mergeShard, &mergers[started]) != 0) {
+            ok = false;
+            break;
+        }
+    }
+    for (int s = 0; s < started; s++) {
+        pthread_join(threads[s], NULL);
+        ok = ok && mergers[s].ok;
+    }
+
+    // The shards hold different words, so their lists move into the index as they are
+    for (int s = 0; s < numWorkers; s++) {
+        if (ok) {
+            strtable_iterate(mergers[s].merged, &mergers[s], adopt_helper);
+            strtable_delete(mergers[s].merged, NULL);
+            ok = mergers[s].ok;
+        }
+        else {
+            strtable_delete(mergers[s].merged, postings_delete);
+        }
+    }
+
+    freeWorkers(workers, numWorkers);
+    mem_free(mergers);
+    mem_free(threads);
+    pagestore_close(store);
+    return ok;
+}
+
+/*
+* index_buildRuns(): Creates the same index as index_build, and writes it to a file, holding no more of it in
+*                    memory than a budget allows. Whenever the index grows past the budget, it is written to
+*                    a run file, indexFilename.runN, in the binary format - which sorts it by word - and
+*                    memory starts afresh; at the end, index_merge merges the runs into indexFilename, reading
+*                    each once, in word order, and the runs are removed. Each run being merged costs a little
+*                    memory of its own, so when there are more runs than the budget allows for, consecutive
+*                    runs are first merged into fewer, bigger ones. An index that fits is saved as usual.
+* Params: directory path containing pages (pageDirectory), file to write the index to (indexFilename),
+*         bytes the index may take in memory (budget)
+* Returns: true if successful, false on error
+*/
+bool index_buildRuns(const char* pageDirectory, const char* indexFilename, const size_t budget) {
+    if (pageDirectory == NULL || indexFilename == NULL) {
+        return false;
+    }
+    // Blocks of a sixteenth of the budget, so a run is not written while most of a block is still unused
+    size_t blockSize = (budget / 16 < ARENA_BLOCK) ? budget / 16 : ARENA_BLOCK;
+    pagestore_t* store = pagestore_open(pageDirectory);
+    termtable_t* terms = termtable_new();
+    index_t* index = index_newArena(500, blockSize);
+    bool ok = (store != NULL && terms != NULL && index != NULL);
+
+    char** runs = NULL;
+    int numRuns = 0;
+    int named = 0; // run files named so far
+    webpage_t* page;
+    for (int docID = 1; ok && (page = pagestore_load(store, docID)) != NULL; docID++) {
+        index_page(index, terms, page, docID);
+        webpage_delete(page);
+        // Written while there is still room to sort its words for the run file
+        if (index_bytes(index) + index_saveBytes(index) >= budget) {
+            ok = addRun(indexFilename, ++named, &runs, &numRuns) && index_saveBinary(index, runs[numRuns - 1]);
+            index_delete(index);
+            index = ok ? index_newArena(500, blockSize) : NULL;
+            ok = ok && index != NULL;
+        }
+    }
+
+    if (ok && numRuns == 0) {
+        ok = index_save(index, indexFilename);
+    }
+    else if (ok) {
+        // The last run is whatever is left; then the runs' memory is all given back before merging
+        ok = addRun(indexFilename, ++named, &runs, &numRuns) && index_saveBinary(index, runs[numRuns - 1]);
+        index_delete(index);
+        index = NULL;
+        int fanIn = (int)(budget / RUN_MEMORY);
+        fanIn = (fanIn < 2) ? 2 : fanIn;
+        while (ok && numRuns > fanIn) {
+            // Each group of fanIn consecutive runs becomes one, so docIDs stay in order from run to run
+            char** merged = NULL;
+            int numMerged = 0;
+            for (int first = 0; ok && first < numRuns; first += fanIn) {
+                int group = (numRuns - first < fanIn) ? numRuns - first : fanIn;
+                ok = addRun(indexFilename, ++named, &merged, &numMerged)
+                     && index_merge((const char**)&runs[first], group, merged[numMerged - 1], true);
+            }
+            removeRuns(runs, numRuns);
+            runs = merged;
+            numRuns = numMerged;
+        }
+        ok = ok && index_merge((const char**)runs, numRuns, indexFilename, false);
+    }
+
+    removeRuns(runs, numRuns);
+    index_delete(index);
+    termtable_delete(terms);
+    pagestore_close(store);
+    return ok;
+}
+
+/*
+* addRun(): Names the next run file, and adds it to a list of run filenames
+* Params: file the runs are named after (indexFilename), number for the run (number), list of run filenames
+*         and its length, both updated (runs, numRuns)
+* Returns: true if successful, false if out of memory
+*/
+static bool addRun(const char* indexFilename, const int number, char*** runs, int* numRuns) {
+    char* name = mem_malloc(strlen(indexFilename) + sizeof(".run") + 11);
+    if (name == NULL) {
+        return false;
+    }
+    sprintf(name, "%s.run%d", indexFilename, number);
+
+    // The list of names is doubled whenever its length reaches a power of two
+    if ((*numRuns & (*numRuns - 1)) == 0) {
+        char** more = mem_malloc(2 * (*numRuns > 0 ? *numRuns : 1) * sizeof(char*));
+        if (more == NULL) {
+            mem_free(name);
+            return false;
+        }
+        if (*runs != NULL) {
+            memcpy(more, *runs, *numRuns * sizeof(char*));
+            mem_free(*runs);
+        }
+        *runs = more;
+    }
+    (*runs)[(*numRuns)++] = name;
     return true;
 }
 
 /*
-* index_page(): Processes single webpage and adds words to index.
-* Params: pointer to index (index), webpage to process (page), document ID (docID)
+* index_update(): Indexes the pages added to a page directory since the index was last built or updated, into a
+*                 new segment of it (see segments.h), and records the highest docID indexed. The first update of
+*                 an index built without -u finds that docID in the index; the first of an empty index writes
+*                 the pages as the index itself. The manifest also records which page that docID was, and an
+*                 update refuses a directory that no longer has it there, as a crawl into the same directory
+*                 starts over at docID 1, so the pages indexed before are gone. An update leaving more than
+*                 MAX_SEGMENTS segments folds some together in the background, so it returns as soon as the new
+*                 segment can be searched.
+* Params: directory path containing pages (pageDirectory), the index file (indexFilename)
+* Returns: true if successful, false on error
+*/
+bool index_update(const char* pageDirectory, const char* indexFilename) {
+    if (pageDirectory == NULL || indexFilename == NULL) {
+        return false;
+    }
+    int updating = segments_lockUpdate(indexFilename);
+    int lock = segments_lock(indexFilename, false);
+    segments_t* segments = segments_read(indexFilename);
+    segments_unlock(lock);
+    pagestore_t* store = pagestore_open(pageDirectory);
+    termtable_t* terms = termtable_new();
+    index_t* index = index_newArena(500, 0);
+    bool ok = (updating >= 0 && segments != NULL && store != NULL && terms != NULL && index != NULL);
+
+    // Without a manifest, nothing says how far the index goes but the index itself
+    int last = (ok && segments->lastDocID == 0 && segments->count == 0) ? highestDocID(indexFilename)
+                                                                          : (ok ? segments->lastDocID : 0);
+    ok = ok && last >= 0;
+    if (ok && segments->lastURL != NULL && !samePage(store, last, segments->lastURL, segments->lastLength)) {
+        fprintf(stderr, "Error: '%s' was crawled again since '%s' was last built or updated; build it again without -u\n",
+                pageDirectory, indexFilename);
+        ok = false;
+    }
+    int docID = last + 1;
+    webpage_t* page;
+    for (; ok && (page = pagestore_load(store, docID)) != NULL; docID++) {
+        index_page(index, terms, page, docID);
+        webpage_delete(page);
+    }
+
+    bool fresh = (ok && last == 0 && segments->count == 0);
+    if (ok && fresh && docID - 1 > last) {
+        ok = index_save(index, indexFilename); // Nothing was indexed before, so these pages are the index
+    }
+    if (ok) {
+        // A fold may have changed the manifest since it was read, but only this update adds to it
+        lock = segments_lock(indexFilename, true);
+        segments_t* now = segments_read(indexFilename);
+        ok = (now != NULL);
+        if (ok && !fresh && docID - 1 > last) {
+            char* name = segments_name(indexFilename, now->nextNumber);
+            ok = (name != NULL && index_saveBinary(index, name) && segments_add(now, now->nextNumber++));
+            if (!ok && name != NULL) {
+                remove(name);
+            }
+            if (name != NULL) {
+                mem_free(name);
+            }
+        }
+        if (ok) {
+            ok = recordLast(now, store, docID - 1) && segments_write(now, indexFilename);
+        }
+        segments_unlock(lock);
+        if (ok && now->count > MAX_SEGMENTS) {
+            segments_unlock(updating); // The fold must not hold this lock
+            updating = -1;
+            foldInBackground(indexFilename);
+        }
+        segments_delete(now);
+    }
+
+    segments_unlock(updating);
+    segments_delete(segments);
+    index_delete(index);
+    termtable_delete(terms);
+    pagestore_close(store);
+    return ok;
+}
+
+/*
+* highestDocID(): Finds the highest docID in an index file
+* Params: the index file (indexFilename)
+* Returns: the docID; 0 if the index is empty; -1 if it cannot be read
+*/
+static int highestDocID(const char* indexFilename) {
+    index_t* index = index_open(indexFilename);
+    if (index == NULL) {
+        return -1;
+    }
+    int highest = 0;
+    index_iterate(index, &highest, max_helper);
+    index_delete(index);
+    return highest;
+}
+
+/*
+* samePage(): Tells whether a page directory still holds the page a manifest recorded under a docID
+* Params: store, docID, the URL and html length recorded (url, length)
+* Returns: true if the page with that docID has that URL and length
+*/
+static bool samePage(pagestore_t* store, const int docID, const char* url, const size_t length) {
+    webpage_t* page = pagestore_load(store, docID);
+    bool same = (page != NULL && strcmp(webpage_getURL(page), url) == 0 && webpage_getHTMLLength(page) == length);
+    if (page != NULL) {
+        webpage_delete(page);
+    }
+    return same;
+}
+
+/*
+* recordLast(): Records in a manifest the highest docID indexed, and which page it is, for the next update to check
+* Params: the manifest (segments), store, the docID (last; 0 if none)
+* Returns: true if successful, false if the page cannot be loaded or out of memory
+*/
+static bool recordLast(segments_t* segments, pagestore_t* store, const int last) {
+    if (last == 0) {
+        return segments_setLast(segments, 0, NULL, 0);
+    }
+    webpage_t* page = pagestore_load(store, last);
+    bool ok = (page != NULL && segments_setLast(segments, last, webpage_getURL(page), webpage_getHTMLLength(page)));
+    if (page != NULL) {
+        webpage_delete(page);
+    }
+    return ok;
+}
+
+/*
+* max_helper(): Raises the highest docID seen to the last of a posting list's, for highestDocID
+* Params: the highest docID so far (arg), word, its posting list (postings)
 * Returns: void
 */
-void index_page(index_t* index, webpage_t* page, int docID) {
-    if (index == NULL || page == NULL || docID < 1) {
+static void max_helper(void* arg, const char* word, postings_t* postings) {
+    int* highest = arg;
+    int size = postings_size(postings);
+    if (size > 0 && postings_array(postings)[size - 1].docID > *highest) {
+        *highest = postings_array(postings)[size - 1].docID;
+    }
+}
+
+/*
+* foldInBackground(): Starts a process that folds an index's segments together, and does not wait for it. The
+*                     fold lock is taken first, and the process inherits it, so it is held from the moment this
+*                     returns until the fold is done; if another process holds it, that one folds instead.
+* Params: the index file (indexFilename)
+* Returns: void
+*/
+static void foldInBackground(const char* indexFilename) {
+    int folding = segments_lockFold(indexFilename);
+    if (folding < 0) {
+        return;
+    }
+    fflush(NULL); // Or the child would write out what is buffered again
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(foldSegments(indexFilename, folding) ? 0 : 1);
+    }
+    if (pid < 0) {
+        fprintf(stderr, "Warning: cannot fold the segments of '%s' now; the next update will\n", indexFilename);
+    }
+    segments_unlock(folding); // The child's copy of the lock holds it until the child is done
+}
+
+/*
+* foldSegments(): Merges the newest segments of an index into one with index_merge, and puts it in their place.
+*                 The newest are taken back to the first that is bigger than all those after it together, so,
+*                 as in a binary counter, each page is merged again a logarithmic number of times. The manifest
+*                 is only locked while it is read and rewritten: queries and updates go on during the merge, and
+*                 a segment added meanwhile stays after the new one. Queriers that opened the old segments keep
+*                 them, removed or not, until they close them.
+* Params: the index file (indexFilename), its fold lock, as segments_lockFold gave it, which this releases (folding)
+* Returns: true if successful, false on error
+*/
+static bool foldSegments(const char* indexFilename, const int folding) {
+    int lock = segments_lock(indexFilename, true);
+    segments_t* segments = segments_read(indexFilename);
+    bool ok = (segments != NULL && segments->count >= 2);
+    int number = 0;
+    if (ok) {
+        number = segments->nextNumber++;
+        ok = segments_write(segments, indexFilename);
+    }
+    segments_unlock(lock);
+
+    // Choose the newest segments, at least two, and merge them
+    int first = ok ? segments->count - 1 : 0;
+    long total = 0;
+    char** names = ok ? mem_calloc(segments->count, sizeof(char*)) : NULL;
+    char* name = ok ? segments_name(indexFilename, number) : NULL;
+    ok = (names != NULL && name != NULL);
+    for (int i = ok ? segments->count - 1 : -1; i >= 0; i--) {
+        names[i] = segments_name(indexFilename, segments->numbers[i]);
+        long size = (names[i] != NULL) ? fileSize(names[i]) : -1;
+        if (size < 0) {
+            ok = false;
+            break;
+        }
+        if (i < segments->count - 1 && size > total && segments->count - i > 2) {
+            break;
+        }
+        first = i;
+        total += size;
+    }
+    int count = ok ? segments->count - first : 0;
+    ok = ok && index_merge((const char**)&names[first], count, name, true);
+
+    // Put the new segment in their place, if they are still there
+    if (ok) {
+        lock = segments_lock(indexFilename, true);
+        segments_t* now = segments_read(indexFilename);
+        ok = (now != NULL && now->count >= segments->count);
+        for (int i = 0; ok && i < segments->count; i++) {
+            ok = now->numbers[i] == segments->numbers[i];
+        }
+        if (ok) {
+            now->numbers[first] = number;
+            memmove(&now->numbers[first + 1], &now->numbers[segments->count],
+                    (now->count - segments->count) * sizeof(int));
+            now->count -= count - 1;
+            ok = segments_write(now, indexFilename);
+        }
+        for (int i = first; ok && i < segments->count; i++) {
+            remove(names[i]);
+        }
+        segments_unlock(lock);
+        segments_delete(now);
+    }
+    if (!ok && name != NULL) {
+        remove(name);
+    }
+
+    for (int i = 0; names != NULL && i < segments->count; i++) {
+        if (names[i] != NULL) {
+            mem_free(names[i]);
+        }
+    }
+    if (names != NULL) {
+        mem_free(names);
+    }
+    if (name != NULL) {
+        mem_free(name);
+    }
+    segments_delete(segments);
+    segments_unlock(folding);
+    return ok;
+}
+
+/*
+* fileSize(): Tells how big a file is
+* Params: the file (filename)
+* Returns: its size in bytes, or -1 if it cannot be found
+*/
+static long fileSize(const char* filename) {
+    struct stat info;
+    return (stat(filename, &info) == 0) ? (long)info.st_size : -1;
+}
+
+/*
+* removeRuns(): Removes the run files and frees the list of their names
+* Params: the run filenames (runs; may be null), how many (numRuns)
+* Returns: void
+*/
+static void removeRuns(char** runs, const int numRuns) {
+    for (int i = 0; i < numRuns; i++) {
+        remove(runs[i]);
+        mem_free(runs[i]);
+    }
+    if (runs != NULL) {
+        mem_free(runs);
+    }
+}
+
+/*
+* index_page(): Processes single webpage and adds words to index. The page's words are counted first, so each
+*               distinct word goes into the index once, with its count.
+* Params: pointer to index (index), scratch table for the counts (terms), webpage to process (page), document ID (docID)
+* Returns: void
+*/
+void index_page(index_t* index, termtable_t* terms, webpage_t* page, int docID) {
+    if (index == NULL || terms == NULL || page == NULL || docID < 1) {
         return;
     }
     
-    int position = 0;
-    char* word;
-    
-    // Get each word, normalize if >=3 chars, add to index
-    while ((word = webpage_getNextWord(page, &position)) != NULL) {
-        if (strlen(word) >= 3) {
-            normalizeWord(word); // Convert to lowercase
-            index_add(index, word, docID); // Update word count in index
+    // Each word of >=3 chars comes back already lower-cased, in the scanner's own buffer
+    wordscan_t scan;
+    wordscan_open(&scan, webpage_getHTML(page), webpage_getHTMLLength(page), 3);
+    const char* word;
+    int length;
+    while ((word = wordscan_next(&scan, &length)) != NULL) {
+        termtable_add(terms, word, length); // Count the word in this page
+    }
+    wordscan_close(&scan);
+
+    // Then set each word's count in index
+    flush_t flush = { index, docID };
+    termtable_iterate(terms, &flush, flush_helper);
+    termtable_clear(terms);
+}
+
+// Helper for index_page, sets one word's count for the page in the index
+static void flush_helper(void* arg, const char* word, const int count) {
+    flush_t* flush = arg;
+    index_set(flush->index, word, flush->docID, count);
+}
+
+
+/*
+* countPages(): Finds how many docIDs a page directory holds, by doubling and then halving on whether a page loads;
+*               if the docIDs have gaps, the count may run past the first, but never stops short of it
+* Params: store to load from (store)
+* Returns: a docID that loads, with the next one failing to; 0 if page 1 does not load
+*/
+static int countPages(pagestore_t* store) {
+    if (!pageExists(store, 1)) {
+        return 0;
+    }
+    // Page low loads and page high does not
+    int low = 1;
+    int high = 2;
+    while (high < INT_MAX / 2 && pageExists(store, high)) {
+        low = high;
+        high *= 2;
+    }
+    while (high - low > 1) {
+        int mid = low + (high - low) / 2;
+        if (pageExists(store, mid)) {
+            low = mid;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/*
+* pageExists(): Tells whether a page loads
+* Params: store to load from (store), document ID (docID)
+* Returns: true if it loads
+*/
+static bool pageExists(pagestore_t* store, const int docID) {
+    webpage_t* page = pagestore_load(store, docID);
+    webpage_delete(page);
+    return page != NULL;
+}
+
+/*
+* indexRange(): Thread function that indexes one worker's range of docIDs into its partial index, stopping at
+*               the first page that fails to load, and then splits the partial's words into shards
+* Params: the worker (arg, an indexWorker_t*)
+* Returns: NULL; sets the worker's ok
+*/
+static void* indexRange(void* arg) {
+    indexWorker_t* worker = arg;
+    worker->missing = worker->last;
+    worker->partial = index_newArena(500, 0);
+    worker->terms = termtable_new();
+    if (worker->partial == NULL || worker->terms == NULL) {
+        return NULL;
+    }
+    for (int docID = worker->first; docID < worker->last; docID++) {
+        webpage_t* page = pagestore_load(worker->store, docID);
+        if (page == NULL) {
+            worker->missing = docID;
+            break;
+        }
+        index_page(worker->partial, worker->terms, page, docID);
+        webpage_delete(page);
+    }
+    worker->ok = splitShards(worker);
+    return NULL;
+}
+
+/*
+* splitShards(): Lists the words of a worker's partial index by shard, the hash of a word deciding its shard
+* Params: the worker (worker)
+* Returns: true if successful, false if out of memory
+*/
+static bool splitShards(indexWorker_t* worker) {
+    worker->shards = mem_calloc(worker->numShards, sizeof(term_t*));
+    worker->shardSizes = mem_calloc(worker->numShards, sizeof(int));
+    if (worker->shards == NULL || worker->shardSizes == NULL) {
+        return false;
+    }
+    // Count each shard's words, make room for them, then fill the room
+    index_iterate(worker->partial, worker, count_helper);
+    for (int s = 0; s < worker->numShards; s++) {
+        if (worker->shardSizes[s] > 0) {
+            worker->shards[s] = mem_malloc(worker->shardSizes[s] * sizeof(term_t));
+            if (worker->shards[s] == NULL) {
+                return false;
+            }
         }
-        free(word); // Clean up word memory
+        worker->shardSizes[s] = 0;
     }
-}
\ No newline at end of file
+    index_iterate(worker->partial, worker, split_helper);
+    return true;
+}
+
+// Helper for splitShards, counts one word in its shard
+static void count_helper(void* arg, const char* word, postings_t* postings) {
+    indexWorker_t* worker = arg;
+    worker->shardSizes[hash_string(word, NULL) % worker->numShards]++;
+}
+
+// Helper for splitShards, lists one word and its posting list in its shard
+static void split_helper(void* arg, const char* word, postings_t* postings) {
+    indexWorker_t* worker = arg;
+    int s = hash_string(word, NULL) % worker->numShards;
+    worker->shards[s][worker->shardSizes[s]].word = word;
+    worker->shards[s][worker->shardSizes[s]++].postings = postings;
+}
+
+/*
+* mergeShard(): Thread function that merges one shard of every partial index into one list per word. The
+*               partials are taken in docID order, so each merge is an append.
+* Params: the merger (arg, a mergeWorker_t*)
+* Returns: NULL; sets the merger's merged and ok
+*/
+static void* mergeShard(void* arg) {
+    mergeWorker_t* merger = arg;
+    int expected = 1;
+    for (int w = 0; w < merger->numWorkers; w++) {
+        if (merger->workers[w].shardSizes[merger->shard] > expected) {
+            expected = merger->workers[w].shardSizes[merger->shard];
+        }
+    }
+    merger->merged = strtable_new(expected);
+    if (merger->merged == NULL) {
+        return NULL;
+    }
+
+    // A partial whose range starts at or after end holds only pages that index_build would not have reached;
+    // the one end falls in stopped there, so every other partial is taken whole
+    for (int w = 0; w < merger->numWorkers && merger->workers[w].first < merger->end; w++) {
+        const indexWorker_t* worker = &merger->workers[w];
+        for (int i = 0; i < worker->shardSizes[merger->shard]; i++) {
+            const term_t* term = &worker->shards[merger->shard][i];
+            postings_t* list = strtable_find(merger->merged, term->word);
+            if (list == NULL) {
+                list = postings_new();
+                if (list == NULL || !strtable_insert(merger->merged, term->word, list)) {
+                    postings_delete(list);
+                    return NULL;
+                }
+            }
+            const posting_t* entries = postings_array(term->postings);
+            int size = postings_size(term->postings);
+            for (int j = 0; j < size; j++) {
+                if (!postings_set(list, entries[j].docID, entries[j].count)) {
+                    return NULL;
+                }
+            }
+        }
+    }
+    merger->ok = true;
+    return NULL;
+}
+
+// Helper for index_buildParallel, moves one merged word and its posting list into the index
+static void adopt_helper(void* arg, const char* key, void* item) {
+    mergeWorker_t* merger = arg;
+    if (!index_insert(merger->index, key, item)) {
+        postings_delete(item);
+        merger->ok = false;
+    }
+}
+
+/*
+* freeWorkers(): Frees the index workers, their partial indexes and their shard lists
+* Params: the workers (workers), how many (numWorkers)
+* Returns: void
+*/
+static void freeWorkers(indexWorker_t* workers, const int numWorkers) {
+    for (int w = 0; w < numWorkers; w++) {
+        if (workers[w].shards != NULL) {
+            for (int s = 0; s < workers[w].numShards; s++) {
+                if (workers[w].shards[s] != NULL) {
+                    mem_free(workers[w].shards[s]);
+                }
+            }
+            mem_free(workers[w].shards);
+        }
+        if (workers[w].shardSizes != NULL) {
+            mem_free(workers[w].shardSizes);
+        }
+        index_delete(workers[w].partial);
+        termtable_delete(workers[w].terms);
+    }
+    if (workers != NULL) {
+        mem_free(workers);
+    }
+}
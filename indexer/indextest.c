@@ -5,23 +5,30 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include "../common/index.h"
 
 /*
-* main(): Validates arguments and tests index load/save operations
+* main(): Validates arguments and tests index load/save operations. The old index may be text or binary;
+*         the new one is written as text, or as binary with -b, so indextest also converts between the two
 * Params: number of command-line arguments (argc), array of command-line arguments (argv)
 * Returns: 0 if successful, 1 if any errors occur
 */
 int main(int argc, char* argv[]) {
+    // An optional -b comes first
+    bool binary = (argc > 1 && strcmp(argv[1], "-b") == 0);
+    int first = binary ? 2 : 1;
+
     // Check for correct number of arguments, correct usage if incorrect or none
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s oldIndexFilename newIndexFilename\n", argv[0]);
+    if (argc - first != 2) {
+        fprintf(stderr, "Usage: %s [-b] oldIndexFilename newIndexFilename\n", argv[0]);
         return 1;
     }
     
     // Get filenames from argument arrau
-    char* oldIndexFilename = argv[1];
-    char* newIndexFilename = argv[2];
+    char* oldIndexFilename = argv[first];
+    char* newIndexFilename = argv[first + 1];
     
     // Load the index from old file
     index_t* index = index_load(oldIndexFilename);
@@ -31,7 +38,7 @@ int main(int argc, char* argv[]) {
     }
     
     // Write the index to new file
-    if (!index_save(index, newIndexFilename)) {
+    if (!(binary ? index_saveBinary(index, newIndexFilename) : index_save(index, newIndexFilename))) {
         fprintf(stderr, "Error: failed to save index to %s\n", newIndexFilename);
         index_delete(index);
         return 1;
@@ -6,7 +6,7 @@ chmod +x indexer
 chmod +x indextest
 
 # Clean up any previous files
-rm -f index.dat index2.dat
+rm -f index.dat index2.dat index3.dat index.bin
 
 # Driver function to test indexer with valid crawler directory
 test_valid_indexer() {
@@ -42,6 +42,23 @@ echo "Test 3: Too many parameters"
 ./indexer ../data/letters-2 index.dat extra
 echo ""
 
+# Test 3b: Invalid thread count
+echo "Test 3b: Invalid thread count"
+./indexer -t 0 ../data/letters-2 index.dat
+echo ""
+
+# Test 3c: Invalid memory budget
+echo "Test 3c: Invalid memory budget"
+./indexer -m 0 ../data/letters-2 index.dat
+echo ""
+
+# Test 3d: Updating an index while building it with several threads, or with one thread, or in runs
+echo "Test 3d: -u with -t"
+./indexer -u -t 2 ../data/letters-2 index.dat
+./indexer -t 1 -u ../data/letters-2 index.dat
+./indexer -t 1 -m 4 ../data/letters-2 index.dat
+echo ""
+
 # Test 4: Invalid pageDirectory (non-existent)
 echo "Test 4: Invalid pageDirectory (non-existent path)"
 ./indexer /nonexistent/path index.dat
@@ -89,6 +106,88 @@ if [ -f index.dat ]; then
     else
         echo "Index files differ!"
     fi
+    echo ""
+
+    # Convert to binary and back again; the result should be the same index
+    echo "Test 10b: Converting index to binary format and back"
+    ./indextest -b index.dat index.bin
+    ./indextest index.bin index3.dat
+    if ~/cs50-dev/shared/tse/indexcmp index.dat index3.dat; then
+        echo "Index files are identical"
+    else
+        echo "Index files differ!"
+    fi
+    echo ""
+
+    # Build the index again with 4 threads; the result should be the same index
+    echo "Test 10c: Building index with 4 threads"
+    ./indexer -t 4 ../data/letters-2 index3.dat
+    if ~/cs50-dev/shared/tse/indexcmp index.dat index3.dat; then
+        echo "Index files are identical"
+    else
+        echo "Index files differ!"
+    fi
+    echo ""
+
+    # Build an index too big for 1 MB in runs of at most 1 MB, merged level by level; letters-2 would fit in one
+    # run, so the pages are 1000 made-up ones of 400 words each, drawn from 100,000 with a skew toward the first
+    echo "Test 10d: Building index in 1 MB runs"
+    rm -rf synthetic
+    mkdir synthetic
+    touch synthetic/.crawler
+    awk 'BEGIN { srand(1)
+        for (d = 1; d <= 1000; d++) {
+            f = "synthetic/" d
+            printf "http://synthetic/%d\n0\n<html>", d > f
+            for (w = 0; w < 400; w++) {
+                n = int(100000 ^ rand()); s = "w"
+                do { s = s substr("abcdefghijklmnopqrstuvwxyz", n % 26 + 1, 1); n = int(n / 26) } while (n > 0)
+                printf " %s", s > f
+            }
+            print "</html>" > f
+            close(f)
+        } }'
+    ./indexer synthetic index4.dat
+    ./indexer -m 1 synthetic index3.dat
+    if ~/cs50-dev/shared/tse/indexcmp index4.dat index3.dat; then
+        echo "Index files are identical"
+    else
+        echo "Index files differ!"
+    fi
+    ls index3.dat.run* 2>/dev/null && echo "Run files were left behind!"
+    echo ""
+
+    # Index the same pages a quarter at a time with -u, into the index and three segments of it; indextest
+    # reads the index with its segments, so what it writes should be the index built all at once
+    echo "Test 10e: Converting an index updated with -u"
+    rm -rf synthetic.u index5.dat*
+    mkdir synthetic.u
+    cp synthetic/.crawler synthetic.u
+    for last in 250 500 750 1000; do
+        for ((d = last - 249; d <= last; d++)); do
+            cp "synthetic/$d" synthetic.u
+        done
+        ./indexer -u synthetic.u index5.dat
+    done
+    cat index5.dat.segments
+    ./indextest index5.dat index3.dat
+    if ~/cs50-dev/shared/tse/indexcmp index4.dat index3.dat; then
+        echo "Index files are identical"
+    else
+        echo "Index files differ!"
+    fi
+    echo ""
+
+    # Crawl again into the same directory: the crawler starts over at docID 1, so the pages the index holds are
+    # not those there now, and the update must refuse rather than keep the old pages' postings
+    echo "Test 10f: Updating an index from a directory crawled again"
+    rm -f synthetic.u/[0-9]*
+    for ((d = 1; d <= 1001; d++)); do
+        cp "synthetic/$(( d % 1000 + 1 ))" "synthetic.u/$d"
+    done
+    ./indexer -u synthetic.u index5.dat
+    cat index5.dat.segments
+    rm -rf synthetic synthetic.u index4.dat index5.dat*
 fi
 
 #### 3. Memory Tests
@@ -106,5 +205,5 @@ valgrind --leak-check=full --show-leak-kinds=all ./indextest index.dat index2.da
 echo ""
 
 # Clean up
-rm -f index.dat index2.dat
+rm -f index.dat index2.dat index3.dat index.bin
 echo "All tests completed."
\ No newline at end of file
@@ -0,0 +1,216 @@
+/*
+* wordbench.c - Checks the word scanner (wordscan_next) against webpage_getNextWord, with strlen, normalizeWord
+*               and free, as the indexer used to take words, and times both: over the pages of a page directory,
+*               and over random html built to hit tags, long words and the ends of 16-byte blocks.
+* @author: Aniket Dey
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "../libcs50/webpage.h"
+#include "../common/pagestore.h"
+#include "../common/word.h"
+
+// Global Constants
+static const int DEFAULT_ROUNDS = 20; // passes over the pages per measurement
+static const int RANDOM_PAGES = 2000; // random pages checked
+static const int MIN_LENGTH = 3; // as the indexer takes words
+static const char ALPHABET[] = "abcXYZ<> .\n\x80\xe1"; // letters, tags, and bytes that are not letters
+
+// Function Prototypes
+static bool sameWords(webpage_t* page, long* numWords);
+static long oldScan(webpage_t* page);
+static long newScan(webpage_t* page);
+static webpage_t* randomPage(void);
+static double nowNs(void);
+
+/*
+* main(): Checks and times both scans over a page directory, then checks them over random pages
+* Params: number of command-line arguments (argc), array of command-line arguments (argv)
+* Returns: 0 if the scans agree, 1 if they do not or on error
+*/
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s pageDirectory [rounds]\n", argv[0]);
+        return 1;
+    }
+    int rounds = (argc == 3) ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) {
+        fprintf(stderr, "Error: rounds must be a positive integer\n");
+        return 1;
+    }
+    pagestore_t* store = pagestore_open(argv[1]);
+    if (store == NULL) {
+        fprintf(stderr, "Error: cannot open page directory '%s'\n", argv[1]);
+        return 1;
+    }
+
+    // Check every page, counting its words and bytes
+    bool ok = true;
+    int numPages = 0;
+    long numWords = 0;
+    size_t bytes = 0;
+    webpage_t* page;
+    while ((page = pagestore_load(store, numPages + 1)) != NULL) {
+        ok = sameWords(page, &numWords) && ok;
+        bytes += webpage_getHTMLLength(page);
+        webpage_delete(page);
+        numPages++;
+    }
+    printf("%d pages, %zu bytes, %ld words of %d or more letters\n", numPages, bytes, numWords, MIN_LENGTH);
+
+    // Time each scan over all the pages, loaded once
+    webpage_t** pages = malloc((numPages + 1) * sizeof(webpage_t*));
+    if (pages == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        pagestore_close(store);
+        return 1;
+    }
+    for (int i = 0; i < numPages; i++) {
+        pages[i] = pagestore_load(store, i + 1);
+    }
+    long (*scans[])(webpage_t*) = { oldScan, newScan };
+    const char* names[] = { "getNextWord", "wordscan" };
+    for (int s = 0; s < 2; s++) {
+        long found = 0;
+        double start = nowNs();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < numPages; i++) {
+                found += (*scans[s])(pages[i]);
+            }
+        }
+        double ns = nowNs() - start;
+        printf("%-12s %8.1f ms a pass, %6.1f MB/s (%ld words)\n", names[s], ns / rounds / 1e6,
+               bytes * (double)rounds / (ns / 1e9) / 1e6, found / rounds);
+    }
+    for (int i = 0; i < numPages; i++) {
+        webpage_delete(pages[i]);
+    }
+    free(pages);
+    pagestore_close(store);
+
+    // Random pages
+    srand(42);
+    long randomWords = 0;
+    for (int i = 0; i < RANDOM_PAGES; i++) {
+        page = randomPage();
+        if (page == NULL) {
+            fprintf(stderr, "Error: out of memory\n");
+            return 1;
+        }
+        ok = sameWords(page, &randomWords) && ok;
+        webpage_delete(page);
+    }
+    printf("%d random pages, %ld words\n", RANDOM_PAGES, randomWords);
+    printf("%s\n", ok ? "scans agree" : "SCANS DISAGREE");
+    return ok ? 0 : 1;
+}
+
+/*
+* sameWords(): Tells whether both scans find the same words in a page
+* Params: the page (page), a count to add its words to (numWords)
+* Returns: true if they do; otherwise false, printing the first difference
+*/
+static bool sameWords(webpage_t* page, long* numWords) {
+    wordscan_t scan;
+    wordscan_open(&scan, webpage_getHTML(page), webpage_getHTMLLength(page), MIN_LENGTH);
+    int position = 0;
+    char* word;
+    bool same = true;
+    while (same && (word = webpage_getNextWord(page, &position)) != NULL) {
+        if (strlen(word) >= MIN_LENGTH) {
+            normalizeWord(word);
+            int length;
+            const char* found = wordscan_next(&scan, &length);
+            if (found == NULL || length != strlen(word) || strcmp(found, word) != 0) {
+                printf("%s: expected '%s', found '%s'\n", webpage_getURL(page), word, (found != NULL) ? found : "(none)");
+                same = false;
+            }
+            (*numWords)++;
+        }
+        free(word);
+    }
+    if (same && wordscan_next(&scan, NULL) != NULL) {
+        printf("%s: found a word past the last\n", webpage_getURL(page));
+        same = false;
+    }
+    wordscan_close(&scan);
+    return same;
+}
+
+/*
+* oldScan(): Takes a page's words as the indexer used to: a copy of each word, strlen, normalizeWord, free
+* Params: the page (page)
+* Returns: the number of words of at least MIN_LENGTH letters
+*/
+static long oldScan(webpage_t* page) {
+    long found = 0;
+    int position = 0;
+    char* word;
+    while ((word = webpage_getNextWord(page, &position)) != NULL) {
+        if (strlen(word) >= MIN_LENGTH) {
+            normalizeWord(word);
+            found++;
+        }
+        free(word);
+    }
+    return found;
+}
+
+/*
+* newScan(): Takes a page's words with the word scanner
+* Params: the page (page)
+* Returns: the number of words of at least MIN_LENGTH letters
+*/
+static long newScan(webpage_t* page) {
+    long found = 0;
+    wordscan_t scan;
+    wordscan_open(&scan, webpage_getHTML(page), webpage_getHTMLLength(page), MIN_LENGTH);
+    while (wordscan_next(&scan, NULL) != NULL) {
+        found++;
+    }
+    wordscan_close(&scan);
+    return found;
+}
+
+/*
+* randomPage(): Makes a page of random html, of random length, in runs of one byte from ALPHABET;
+*               a run of letters is now and then much longer than a word buffer
+* Params: None
+* Returns: the page, which the caller deletes; null if out of memory
+*/
+static webpage_t* randomPage(void) {
+    int length = rand() % 600;
+    char* html = malloc(length + 1);
+    char* url = malloc(sizeof("random"));
+    if (html == NULL || url == NULL) {
+        free(html);
+        free(url);
+        return NULL;
+    }
+    strcpy(url, "random");
+    for (int at = 0; at < length; ) {
+        char c = ALPHABET[rand() % (sizeof(ALPHABET) - 1)];
+        int run = (rand() % 50 == 0) ? rand() % 300 : 1 + rand() % 20;
+        for ( ; run > 0 && at < length; run--) {
+            html[at++] = c;
+        }
+    }
+    html[length] = '\0';
+    return webpage_new(url, 0, html);
+}
+
+/*
+* nowNs(): Reads the monotonic clock
+* Params: None
+* Returns: the time in nanoseconds
+*/
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
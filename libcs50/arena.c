@@ -0,0 +1,111 @@
+/*
+ * arena.c - arena (region) allocator module
+ *
+ * See arena.h for usage.
+ *
+ * Blocks are chained, newest first; each allocation is rounded up to the
+ * alignment of max_align_t and taken from the front block's free space.
+ * When that is too small, a new block becomes the front one.  An
+ * allocation bigger than a block gets a block of its own, chained behind
+ * the front one, so the front one's free space is not wasted.
+ *
+ * Aniket Dey, 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "arena.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+static const size_t DEFAULT_BLOCK = 1 << 20;    // bytes in a block, by default
+enum { ALIGN = _Alignof(max_align_t) };
+
+/**************** local types ****************/
+typedef struct block {
+  struct block* next;       // the block filled before this one
+  size_t used;              // bytes of data in use
+  size_t size;              // bytes of data allocated
+  _Alignas(ALIGN) unsigned char data[];
+} block_t;
+
+/**************** global types ****************/
+typedef struct arena {
+  block_t* blocks;          // block now being filled, or NULL
+  size_t blockSize;         // bytes of data in a block
+  size_t bytes;             // bytes allocated for blocks
+} arena_t;
+
+/**************** arena_new ****************/
+/* see arena.h for description */
+arena_t*
+arena_new(const size_t blockSize)
+{
+  arena_t* arena = mem_malloc(sizeof(arena_t));
+  if (arena == NULL) {
+    return NULL;
+  }
+  arena->blocks = NULL;
+  arena->blockSize = blockSize > 0 ? blockSize : DEFAULT_BLOCK;
+  arena->bytes = 0;
+  return arena;
+}
+
+/**************** arena_alloc ****************/
+/* see arena.h for description */
+void*
+arena_alloc(arena_t* arena, const size_t size)
+{
+  if (arena == NULL || size == 0 || size > SIZE_MAX - ALIGN) {
+    return NULL;
+  }
+  size_t need = (size + ALIGN - 1) / ALIGN * ALIGN;
+
+  block_t* block = arena->blocks;
+  if (block == NULL || block->size - block->used < need) {
+    size_t bytes = need > arena->blockSize ? need : arena->blockSize;
+    block = mem_malloc(sizeof(block_t) + bytes);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->used = 0;
+    block->size = bytes;
+    arena->bytes += sizeof(block_t) + bytes;
+    if (bytes > arena->blockSize && arena->blocks != NULL) {
+      block->next = arena->blocks->next;
+      arena->blocks->next = block;
+    } else {
+      block->next = arena->blocks;
+      arena->blocks = block;
+    }
+  }
+
+  void* p = block->data + block->used;
+  block->used += need;
+  return p;
+}
+
+/**************** arena_bytes ****************/
+/* see arena.h for description */
+size_t
+arena_bytes(const arena_t* arena)
+{
+  return arena != NULL ? arena->bytes : 0;
+}
+
+/**************** arena_delete ****************/
+/* see arena.h for description */
+void
+arena_delete(arena_t* arena)
+{
+  if (arena != NULL) {
+    while (arena->blocks != NULL) {
+      block_t* next = arena->blocks->next;
+      mem_free(arena->blocks);
+      arena->blocks = next;
+    }
+    mem_free(arena);
+  }
+}
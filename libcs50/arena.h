@@ -0,0 +1,66 @@
+/*
+ * arena.h - header file for the arena (region) allocator module
+ *
+ * An *arena* hands out memory from large blocks, a bump of a pointer at a
+ * time, and frees it all at once, when the arena is deleted; nothing it
+ * hands out can be freed on its own.  It suits many small allocations
+ * that all live as long as one structure does: they cost no malloc each,
+ * lie next to one another in memory, and are released in one sweep over
+ * the blocks rather than one free apiece.
+ *
+ * An arena is not safe to use from several threads at once.
+ *
+ * Aniket Dey, 2025
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <stddef.h>
+
+/**************** global types ****************/
+typedef struct arena arena_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** arena_new ****************/
+/* Create a new (empty) arena.
+ *
+ * Caller provides:
+ *   the size in bytes of the blocks to allocate from (0 for a default);
+ *   an allocation bigger than a block gets a block of its own.
+ * We return:
+ *   pointer to the new arena; return NULL if error.
+ * Caller is responsible for:
+ *   later calling arena_delete.
+ */
+arena_t* arena_new(const size_t blockSize);
+
+/**************** arena_alloc ****************/
+/* Allocate size bytes from the arena.
+ *
+ * Caller provides:
+ *   valid pointer to arena, size in bytes (> 0).
+ * We return:
+ *   pointer to the memory, aligned for any type, uninitialized;
+ *   NULL if arena is NULL, size is 0, or out of memory.
+ * Notes:
+ *   The memory lasts until arena_delete; do not free it.
+ */
+void* arena_alloc(arena_t* arena, const size_t size);
+
+/**************** arena_bytes ****************/
+/* Return the number of bytes the arena has allocated for its blocks,
+ * or 0 if arena is NULL.
+ */
+size_t arena_bytes(const arena_t* arena);
+
+/**************** arena_delete ****************/
+/* Delete the arena, freeing everything allocated from it at once.
+ *
+ * Caller provides:
+ *   valid pointer to arena, or NULL (then we do nothing).
+ */
+void arena_delete(arena_t* arena);
+
+#endif // __ARENA_H
@@ -0,0 +1,179 @@
+/*
+ * connpool.c - pool of idle, persistent connections to web servers
+ *
+ * See connpool.h for usage.
+ *
+ * The pool is a hashtable from "hostname:port" to a small stack of idle
+ * sockets, all guarded by one mutex.  The most recently returned socket is
+ * taken first, since it is the least likely to have been closed by the server.
+ *
+ * Aniket Dey, 2025
+ */
+
+#define _GNU_SOURCE       // MSG_DONTWAIT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "connpool.h"
+#include "hashtable.h"
+#include "mem.h"
+
+/**************** local types ****************/
+#define MAX_HOSTNAME 253          // longest DNS name; sizes the key buffer
+
+typedef struct idle {
+  int* socks;               // stack of idle sockets
+  int count;
+} idle_t;
+
+typedef struct connpool {
+  hashtable_t* hosts;       // "hostname:port" -> idle_t*
+  int maxIdle;              // most idle sockets per host:port
+  pthread_mutex_t lock;
+} connpool_t;
+
+/**************** file-local constants ****************/
+static const int HOST_SLOTS = 31;   // slots in the host hashtable
+
+/**************** local functions ****************/
+static idle_t* findIdle(connpool_t* pool, const char* hostname, const int port, const bool add);
+static bool isAlive(const int sock);
+static void idleDelete(void* item);
+
+/**************** connpool_new ****************/
+/* see connpool.h for description */
+connpool_t*
+connpool_new(const int maxIdle)
+{
+  if (maxIdle <= 0) {
+    return NULL;
+  }
+  connpool_t* pool = mem_malloc(sizeof(connpool_t));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->hosts = hashtable_new(HOST_SLOTS);
+  if (pool->hosts == NULL) {
+    mem_free(pool);
+    return NULL;
+  }
+  pool->maxIdle = maxIdle;
+  pthread_mutex_init(&pool->lock, NULL);
+  return pool;
+}
+
+/**************** connpool_take ****************/
+/* see connpool.h for description */
+int
+connpool_take(connpool_t* pool, const char* hostname, const int port)
+{
+  if (pool == NULL || hostname == NULL) {
+    return -1;
+  }
+  int sock = -1;
+  pthread_mutex_lock(&pool->lock);
+  idle_t* idle = findIdle(pool, hostname, port, false);
+  while (idle != NULL && idle->count > 0 && sock < 0) {
+    sock = idle->socks[--idle->count];
+    if (!isAlive(sock)) {
+      close(sock);
+      sock = -1;
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return sock;
+}
+
+/**************** connpool_give ****************/
+/* see connpool.h for description */
+void
+connpool_give(connpool_t* pool, const char* hostname, const int port, const int sock)
+{
+  if (sock < 0) {
+    return;
+  }
+  if (pool == NULL || hostname == NULL) {
+    close(sock);
+    return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  idle_t* idle = findIdle(pool, hostname, port, true);
+  if (idle != NULL && idle->count < pool->maxIdle) {
+    idle->socks[idle->count++] = sock;
+  } else {
+    close(sock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**************** connpool_delete ****************/
+/* see connpool.h for description */
+void
+connpool_delete(connpool_t* pool)
+{
+  if (pool != NULL) {
+    hashtable_delete(pool->hosts, idleDelete);
+    pthread_mutex_destroy(&pool->lock);
+    mem_free(pool);
+  }
+}
+
+/**************** findIdle ****************/
+/* Find the idle sockets for hostname:port, adding an empty stack
+ * for them if there is none and add is true.  Caller holds the lock.
+ */
+static idle_t*
+findIdle(connpool_t* pool, const char* hostname, const int port, const bool add)
+{
+  if (strlen(hostname) > MAX_HOSTNAME) {
+    return NULL;                // no such host
+  }
+  char key[MAX_HOSTNAME + 16];
+  sprintf(key, "%s:%d", hostname, port);
+  idle_t* idle = hashtable_find(pool->hosts, key);
+  if (idle == NULL && add) {
+    idle = mem_malloc(sizeof(idle_t));
+    if (idle == NULL) {
+      return NULL;
+    }
+    idle->count = 0;
+    idle->socks = mem_calloc(pool->maxIdle, sizeof(int));
+    if (idle->socks == NULL || !hashtable_insert(pool->hosts, key, idle)) {
+      idleDelete(idle);
+      return NULL;
+    }
+  }
+  return idle;
+}
+
+/**************** isAlive ****************/
+/* Is an idle socket still open at the server's end?
+ * A socket between responses has nothing to read, so anything
+ * readable - end of file, an error, or stray bytes - means it is unusable.
+ */
+static bool
+isAlive(const int sock)
+{
+  char c;
+  ssize_t n = recv(sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+/**************** idleDelete ****************/
+static void
+idleDelete(void* item)
+{
+  idle_t* idle = item;
+  if (idle != NULL) {
+    for (int i = 0; i < idle->count; i++) {
+      close(idle->socks[i]);
+    }
+    mem_free(idle->socks);
+    mem_free(idle);
+  }
+}
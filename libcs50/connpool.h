@@ -0,0 +1,69 @@
+/*
+ * connpool.h - pool of idle, persistent connections to web servers
+ *
+ * A *connpool* holds open sockets whose last HTTP/1.1 response ended
+ * cleanly and whose server agreed to keep the connection alive.  Fetching
+ * another page from the same host:port can then take one of these sockets
+ * instead of looking up the host and making a new TCP connection.
+ *
+ * Each host:port keeps at most maxIdle sockets; more are simply closed.
+ * A server may close an idle socket at any time, so a pooled socket can
+ * turn out to be dead when used; callers should retry once on a fresh
+ * connection if a reused socket fails before any response arrives.
+ *
+ * All functions are safe to call from several threads at once.
+ *
+ * Aniket Dey, 2025
+ */
+
+#ifndef __CONNPOOL_H
+#define __CONNPOOL_H
+
+#include <stdbool.h>
+
+/**************** global types ****************/
+typedef struct connpool connpool_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** connpool_new ****************/
+/* Create an empty pool.
+ *
+ * Caller provides:
+ *   the most idle sockets to keep for any one host:port (must be > 0).
+ * We return:
+ *   pointer to new pool, or NULL on error.
+ * Caller is responsible for:
+ *   later calling connpool_delete.
+ */
+connpool_t* connpool_new(const int maxIdle);
+
+/**************** connpool_take ****************/
+/* Take an idle socket connected to hostname:port, if there is one.
+ *
+ * Caller provides:
+ *   valid pool, hostname, and port.
+ * We return:
+ *   a connected socket, now owned by the caller; or -1 if none is idle.
+ *   Sockets the server has already closed are discarded, not returned.
+ */
+int connpool_take(connpool_t* pool, const char* hostname, const int port);
+
+/**************** connpool_give ****************/
+/* Return a socket to the pool, to be reused for hostname:port.
+ *
+ * Caller provides:
+ *   valid pool, hostname, port, and a socket connected there that is
+ *   between responses (nothing unread, no request outstanding).
+ * We guarantee:
+ *   the pool owns the socket; it is closed if the pool is full for that
+ *   host:port, or on error.
+ */
+void connpool_give(connpool_t* pool, const char* hostname, const int port, const int sock);
+
+/**************** connpool_delete ****************/
+/* Close every idle socket and free the pool.  Ignore NULL pool.
+ */
+void connpool_delete(connpool_t* pool);
+
+#endif // __CONNPOOL_H
@@ -0,0 +1,280 @@
+/*
+ * dnscache.c - thread-safe cache of host name lookups
+ *
+ * See dnscache.h for usage.
+ *
+ * The cache is a hashtable from host name to the addresses last found for
+ * it and when they expire, guarded by one mutex.  The mutex is never held
+ * across a call to getaddrinfo, so a slow lookup of one name doesn't hold
+ * up lookups of names already cached; two threads that miss on the same
+ * name at once may both ask the resolver, and the later answer is kept.
+ *
+ * Aniket Dey, 2025
+ */
+
+#define _GNU_SOURCE       // getaddrinfo, strtok_r, clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include "dnscache.h"
+#include "hashtable.h"
+#include "file.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+#define MAX_ADDRS 8                     // addresses kept per name
+static const int NAME_SLOTS = 31;       // slots in the hashtable
+static const int TTL = 300;             // seconds to keep an answer
+static const int NEGATIVE_TTL = 10;     // seconds to remember a failed lookup
+
+/**************** local types ****************/
+typedef struct entry {
+  dnsaddr_t addrs[MAX_ADDRS];   // port 0, filled in on the way out, unless a hosts file gave one
+  int count;                    // 0 if the name did not resolve
+  long long expires;            // when to ask the resolver again (s)
+  bool fixed;                   // from a hosts file; never expires
+} entry_t;
+
+/**************** global variables ****************/
+static hashtable_t* cache = NULL;           // name -> entry_t*
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;   // guards the cache
+
+/**************** local functions ****************/
+static entry_t* findEntry(const char* hostname, const bool add);
+static int copyOut(const entry_t* entry, const int port, dnsaddr_t* addrs, const int max);
+static bool parseAddress(const char* text, dnsaddr_t* addr);
+static long long nowSec(void);
+static void entryDelete(void* item);
+
+/**************** dnscache_resolve ****************/
+/* see dnscache.h for description */
+int
+dnscache_resolve(const char* hostname, const int port, dnsaddr_t* addrs, const int max)
+{
+  if (hostname == NULL || addrs == NULL || max <= 0) {
+    return 0;
+  }
+
+  // answer from the cache, if we can
+  pthread_mutex_lock(&lock);
+  entry_t* entry = findEntry(hostname, false);
+  if (entry != NULL && (entry->fixed || entry->expires > nowSec())) {
+    int count = copyOut(entry, port, addrs, max);
+    pthread_mutex_unlock(&lock);
+    return count;
+  }
+  pthread_mutex_unlock(&lock);
+
+  // otherwise ask the resolver, without holding the lock
+  entry_t fresh = { .count = 0, .fixed = false };
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;          // IPv4 and IPv6 alike
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* result = NULL;
+  if (getaddrinfo(hostname, NULL, &hints, &result) == 0) {
+    for (struct addrinfo* ai = result; ai != NULL && fresh.count < MAX_ADDRS; ai = ai->ai_next) {
+      if ((ai->ai_family == AF_INET || ai->ai_family == AF_INET6)
+          && ai->ai_addrlen <= sizeof(struct sockaddr_storage)) {
+        memcpy(&fresh.addrs[fresh.count].addr, ai->ai_addr, ai->ai_addrlen);
+        fresh.addrs[fresh.count].len = ai->ai_addrlen;
+        fresh.count++;
+      }
+    }
+    freeaddrinfo(result);
+  }
+
+  // remember the answer, unless a hosts file has claimed the name meanwhile
+  pthread_mutex_lock(&lock);
+  fresh.expires = nowSec() + (fresh.count > 0 ? TTL : NEGATIVE_TTL);
+  entry = findEntry(hostname, true);
+  if (entry != NULL && !entry->fixed) {
+    *entry = fresh;
+  }
+  int count = copyOut(entry != NULL ? entry : &fresh, port, addrs, max);
+  pthread_mutex_unlock(&lock);
+  return count;
+}
+
+/**************** dnscache_loadHosts ****************/
+/* see dnscache.h for description */
+bool
+dnscache_loadHosts(const char* filename)
+{
+  FILE* fp = (filename == NULL) ? NULL : fopen(filename, "r");
+  if (fp == NULL) {
+    return false;
+  }
+  bool ok = true;
+  char* line;
+  pthread_mutex_lock(&lock);
+  while (ok && (line = file_readLine(fp)) != NULL) {
+    char* comment = strchr(line, '#');
+    if (comment != NULL) {
+      *comment = '\0';
+    }
+    char* save;
+    char* address = strtok_r(line, " \t\r\n", &save);
+    dnsaddr_t addr;
+    if (address != NULL && !(ok = parseAddress(address, &addr))) {
+      fprintf(stderr, "dnscache: bad address '%s' in %s\n", address, filename);
+    }
+    for (char* name = NULL; ok && address != NULL && (name = strtok_r(NULL, " \t\r\n", &save)) != NULL; ) {
+      entry_t* entry = findEntry(name, true);
+      if (entry == NULL) {
+        ok = false;
+        break;
+      }
+      if (!entry->fixed) {
+        entry->fixed = true;            // the file overrides what the resolver said
+        entry->count = 0;
+      }
+      if (entry->count < MAX_ADDRS) {
+        entry->addrs[entry->count++] = addr;
+      }
+    }
+    free(line);
+  }
+  pthread_mutex_unlock(&lock);
+  fclose(fp);
+  return ok;
+}
+
+/**************** dnscache_flush ****************/
+/* see dnscache.h for description */
+void
+dnscache_flush(void)
+{
+  pthread_mutex_lock(&lock);
+  hashtable_delete(cache, entryDelete);
+  cache = NULL;
+  pthread_mutex_unlock(&lock);
+}
+
+/**************** findEntry ****************/
+/* Find the entry for hostname; if there is none and add is true,
+ * add an empty, already-expired one.  Caller holds the lock.
+ */
+static entry_t*
+findEntry(const char* hostname, const bool add)
+{
+  if (cache == NULL) {
+    if (!add || (cache = hashtable_new(NAME_SLOTS)) == NULL) {
+      return NULL;
+    }
+  }
+  entry_t* entry = hashtable_find(cache, hostname);
+  if (entry == NULL && add) {
+    entry = mem_calloc(1, sizeof(entry_t));
+    if (entry != NULL && !hashtable_insert(cache, hostname, entry)) {
+      mem_free(entry);
+      entry = NULL;
+    }
+  }
+  return entry;
+}
+
+/**************** copyOut ****************/
+/* Copy up to max of entry's addresses to addrs, with port filled in
+ * where the address has none of its own; return how many were copied.
+ */
+static int
+copyOut(const entry_t* entry, const int port, dnsaddr_t* addrs, const int max)
+{
+  int count = (entry->count < max) ? entry->count : max;
+  for (int i = 0; i < count; i++) {
+    addrs[i] = entry->addrs[i];
+    in_port_t* at = (addrs[i].addr.ss_family == AF_INET)
+                    ? &((struct sockaddr_in*)&addrs[i].addr)->sin_port
+                    : &((struct sockaddr_in6*)&addrs[i].addr)->sin6_port;
+    if (*at == 0) {
+      *at = htons(port);
+    }
+  }
+  return count;
+}
+
+/**************** parseAddress ****************/
+/* Parse a numeric IPv4 or IPv6 address into addr, with the port after
+ * it, as in "127.0.0.1:8080" or "[::1]:8080", or else port 0;
+ * return false if text is neither, or the port is not 1-65535.
+ */
+static bool
+parseAddress(const char* text, dnsaddr_t* addr)
+{
+  memset(addr, 0, sizeof(*addr));
+  struct sockaddr_in* in4 = (struct sockaddr_in*)&addr->addr;
+  struct sockaddr_in6* in6 = (struct sockaddr_in6*)&addr->addr;
+
+  // split off the port, if any: after the ']' of "[v6]:port", or after the
+  // only ':' of "v4:port" (a bare IPv6 address has several)
+  const char* start = text;
+  size_t len = strlen(text);
+  const char* portText = NULL;
+  if (text[0] == '[') {
+    const char* close = strchr(text, ']');
+    if (close == NULL || (close[1] != '\0' && close[1] != ':')) {
+      return false;
+    }
+    start = text + 1;
+    len = close - start;
+    portText = (close[1] == ':') ? close + 2 : NULL;
+  } else {
+    const char* colon = strchr(text, ':');
+    if (colon != NULL && strchr(colon + 1, ':') == NULL) {
+      len = colon - text;
+      portText = colon + 1;
+    }
+  }
+  long port = 0;
+  if (portText != NULL) {
+    char* end;
+    port = strtol(portText, &end, 10);
+    if (*end != '\0' || port < 1 || port > 65535) {
+      return false;
+    }
+  }
+  char host[INET6_ADDRSTRLEN];
+  if (len >= sizeof(host)) {
+    return false;
+  }
+  memcpy(host, start, len);
+  host[len] = '\0';
+
+  if (inet_pton(AF_INET, host, &in4->sin_addr) == 1) {
+    in4->sin_family = AF_INET;
+    in4->sin_port = htons(port);
+    addr->len = sizeof(struct sockaddr_in);
+    return true;
+  }
+  if (inet_pton(AF_INET6, host, &in6->sin6_addr) == 1) {
+    in6->sin6_family = AF_INET6;
+    in6->sin6_port = htons(port);
+    addr->len = sizeof(struct sockaddr_in6);
+    return true;
+  }
+  return false;
+}
+
+/**************** nowSec ****************/
+/* Seconds on the monotonic clock. */
+static long long
+nowSec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/**************** entryDelete ****************/
+static void
+entryDelete(void* item)
+{
+  mem_free(item);
+}
@@ -0,0 +1,73 @@
+/*
+ * dnscache.h - thread-safe cache of host name lookups
+ *
+ * The fetch path asks dnscache_resolve for a server's addresses instead of
+ * calling the resolver itself.  The first lookup of a name goes to
+ * getaddrinfo, which returns both IPv4 and IPv6 addresses; the answer is
+ * kept for a time-to-live (TTL), so the thousands of fetches a crawl makes
+ * from one host cost a single resolver round trip.  Failed lookups are also
+ * remembered, for a shorter time, so a dead name doesn't stall each retry.
+ *
+ * getaddrinfo does not report the TTLs of the DNS records behind its
+ * answers, so one TTL, five minutes, applies to every name.
+ *
+ * Entries loaded from a hosts file (dnscache_loadHosts) override the
+ * resolver and never expire; this also makes it easy to point a crawl at a
+ * local stand-in server.
+ *
+ * There is one cache per process, shared by all callers; every function is
+ * safe to call from several threads at once.
+ *
+ * Aniket Dey, 2025
+ */
+
+#ifndef __DNSCACHE_H
+#define __DNSCACHE_H
+
+#include <stdbool.h>
+#include <sys/socket.h>
+
+/**************** global types ****************/
+// one address of a host, ready for socket() and connect()
+typedef struct dnsaddr {
+  struct sockaddr_storage addr;   // sockaddr_in or sockaddr_in6, port filled in
+  socklen_t len;                  // length of the address in addr
+} dnsaddr_t;
+
+/**************** functions ****************/
+
+/**************** dnscache_resolve ****************/
+/* Find the addresses of hostname, from the cache if possible.
+ *
+ * Caller provides:
+ *   hostname (a name or a numeric address), port,
+ *   an array of at least max dnsaddr_t to fill.
+ * We return:
+ *   the number of addresses stored in addrs (at most max), in the
+ *   resolver's order of preference; 0 if the name cannot be resolved.
+ */
+int dnscache_resolve(const char* hostname, const int port, dnsaddr_t* addrs, const int max);
+
+/**************** dnscache_loadHosts ****************/
+/* Read fixed host entries from a file in the format of /etc/hosts:
+ * lines of "address name [name...]", where '#' starts a comment.
+ * An address may also name a port, as in "127.0.0.1:8080" or
+ * "[::1]:8080"; connections to those names then go to that port,
+ * whatever port their URLs give, so a stand-in server need not be
+ * able to listen on port 80.
+ *
+ * We return:
+ *   true if the file was read; false if it could not be opened, or a line
+ *   has an address that is not valid IPv4 or IPv6, or a port not 1-65535.
+ * We guarantee:
+ *   names in the file resolve to its addresses, ahead of the resolver and
+ *   any cached answer, and never expire.
+ */
+bool dnscache_loadHosts(const char* filename);
+
+/**************** dnscache_flush ****************/
+/* Forget every cached answer and hosts-file entry, and free their memory.
+ */
+void dnscache_flush(void);
+
+#endif // __DNSCACHE_H
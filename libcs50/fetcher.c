@@ -0,0 +1,452 @@
+/*
+ * fetcher.c - event-driven engine that fetches many web pages at once
+ *
+ * See fetcher.h for usage.
+ *
+ * Each page in progress occupies a connection slot, which moves through
+ *     connecting -> sending the request -> receiving the response
+ * driven by epoll readiness events.  A slot whose connect fails is retried,
+ * up to MAX_TRY attempts in all, like webpage_fetch; a slot that makes no
+ * progress for TIMEOUT_MS fails.  Finished pages wait on a stack until the
+ * caller collects them with fetcher_next.
+ *
+ * Requests ask for HTTP/1.1 persistent connections.  When a response ends
+ * cleanly and the server keeps the connection open, its socket goes into
+ * the fetcher's connpool, and the next page for that host:port starts at
+ * "sending" with no lookup or handshake.  A reused socket that fails before
+ * any response arrives was probably closed by the server while idle, so
+ * that fetch starts over on a new connection.
+ *
+ * Aniket Dey, 2025
+ */
+
+#define _GNU_SOURCE       // SOCK_NONBLOCK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "fetcher.h"
+#include "connpool.h"
+#include "dnscache.h"
+#include "http.h"
+#include "webpage.h"
+#include "mem.h"
+
+/**************** local types ****************/
+#define MAX_ADDRS 4             // addresses of a host to try
+#define READ_CHUNK 65536        // bytes per read() call
+#define MAX_EVENTS 64           // events per epoll_wait
+
+typedef struct conn {
+  int fd;                       // socket, or -1 if the slot is free
+  bool connected;               // has connect() completed?
+  bool reused;                  // did the socket come from the pool?
+  int tries;                    // connect attempts so far
+  long long deadline;           // give up if no progress by then (ms)
+  webpage_t* page;              // page being fetched
+  char* hostname;               // server name and port, for the pool
+  int port;
+  dnsaddr_t addrs[MAX_ADDRS];   // server addresses, tried in turn
+  int naddrs;
+  char* request;                // HTTP request text
+  size_t requestLen, requestSent;
+  size_t received;              // response bytes read so far
+  httpresponse_t* resp;         // response parser
+} conn_t;
+
+typedef struct fetcher {
+  int epfd;                     // epoll instance watching every open socket
+  int maxInFlight;
+  int inFlight;                 // pages submitted and not yet returned
+  conn_t* conns;                // maxInFlight connection slots
+  int* freeSlots;               // stack of indices of free slots
+  int numFree;
+  webpage_t** donePages;        // stack of finished pages...
+  bool* doneOk;                 // ...and whether each succeeded
+  int numDone;
+  connpool_t* pool;             // idle persistent connections
+} fetcher_t;
+
+/**************** file-local constants ****************/
+static const int MAX_TRY = 3;           // connect attempts per page
+static const int TIMEOUT_MS = 30000;    // longest a fetch may stall
+
+/**************** local functions ****************/
+static long long nowMs(void);
+static void startConnect(fetcher_t* fetcher, conn_t* conn);
+static void handleEvent(fetcher_t* fetcher, conn_t* conn, const unsigned events);
+static void retryOrFail(fetcher_t* fetcher, conn_t* conn);
+static void finish(fetcher_t* fetcher, conn_t* conn, const bool ok);
+static void pushDone(fetcher_t* fetcher, webpage_t* page, const bool ok);
+
+/**************** fetcher_new ****************/
+/* see fetcher.h for description */
+fetcher_t*
+fetcher_new(const int maxInFlight)
+{
+  if (maxInFlight <= 0) {
+    return NULL;
+  }
+  fetcher_t* fetcher = mem_calloc(1, sizeof(fetcher_t));
+  if (fetcher == NULL) {
+    return NULL;
+  }
+  fetcher->epfd = epoll_create1(0);
+  fetcher->maxInFlight = maxInFlight;
+  fetcher->conns = mem_calloc(maxInFlight, sizeof(conn_t));
+  fetcher->freeSlots = mem_calloc(maxInFlight, sizeof(int));
+  fetcher->donePages = mem_calloc(maxInFlight, sizeof(webpage_t*));
+  fetcher->doneOk = mem_calloc(maxInFlight, sizeof(bool));
+  fetcher->pool = connpool_new(maxInFlight);
+  if (fetcher->epfd < 0 || fetcher->conns == NULL || fetcher->freeSlots == NULL
+      || fetcher->donePages == NULL || fetcher->doneOk == NULL || fetcher->pool == NULL) {
+    fetcher_delete(fetcher);
+    return NULL;
+  }
+  for (int i = 0; i < maxInFlight; i++) {
+    fetcher->conns[i].fd = -1;
+    fetcher->freeSlots[fetcher->numFree++] = maxInFlight - 1 - i;
+  }
+  return fetcher;
+}
+
+/**************** fetcher_submit ****************/
+/* see fetcher.h for description */
+bool
+fetcher_submit(fetcher_t* fetcher, webpage_t* page)
+{
+  if (fetcher == NULL || page == NULL || webpage_getURL(page) == NULL
+      || webpage_getHTML(page) != NULL || fetcher->inFlight >= fetcher->maxInFlight) {
+    return false;
+  }
+  fetcher->inFlight++;
+
+  char* hostname;
+  int port;
+  char* pathname;
+  if (!burstURL(webpage_getURL(page), &hostname, &port, &pathname)) {
+    pushDone(fetcher, page, false);
+    return true;
+  }
+
+  conn_t* conn = &fetcher->conns[fetcher->freeSlots[--fetcher->numFree]];
+  conn->page = page;
+  conn->hostname = hostname;
+  conn->port = port;
+  conn->tries = 0;
+  conn->naddrs = 0;
+  conn->requestSent = 0;
+  conn->received = 0;
+  if (conn->resp == NULL) {
+    conn->resp = http_new();        // kept with the slot, and reused
+  } else {
+    http_reset(conn->resp);
+  }
+
+  // HTTP/1.1 keeps the connection open unless either side says otherwise
+  const char* format = "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n";
+  int len = snprintf(NULL, 0, format, pathname, hostname);
+  conn->request = mem_malloc(len + 1);
+  if (conn->request != NULL) {
+    conn->requestLen = snprintf(conn->request, len + 1, format, pathname, hostname);
+  }
+  free(pathname);
+  if (conn->request == NULL || conn->resp == NULL) {
+    finish(fetcher, conn, false);
+    return true;
+  }
+
+  // an idle connection to the same server skips straight to sending
+  conn->fd = connpool_take(fetcher->pool, hostname, port);
+  if (conn->fd >= 0) {
+    conn->reused = true;
+    conn->connected = true;
+    conn->deadline = nowMs() + TIMEOUT_MS;
+    struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = conn };
+    if (epoll_ctl(fetcher->epfd, EPOLL_CTL_ADD, conn->fd, &ev) == 0) {
+      return true;
+    }
+    close(conn->fd);
+    conn->fd = -1;
+  }
+  conn->reused = false;
+  startConnect(fetcher, conn);
+  return true;
+}
+
+/**************** fetcher_next ****************/
+/* see fetcher.h for description */
+webpage_t*
+fetcher_next(fetcher_t* fetcher, const int timeoutMs, bool* fetched)
+{
+  if (fetcher == NULL) {
+    return NULL;
+  }
+  long long start = nowMs();
+  struct epoll_event events[MAX_EVENTS];
+
+  while (fetcher->numDone == 0 && fetcher->inFlight > 0) {
+    // sleep until an event, the nearest stall deadline, or the caller's timeout
+    long long now = nowMs();
+    long long wake = (timeoutMs < 0) ? now + TIMEOUT_MS : start + timeoutMs;
+    for (int i = 0; i < fetcher->maxInFlight; i++) {
+      if (fetcher->conns[i].fd >= 0 && fetcher->conns[i].deadline < wake) {
+        wake = fetcher->conns[i].deadline;
+      }
+    }
+    int wait = (wake > now) ? (int)(wake - now) : 0;
+
+    int n = epoll_wait(fetcher->epfd, events, MAX_EVENTS, wait);
+    if (n < 0 && errno != EINTR) {
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      handleEvent(fetcher, events[i].data.ptr, events[i].events);
+    }
+
+    // fail any fetch that has stalled too long
+    now = nowMs();
+    for (int i = 0; i < fetcher->maxInFlight; i++) {
+      if (fetcher->conns[i].fd >= 0 && fetcher->conns[i].deadline <= now) {
+        finish(fetcher, &fetcher->conns[i], false);
+      }
+    }
+    if (timeoutMs >= 0 && now - start >= timeoutMs) {
+      break;
+    }
+  }
+
+  if (fetcher->numDone == 0) {
+    return NULL;
+  }
+  fetcher->numDone--;
+  fetcher->inFlight--;
+  if (fetched != NULL) {
+    *fetched = fetcher->doneOk[fetcher->numDone];
+  }
+  return fetcher->donePages[fetcher->numDone];
+}
+
+/**************** fetcher_inFlight ****************/
+/* see fetcher.h for description */
+int
+fetcher_inFlight(const fetcher_t* fetcher)
+{
+  return fetcher ? fetcher->inFlight : 0;
+}
+
+/**************** fetcher_delete ****************/
+/* see fetcher.h for description */
+void
+fetcher_delete(fetcher_t* fetcher)
+{
+  if (fetcher == NULL) {
+    return;
+  }
+  if (fetcher->conns != NULL) {
+    for (int i = 0; i < fetcher->maxInFlight; i++) {
+      conn_t* conn = &fetcher->conns[i];
+      if (conn->fd >= 0) {
+        close(conn->fd);
+        webpage_delete(conn->page);
+        mem_free(conn->request);
+        free(conn->hostname);
+      }
+      http_delete(conn->resp);
+    }
+  }
+  for (int i = 0; fetcher->donePages != NULL && i < fetcher->numDone; i++) {
+    webpage_delete(fetcher->donePages[i]);
+  }
+  if (fetcher->epfd >= 0) {
+    close(fetcher->epfd);
+  }
+  mem_free(fetcher->conns);
+  mem_free(fetcher->freeSlots);
+  mem_free(fetcher->donePages);
+  mem_free(fetcher->doneOk);
+  connpool_delete(fetcher->pool);
+  mem_free(fetcher);
+}
+
+/**************** nowMs ****************/
+/* Milliseconds on the monotonic clock. */
+static long long
+nowMs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**************** startConnect ****************/
+/* Open a non-blocking socket for conn and begin connecting, to each of
+ * the server's addresses in turn on successive tries; epoll reports the
+ * socket writable once connected (or failed).  The host is looked up,
+ * through the DNS cache, the first time it is needed.
+ */
+static void
+startConnect(fetcher_t* fetcher, conn_t* conn)
+{
+  if (conn->naddrs == 0) {
+    conn->naddrs = dnscache_resolve(conn->hostname, conn->port, conn->addrs, MAX_ADDRS);
+  }
+  int maxTries = (conn->naddrs > MAX_TRY) ? conn->naddrs : MAX_TRY;
+  while (conn->naddrs > 0 && conn->tries < maxTries) {
+    dnsaddr_t* addr = &conn->addrs[conn->tries++ % conn->naddrs];
+    conn->fd = socket(addr->addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (conn->fd < 0) {
+      break;
+    }
+    conn->connected = false;
+    conn->deadline = nowMs() + TIMEOUT_MS;
+    if (connect(conn->fd, (struct sockaddr*)&addr->addr, addr->len) == 0
+        || errno == EINPROGRESS) {
+      struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = conn };
+      if (epoll_ctl(fetcher->epfd, EPOLL_CTL_ADD, conn->fd, &ev) == 0) {
+        return;
+      }
+    }
+    close(conn->fd);
+    conn->fd = -1;
+  }
+  finish(fetcher, conn, false);
+}
+
+/**************** handleEvent ****************/
+/* Advance conn as far as its socket allows: finish connecting,
+ * send what remains of the request, then read and parse the response.
+ */
+static void
+handleEvent(fetcher_t* fetcher, conn_t* conn, const unsigned events)
+{
+  if (!conn->connected) {
+    int err = 0;
+    socklen_t errlen = sizeof(err);
+    if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0 || err != 0) {
+      // connect failed; try again with a fresh socket
+      epoll_ctl(fetcher->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+      close(conn->fd);
+      conn->fd = -1;
+      startConnect(fetcher, conn);
+      return;
+    }
+    conn->connected = true;
+  }
+  conn->deadline = nowMs() + TIMEOUT_MS;
+
+  if (conn->requestSent < conn->requestLen) {
+    ssize_t n = send(conn->fd, conn->request + conn->requestSent,
+                     conn->requestLen - conn->requestSent, MSG_NOSIGNAL);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      retryOrFail(fetcher, conn);
+      return;
+    }
+    if (n > 0) {
+      conn->requestSent += n;
+    }
+    if (conn->requestSent == conn->requestLen) {
+      struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+      epoll_ctl(fetcher->epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+    }
+    return;
+  }
+
+  if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+    char buf[READ_CHUNK];
+    for (;;) {
+      ssize_t n = read(conn->fd, buf, sizeof(buf));
+      if (n > 0) {
+        conn->received += n;
+        http_status_t status = http_parse(conn->resp, buf, n, NULL);
+        if (status != HTTP_MORE) {
+          finish(fetcher, conn, status == HTTP_DONE);
+          return;
+        }
+      } else if (n == 0) {
+        if (http_finish(conn->resp) == HTTP_DONE) {
+          finish(fetcher, conn, true);
+        } else {
+          retryOrFail(fetcher, conn);
+        }
+        return;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;                     // wait for more
+      } else if (errno != EINTR) {
+        retryOrFail(fetcher, conn);
+        return;
+      }
+    }
+  }
+}
+
+/**************** retryOrFail ****************/
+/* conn's socket failed.  If it was reused from the pool and died before
+ * any response arrived, start over on a new connection; otherwise the
+ * fetch fails.
+ */
+static void
+retryOrFail(fetcher_t* fetcher, conn_t* conn)
+{
+  if (!conn->reused || conn->received > 0) {
+    finish(fetcher, conn, false);
+    return;
+  }
+  epoll_ctl(fetcher->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+  close(conn->fd);
+  conn->fd = -1;
+  conn->reused = false;
+  conn->requestSent = 0;
+  http_reset(conn->resp);
+  startConnect(fetcher, conn);
+}
+
+/**************** finish ****************/
+/* Close conn's socket, or pool it if the server will keep it open;
+ * hand its page back with html if the response was a non-empty 200,
+ * and free the slot.
+ */
+static void
+finish(fetcher_t* fetcher, conn_t* conn, const bool ok)
+{
+  if (conn->fd >= 0) {
+    epoll_ctl(fetcher->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    if (ok && http_keepAlive(conn->resp)) {
+      connpool_give(fetcher->pool, conn->hostname, conn->port, conn->fd);
+    } else {
+      close(conn->fd);
+    }
+    conn->fd = -1;
+  }
+  webpage_setStatus(conn->page, ok ? http_code(conn->resp) : 0);
+  bool success = ok && http_code(conn->resp) == 200 && http_bodyLength(conn->resp) > 0;
+  if (success) {
+    char* html = http_takeBody(conn->resp);
+    success = webpage_setHTML(conn->page, html);
+    if (!success) {
+      free(html);
+    }
+  }
+  pushDone(fetcher, conn->page, success);
+  conn->page = NULL;
+  mem_free(conn->request);
+  conn->request = NULL;
+  free(conn->hostname);
+  conn->hostname = NULL;
+  fetcher->freeSlots[fetcher->numFree++] = conn - fetcher->conns;
+}
+
+/**************** pushDone ****************/
+static void
+pushDone(fetcher_t* fetcher, webpage_t* page, const bool ok)
+{
+  fetcher->donePages[fetcher->numDone] = page;
+  fetcher->doneOk[fetcher->numDone] = ok;
+  fetcher->numDone++;
+}
@@ -0,0 +1,77 @@
+/*
+ * fetcher.h - event-driven engine that fetches many web pages at once
+ *
+ * A *fetcher* keeps up to maxInFlight HTTP fetches in progress from a
+ * single thread.  Each fetch uses a non-blocking socket watched with
+ * epoll, and its response is parsed incrementally (see http.h) as bytes
+ * arrive, so no fetch ever waits on another's round trips.
+ *
+ * The caller submits pages (as from webpage_new, without html) and later
+ * collects them, one at a time, as their fetches finish - in whatever
+ * order the servers answer.
+ *
+ * Aniket Dey, 2025
+ */
+
+#ifndef __FETCHER_H
+#define __FETCHER_H
+
+#include <stdbool.h>
+#include "webpage.h"
+
+/**************** global types ****************/
+typedef struct fetcher fetcher_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** fetcher_new ****************/
+/* Create a fetch engine.
+ *
+ * Caller provides:
+ *   the most fetches to have in progress at once (must be > 0).
+ * We return:
+ *   pointer to new fetcher, or NULL on error.
+ * Caller is responsible for:
+ *   later calling fetcher_delete.
+ */
+fetcher_t* fetcher_new(const int maxInFlight);
+
+/**************** fetcher_submit ****************/
+/* Start fetching a page.
+ *
+ * Caller provides:
+ *   valid fetcher, and a page with a URL and no html.
+ * We return:
+ *   true if the fetcher took the page; it will come back from fetcher_next,
+ *   whether or not the fetch succeeds.
+ *   false if the fetcher already has maxInFlight pages, or on bad arguments;
+ *   the caller keeps the page.
+ */
+bool fetcher_submit(fetcher_t* fetcher, webpage_t* page);
+
+/**************** fetcher_next ****************/
+/* Wait for a fetch to finish, and return its page.
+ *
+ * Caller provides:
+ *   valid fetcher;
+ *   how long to wait, in milliseconds (-1 means until a fetch finishes);
+ *   pointer to a bool, set to whether the fetch succeeded.
+ * We return:
+ *   the page, now with html if the fetch succeeded, and with the status of
+ *   the server's answer, if any (see webpage_getStatus); the caller owns it again.
+ *   NULL if nothing finished before the timeout, or no fetch is in progress.
+ */
+webpage_t* fetcher_next(fetcher_t* fetcher, const int timeoutMs, bool* fetched);
+
+/**************** fetcher_inFlight ****************/
+/* Return the number of pages submitted and not yet returned by fetcher_next.
+ */
+int fetcher_inFlight(const fetcher_t* fetcher);
+
+/**************** fetcher_delete ****************/
+/* Abandon any fetches in progress, deleting their pages, and free the fetcher.
+ * Ignore NULL fetcher.
+ */
+void fetcher_delete(fetcher_t* fetcher);
+
+#endif // __FETCHER_H
@@ -6,11 +6,18 @@
  * David Kotz - 2016, 2017, 2019, 2021
  */
 
+#define _POSIX_C_SOURCE 200809L   // getc_unlocked, flockfile, fileno
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
+#include <sys/stat.h>
 #include "file.h"
 
+/**************** file-local constants ****************/
+#define CHUNK 65536                       // bytes per fread when reading in bulk
+static const size_t MIN_CAPACITY = 128;   // smallest buffer file_grow allocates
 
 /**************** file_numLines ****************/
 int
@@ -22,10 +29,12 @@ file_numLines(FILE* fp)
 
   rewind(fp);
 
+  // count newlines a chunk at a time, rather than a character at a time
   int nlines = 0;
-  char c = '\0';
-  while ( (c = fgetc(fp)) != EOF) {
-    if (c == '\n') {
+  char chunk[CHUNK];
+  size_t n;
+  while ( (n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    for (char* nl = chunk; (nl = memchr(nl, '\n', chunk + n - nl)) != NULL; nl++) {
       nlines++;
     }
   }
@@ -35,18 +44,128 @@ file_numLines(FILE* fp)
   return nlines;
 }
 
-/**************** utility stopfuncs ****************/
-// for use with readuntil()
-static int never(int c) { return (0); }
-static int isnewline(int c) { return (c == '\n'); }
+/**************** file_grow ****************/
+/* See file.h for documentation. */
+bool
+file_grow(char** buf, size_t* cap, const size_t need)
+{
+  if (buf == NULL || cap == NULL) {
+    return false;
+  }
+  if (need <= *cap && *buf != NULL) {
+    return true;
+  }
+  size_t newcap = (*cap >= MIN_CAPACITY) ? *cap : MIN_CAPACITY;
+  while (newcap < need) {
+    newcap *= 2;
+  }
+  char* newbuf = realloc(*buf, newcap);
+  if (newbuf == NULL) {
+    return false;
+  }
+  *buf = newbuf;
+  *cap = newcap;
+  return true;
+}
+
+/**************** file_getLine ****************/
+/* See file.h for documentation. */
+ssize_t
+file_getLine(FILE* fp, char** buf, size_t* cap)
+{
+  if (fp == NULL || buf == NULL || cap == NULL) {
+    return -1;
+  }
+
+  // fgets copies as much of the line as fits straight out of stdio's buffer;
+  // if the line is longer, grow the buffer and carry on where it stopped
+  size_t len = 0;
+  for (;;) {
+    if (!file_grow(buf, cap, len + MIN_CAPACITY)) {
+      return -1;
+    }
+    if (fgets(*buf + len, *cap - len, fp) == NULL) {
+      break;                         // EOF or error
+    }
+    len += strlen(*buf + len);
+    if (len > 0 && (*buf)[len - 1] == '\n') {
+      (*buf)[--len] = '\0';          // discard the newline
+      return len;
+    }
+  }
+
+  if (len == 0 || ferror(fp)) {
+    return -1;                       // error, or EOF before reading anything
+  }
+  (*buf)[len] = '\0';                // last line had no newline
+  return len;
+}
+
+/**************** file_getAll ****************/
+/* See file.h for documentation. */
+ssize_t
+file_getAll(FILE* fp, char** buf, size_t* cap)
+{
+  if (fp == NULL || buf == NULL || cap == NULL) {
+    return -1;
+  }
+
+  // if this is a regular file, size the buffer for the rest of it up front
+  size_t expect = CHUNK;
+  struct stat info;
+  long here = ftell(fp);
+  if (here >= 0 && fstat(fileno(fp), &info) == 0
+      && S_ISREG(info.st_mode) && info.st_size > here) {
+    expect = info.st_size - here;
+  }
+
+  // read in bulk; the extra byte leaves room for the terminating null,
+  // and lets us see end of file without growing the buffer again
+  size_t len = 0;
+  size_t n;
+  do {
+    if (!file_grow(buf, cap, len + expect + 1)) {
+      return -1;
+    }
+    n = fread(*buf + len, 1, *cap - len - 1, fp);
+    len += n;
+    expect = CHUNK;
+  } while (n > 0 && !feof(fp) && !ferror(fp));
+
+  if (len == 0 || ferror(fp)) {
+    return -1;                       // error, or EOF before reading anything
+  }
+  (*buf)[len] = '\0';
+  return len;
+}
 
 /**************** file_readFile ****************/
 /* See file.h for documentation. */
-char* file_readFile(FILE* fp) { return file_readUntil(fp, never); }
+char*
+file_readFile(FILE* fp)
+{
+  char* buf = NULL;
+  size_t cap = 0;
+  if (file_getAll(fp, &buf, &cap) < 0) {
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
 
 /**************** file_readLine ****************/
 /* See file.h for documentation. */
-char* file_readLine(FILE* fp) { return file_readUntil(fp, isnewline); }
+char*
+file_readLine(FILE* fp)
+{
+  char* buf = NULL;
+  size_t cap = 0;
+  if (file_getLine(fp, &buf, &cap) < 0) {
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
 
 /**************** readword ****************/
 /* See file.h for documentation. */
@@ -57,41 +176,36 @@ char* file_readWord(FILE* fp) { return file_readUntil(fp, isspace); }
 char* 
 file_readUntil(FILE* fp, int (*stopfunc)(int c))
 {
-  if (stopfunc == NULL) {
-    stopfunc = never;
-  }
-
-  // allocate buffer big enough for "typical" words/lines
-  int len = 81;
-  char* buf = malloc(len * sizeof(char));
-  if (buf == NULL) {
+  if (fp == NULL) {
     return NULL;
   }
 
   // Read characters from file until stop-character or EOF, 
-  // expanding the buffer when needed to hold more.
-  int pos;
-  char c;
-  for (pos = 0; (c = fgetc(fp)) != EOF && !(*stopfunc)(c); pos++) {
+  // doubling the buffer whenever it fills, so the copying is O(n) overall.
+  // We lock the file once, so each character is just a buffer access.
+  char* buf = NULL;
+  size_t cap = 0;
+  size_t pos = 0;
+  int c = EOF;
+  flockfile(fp);
+  while ( (c = getc_unlocked(fp)) != EOF && (stopfunc == NULL || !(*stopfunc)(c))) {
     // We need to save buf[pos+1] for the terminating null
-    // and buf[len-1] is the last usable slot, 
-    // so if pos+1 is past that slot, we need to grow the buffer.
-    if (pos+1 > len-1) {
-      char* newbuf = realloc(buf, ++len * sizeof(char));
-      if (newbuf == NULL) {
-        free(buf);
-        return NULL;
-      } else {
-        buf = newbuf;
-      }
+    if (!file_grow(&buf, &cap, pos + 2)) {
+      funlockfile(fp);
+      free(buf);
+      return NULL;
     }
-    buf[pos] = c;
+    buf[pos++] = c;
   }
+  funlockfile(fp);
 
   if (pos == 0 && c == EOF) {
     // no characters were read and we reached EOF
     free(buf);
     return NULL;
+  } else if (!file_grow(&buf, &cap, pos + 1)) {
+    free(buf);
+    return NULL;
   } else {
     // pos characters were read into buf[0]..buf[pos-1].
     buf[pos] = '\0'; // terminate string
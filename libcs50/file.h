@@ -1,5 +1,10 @@
 /* 
  * file utilities - reading a word, line, or entire file
+ *
+ * Buffers grow geometrically (file_grow), and lines and files are read
+ * in bulk rather than a character at a time, so reading n bytes costs O(n).
+ * file_getLine and file_getAll read into a caller's buffer, which may be
+ * reused from one call to the next to avoid allocating at all.
  * 
  * David Kotz, 2016, 2017, 2019, 2021
  */
@@ -8,6 +13,8 @@
 #define __FILE_H
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <sys/types.h>
 
 /**************** file_numLines ****************/
 /* Returns the number of lines in the given file,
@@ -18,6 +25,38 @@
  */
 int file_numLines(FILE* fp);
 
+/**************** file_grow ****************/
+/* 
+ * Make sure *buf, whose capacity is *cap bytes, has room for need bytes,
+ * at least doubling its capacity whenever it must grow, so that filling a
+ * buffer a piece at a time costs O(n) overall.  *buf may start NULL, with *cap 0.
+ * Returns false if out of memory, in which case *buf and *cap are unchanged.
+ */
+bool file_grow(char** buf, size_t* cap, const size_t need);
+
+/**************** file_getLine ****************/
+/* 
+ * Read a line from the file into *buf, a buffer of *cap bytes that is
+ * grown with file_grow as needed; *buf may start NULL, with *cap 0, and
+ * the caller must later free() it.  Passing the same buffer to later
+ * calls reuses it, so reading many lines allocates only for the longest.
+ * On success the buffer holds the line with NO newline, null-terminated,
+ * and we return its length; we return -1 if error, or EOF reached
+ * without reading a line.
+ */
+ssize_t file_getLine(FILE* fp, char** buf, size_t* cap);
+
+/**************** file_getAll ****************/
+/* 
+ * Read the remainder of the file into *buf, a buffer of *cap bytes that
+ * is grown with file_grow as needed, as for file_getLine.  A regular file
+ * is read with one fread of its remaining size.
+ * On success the buffer holds the text, null-terminated, and we return its
+ * length; we return -1 if error, or EOF reached without reading anything.
+ * After the call, file pointer is at EOF.
+ */
+ssize_t file_getAll(FILE* fp, char** buf, size_t* cap);
+
 /**************** readuntil ****************/
 /* 
  * Read characters from the file into a null-terminated string,
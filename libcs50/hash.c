@@ -1,5 +1,6 @@
 /* =========================================================================
- * hash.c - Jenkins' Hash, maps from string to integer
+ * hash.c - Jenkins' Hash, maps from string to integer, and a faster
+ *          word-at-a-time hash for hashtable, set and strtable
  *
  * Implementation details can be found at:
  *     http://www.burtleburtle.net/bob/hash/doobs.html
@@ -32,3 +33,65 @@ hash_jenkins(const char* str, const unsigned long mod)
 
   return (hash % mod);
 }
+
+/*
+ * hash_bytes mixes each 8-byte word in one multiply-rotate round, in the
+ * style of xxHash64, and the final partial word likewise (zero-padded);
+ * the length seeds the hash so that padding cannot cause collisions.  It
+ * finishes with MurmurHash3's 64-bit avalanche, so the low bits alone are
+ * as good as the whole.
+ */
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+
+static inline uint64_t
+rotl64(const uint64_t x, const int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+round64(uint64_t hash, const uint64_t word)
+{
+  hash ^= rotl64(word * PRIME2, 31) * PRIME1;
+  return rotl64(hash, 27) * PRIME1 + PRIME3;
+}
+
+// hash_bytes - see header file for usage
+uint64_t
+hash_bytes(const void* data, const size_t len)
+{
+  const unsigned char* p = data;
+  size_t left = len;
+  uint64_t hash = PRIME3 ^ (len * PRIME1);
+  uint64_t word;
+
+  for (; left >= 8; p += 8, left -= 8) {
+    memcpy(&word, p, 8);      // unaligned load; compiles to one instruction
+    hash = round64(hash, word);
+  }
+  if (left > 0) {
+    word = 0;
+    memcpy(&word, p, left);
+    hash = round64(hash, word);
+  }
+
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// hash_string - see header file for usage
+uint64_t
+hash_string(const char* str, size_t* len)
+{
+  size_t n = strlen(str);
+  if (len != NULL) {
+    *len = n;
+  }
+  return hash_bytes(str, n);
+}
@@ -1,5 +1,6 @@
 /* =========================================================================
- * hash.h - Jenkins' Hash, maps from string to integer
+ * hash.h - Jenkins' Hash, maps from string to integer, and a faster
+ *          word-at-a-time hash for hashtable, set and strtable
  *
  * Implementation details can be found at:
  *     http://www.burtleburtle.net/bob/hash/doobs.html
@@ -9,6 +10,9 @@
 #ifndef HASH_H
 #define HASH_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /*
  * hash_jenkins - Bob Jenkins' one_at_a_time hash function
  * str: char buffer to hash (non-NULL)
@@ -18,4 +22,23 @@
  */
 unsigned long hash_jenkins(const char* str, const unsigned long mod);
 
+/*
+ * hash_bytes - 64-bit hash of a buffer, read eight bytes at a time
+ * data: buffer to hash (non-NULL unless len is 0)
+ * len: its length in bytes
+ *
+ * Returns the full hash; every bit is well mixed, so a table of 2^k slots
+ * may take the low k bits (hash & (slots - 1)) instead of a modulus.
+ */
+uint64_t hash_bytes(const void* data, const size_t len);
+
+/*
+ * hash_string - hash_bytes of a string, without its terminating '\0'
+ * str: char buffer to hash (non-NULL)
+ * len: if non-NULL, where to store strlen(str), found along the way
+ *
+ * Returns hash_bytes(str, strlen(str)).
+ */
+uint64_t hash_string(const char* str, size_t* len);
+
 #endif // HASH_H
@@ -17,7 +17,7 @@
 
 // hashtable struct represents the entire hashtable.
 typedef struct hashtable {
-    int num_slots; // number of slots in the table
+    int num_slots; // number of slots in the table (a power of two)
     set_t** table; // array of pointers to sets
 } hashtable_t;
 
@@ -37,16 +37,20 @@ hashtable_t* hashtable_new(const int num_slots) {
     if (ht == NULL) {
         return NULL; // If malloc fails, return null
     }
-    ht->num_slots = num_slots;
+    // Round up to a power of two, so a slot is the low bits of the hash
+    ht->num_slots = 1;
+    while (ht->num_slots < num_slots && ht->num_slots < (1 << 30)) {
+        ht->num_slots *= 2;
+    }
 
     // Allocate memory for the array of set pointers
-    ht->table = calloc(num_slots, sizeof(set_t*));
+    ht->table = calloc(ht->num_slots, sizeof(set_t*));
     if (ht->table == NULL) {
         free(ht);
         return NULL; // If malloc fails, return null and free ht
     }
     // Initialize each slot with a new set
-    for (int i = 0; i < num_slots; i++) {
+    for (int i = 0; i < ht->num_slots; i++) {
         ht->table[i] = set_new();
         if (ht->table[i] == NULL) {
             for (int j = 0; j < i; j++) {
@@ -71,9 +75,9 @@ bool hashtable_insert(hashtable_t* ht, const char* key, void* item) {
     if (ht == NULL || key == NULL || item == NULL) {
         return false; // Handle invalid parameters (null ht, key, item)
     }
-    // Compute hash value for the given key and insert
-    int hash = hash_jenkins(key, ht->num_slots);
-    return set_insert(ht->table[hash], key, item);
+    // Hash the key once: its low bits pick the slot, and the set keeps all of it
+    uint64_t hash = hash_string(key, NULL);
+    return set_insertHashed(ht->table[hash & (ht->num_slots - 1)], key, hash, item);
 }
 
 /*
@@ -85,9 +89,9 @@ void* hashtable_find(hashtable_t* ht, const char* key) {
     if (ht == NULL || key == NULL) {
         return NULL; // Handle invalid parameters (null ht, key)
     }
-    // // Compute hash value for the given key and find in the set
-    int hash = hash_jenkins(key, ht->num_slots);
-    return set_find(ht->table[hash], key);
+    // Compute hash value for the given key and find in the set
+    uint64_t hash = hash_string(key, NULL);
+    return set_findHashed(ht->table[hash & (ht->num_slots - 1)], key, hash);
 }
 
 /*
@@ -23,7 +23,8 @@ typedef struct hashtable hashtable_t;  // opaque to users of the module
 /* Create a new (empty) hashtable.
  *
  * Caller provides:
- *   number of slots to be used for the hashtable (must be > 0).
+ *   number of slots to be used for the hashtable (must be > 0);
+ *   it is rounded up to a power of two.
  * We return:
  *   pointer to the new hashtable; return NULL if error.
  * We guarantee:
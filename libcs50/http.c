@@ -0,0 +1,340 @@
+/*
+ * http.c - incremental parser for HTTP/1.x responses
+ *
+ * See http.h for usage.
+ *
+ * Aniket Dey, 2025
+ */
+
+#define _GNU_SOURCE       // strncasecmp, strcasestr
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "http.h"
+#include "file.h"
+
+/**************** local types ****************/
+typedef enum {
+  S_HEAD,         // reading status line and headers, up to the blank line
+  S_BODY_LENGTH,  // reading a body of known length
+  S_BODY_CLOSE,   // reading a body that ends when the connection closes
+  S_CHUNK_SIZE,   // reading the hex size line of the next chunk
+  S_CHUNK_DATA,   // reading the data of a chunk
+  S_CHUNK_END,    // reading the CRLF after a chunk's data
+  S_TRAILER,      // reading trailer lines after the last chunk
+  S_DONE,
+  S_ERROR
+} state_t;
+
+typedef struct httpresponse {
+  state_t state;
+  char* head;               // status line and headers, as received
+  size_t headLen, headCap;
+  char* body;               // body received so far; not null-terminated
+  size_t bodyLen, bodyCap;
+  char line[128];           // current chunk-size or trailer line
+  size_t lineLen;
+  long long remaining;      // bytes left in the body or current chunk
+  int code;                 // status code
+  bool keepAlive;           // may the connection be reused?
+} httpresponse_t;
+
+/**************** file-local constants ****************/
+static const size_t MAX_HEAD = 64 * 1024;          // refuse larger headers
+static const size_t MAX_PRESIZE = 16 * 1024 * 1024; // trust Content-Length up to here
+
+/**************** local functions ****************/
+static bool appendBody(httpresponse_t* resp, const char* data, size_t len);
+static state_t parseHead(httpresponse_t* resp);
+static bool takeLine(httpresponse_t* resp, char c);
+
+/**************** http_new ****************/
+/* see http.h for description */
+httpresponse_t*
+http_new(void)
+{
+  httpresponse_t* resp = calloc(1, sizeof(httpresponse_t));
+  if (resp != NULL) {
+    http_reset(resp);
+  }
+  return resp;
+}
+
+/**************** http_parse ****************/
+/* see http.h for description */
+http_status_t
+http_parse(httpresponse_t* resp, const char* data, size_t len, size_t* used)
+{
+  size_t pos = 0;
+  if (resp == NULL || data == NULL) {
+    if (used != NULL) *used = 0;
+    return HTTP_ERROR;
+  }
+
+  while (pos < len && resp->state != S_DONE && resp->state != S_ERROR) {
+    switch (resp->state) {
+    case S_HEAD: {
+      // headers are short, so take them a byte at a time until the blank line
+      if (resp->headLen + 1 >= MAX_HEAD
+          || !file_grow(&resp->head, &resp->headCap, resp->headLen + 2)) {
+        resp->state = S_ERROR;
+        break;
+      }
+      resp->head[resp->headLen++] = data[pos++];
+      resp->head[resp->headLen] = '\0';
+      size_t hl = resp->headLen;
+      if (hl >= 2 && resp->head[hl - 1] == '\n'
+          && (resp->head[hl - 2] == '\n'
+              || (hl >= 3 && resp->head[hl - 2] == '\r' && resp->head[hl - 3] == '\n'))) {
+        resp->state = parseHead(resp);
+      }
+      break;
+    }
+
+    case S_BODY_LENGTH:
+    case S_CHUNK_DATA: {
+      size_t n = len - pos;
+      if ((long long)n > resp->remaining) {
+        n = resp->remaining;
+      }
+      if (!appendBody(resp, data + pos, n)) {
+        resp->state = S_ERROR;
+        break;
+      }
+      pos += n;
+      resp->remaining -= n;
+      if (resp->remaining == 0) {
+        resp->state = (resp->state == S_BODY_LENGTH) ? S_DONE : S_CHUNK_END;
+      }
+      break;
+    }
+
+    case S_BODY_CLOSE:
+      if (!appendBody(resp, data + pos, len - pos)) {
+        resp->state = S_ERROR;
+        break;
+      }
+      pos = len;
+      break;
+
+    case S_CHUNK_SIZE:
+      if (takeLine(resp, data[pos++])) {
+        char* end;
+        long long size = strtoll(resp->line, &end, 16);
+        if (end == resp->line || size < 0) {
+          resp->state = S_ERROR;         // not a hex number
+        } else if (size == 0) {
+          resp->state = S_TRAILER;       // last chunk
+        } else {
+          resp->remaining = size;
+          resp->state = S_CHUNK_DATA;
+        }
+        resp->lineLen = 0;
+      }
+      break;
+
+    case S_CHUNK_END:
+      if (takeLine(resp, data[pos++])) {
+        resp->state = (resp->lineLen == 0) ? S_CHUNK_SIZE : S_ERROR;
+        resp->lineLen = 0;
+      }
+      break;
+
+    case S_TRAILER:
+      if (takeLine(resp, data[pos++])) {
+        if (resp->lineLen == 0) {
+          resp->state = S_DONE;          // blank line ends the trailers
+        }
+        resp->lineLen = 0;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  if (used != NULL) {
+    *used = pos;
+  }
+  switch (resp->state) {
+  case S_DONE:  return HTTP_DONE;
+  case S_ERROR: return HTTP_ERROR;
+  default:      return HTTP_MORE;
+  }
+}
+
+/**************** http_finish ****************/
+/* see http.h for description */
+http_status_t
+http_finish(httpresponse_t* resp)
+{
+  if (resp == NULL) {
+    return HTTP_ERROR;
+  }
+  if (resp->state == S_BODY_CLOSE) {
+    resp->state = S_DONE;
+  } else if (resp->state != S_DONE) {
+    resp->state = S_ERROR;
+  }
+  return resp->state == S_DONE ? HTTP_DONE : HTTP_ERROR;
+}
+
+/**************** getters ****************/
+/* see http.h for description */
+int
+http_code(const httpresponse_t* resp)
+{
+  return resp ? resp->code : 0;
+}
+
+bool
+http_keepAlive(const httpresponse_t* resp)
+{
+  return resp ? (resp->state == S_DONE && resp->keepAlive) : false;
+}
+
+size_t
+http_bodyLength(const httpresponse_t* resp)
+{
+  return resp ? resp->bodyLen : 0;
+}
+
+/**************** http_takeBody ****************/
+/* see http.h for description */
+char*
+http_takeBody(httpresponse_t* resp)
+{
+  if (resp == NULL || !file_grow(&resp->body, &resp->bodyCap, resp->bodyLen + 1)) {
+    return NULL;
+  }
+  char* body = resp->body;
+  body[resp->bodyLen] = '\0';
+  resp->body = NULL;
+  resp->bodyLen = resp->bodyCap = 0;
+  return body;
+}
+
+/**************** http_reset ****************/
+/* see http.h for description */
+void
+http_reset(httpresponse_t* resp)
+{
+  if (resp != NULL) {
+    resp->state = S_HEAD;
+    resp->headLen = 0;
+    resp->bodyLen = 0;
+    resp->lineLen = 0;
+    resp->remaining = 0;
+    resp->code = 0;
+    resp->keepAlive = false;
+  }
+}
+
+/**************** http_delete ****************/
+/* see http.h for description */
+void
+http_delete(httpresponse_t* resp)
+{
+  if (resp != NULL) {
+    free(resp->head);
+    free(resp->body);
+    free(resp);
+  }
+}
+
+/**************** appendBody ****************/
+static bool
+appendBody(httpresponse_t* resp, const char* data, size_t len)
+{
+  // leave room for the null that http_takeBody adds
+  if (!file_grow(&resp->body, &resp->bodyCap, resp->bodyLen + len + 1)) {
+    return false;
+  }
+  memcpy(resp->body + resp->bodyLen, data, len);
+  resp->bodyLen += len;
+  return true;
+}
+
+/**************** takeLine ****************/
+/* Add c to the current line; return true once the line is complete,
+ * leaving it null-terminated in resp->line without its CRLF.
+ * Overlong lines are truncated; we only ever need their first few bytes.
+ */
+static bool
+takeLine(httpresponse_t* resp, char c)
+{
+  if (c == '\n') {
+    if (resp->lineLen > 0 && resp->line[resp->lineLen - 1] == '\r') {
+      resp->lineLen--;
+    }
+    resp->line[resp->lineLen] = '\0';
+    return true;
+  }
+  if (resp->lineLen < sizeof(resp->line) - 1) {
+    resp->line[resp->lineLen++] = c;
+  }
+  return false;
+}
+
+/**************** parseHead ****************/
+/* Parse the status line and headers in resp->head,
+ * and return the state in which to read the body.
+ */
+static state_t
+parseHead(httpresponse_t* resp)
+{
+  int minor;
+  if (sscanf(resp->head, "HTTP/1.%d %d", &minor, &resp->code) != 2) {
+    return S_ERROR;
+  }
+
+  // a 1xx response is followed by the real one; start over
+  if (resp->code >= 100 && resp->code < 200) {
+    resp->headLen = 0;
+    resp->code = 0;
+    return S_HEAD;
+  }
+
+  long long length = -1;
+  bool chunked = false;
+  bool close = (minor == 0);              // HTTP/1.0 closes unless told otherwise
+
+  // walk the header lines, after the status line
+  for (char* line = strchr(resp->head, '\n'); line != NULL; line = strchr(line, '\n')) {
+    line++;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      length = strtoll(line + 15, NULL, 10);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+      char* eol = strchr(line, '\n');
+      char* value = strcasestr(line + 18, "chunked");
+      chunked = (value != NULL && (eol == NULL || value < eol));
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+      char* value = line + 11;
+      while (*value == ' ' || *value == '\t') value++;
+      if (strncasecmp(value, "close", 5) == 0) {
+        close = true;
+      } else if (strncasecmp(value, "keep-alive", 10) == 0) {
+        close = false;
+      }
+    }
+  }
+
+  resp->keepAlive = !close;
+  if (resp->code == 204 || resp->code == 304) {
+    return S_DONE;                        // never has a body
+  } else if (chunked) {
+    return S_CHUNK_SIZE;
+  } else if (length >= 0) {
+    if (length > 0 && (size_t)length < MAX_PRESIZE
+        && !file_grow(&resp->body, &resp->bodyCap, length + 1)) {
+      return S_ERROR;
+    }
+    resp->remaining = length;
+    return length == 0 ? S_DONE : S_BODY_LENGTH;
+  } else {
+    resp->keepAlive = false;              // only the close tells us where it ends
+    return S_BODY_CLOSE;
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * http.h - incremental parser for HTTP/1.x responses
+ *
+ * An *httpresponse* consumes the bytes of one HTTP response in whatever
+ * pieces they arrive from the network, and tells the caller when the
+ * response is complete.  It understands the status line, the headers it
+ * needs (Content-Length, Transfer-Encoding: chunked, Connection), and the
+ * three ways a body may end: after Content-Length bytes, after the last
+ * chunk, or when the server closes the connection.
+ *
+ * The body accumulates in a buffer that grows geometrically, so a response
+ * of n bytes costs O(n) no matter how it is split up.
+ *
+ * Aniket Dey, 2025
+ */
+
+#ifndef __HTTP_H
+#define __HTTP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**************** global types ****************/
+typedef struct httpresponse httpresponse_t;  // opaque to users of the module
+
+// result of http_parse and http_finish
+typedef enum {
+  HTTP_MORE,    // response not yet complete; feed more bytes
+  HTTP_DONE,    // response complete; unused bytes were left alone
+  HTTP_ERROR    // malformed response; discard it and the connection
+} http_status_t;
+
+/**************** functions ****************/
+
+/**************** http_new ****************/
+/* Create a parser, ready for the first byte of a response.
+ *
+ * We return:
+ *   pointer to new parser, or NULL if out of memory.
+ * Caller is responsible for:
+ *   later calling http_delete.
+ */
+httpresponse_t* http_new(void);
+
+/**************** http_parse ****************/
+/* Feed the next len bytes of the response to the parser.
+ *
+ * Caller provides:
+ *   valid parser, and len bytes of data (need not be null-terminated).
+ * We return:
+ *   HTTP_MORE if every byte was consumed and more are needed;
+ *   HTTP_DONE once the response is complete;
+ *   HTTP_ERROR if the response is malformed or memory runs out.
+ *   If used is not NULL, *used is set to the number of bytes consumed;
+ *   on HTTP_DONE any bytes after *used belong to the next response.
+ */
+http_status_t http_parse(httpresponse_t* resp, const char* data, size_t len,
+                         size_t* used);
+
+/**************** http_finish ****************/
+/* Tell the parser the connection closed (EOF).
+ *
+ * We return:
+ *   HTTP_DONE if the response was delimited by the close and is now complete,
+ *   or was already complete; HTTP_ERROR if the response was cut short.
+ */
+http_status_t http_finish(httpresponse_t* resp);
+
+/**************** getters ****************/
+/* http_code:       status code from the status line, e.g. 200; 0 if not yet read.
+ * http_keepAlive:  true if the connection may carry another request after
+ *                  this response (HTTP/1.1 without "Connection: close",
+ *                  and a body that was not delimited by close).
+ * http_bodyLength: number of body bytes received so far.
+ */
+int    http_code(const httpresponse_t* resp);
+bool   http_keepAlive(const httpresponse_t* resp);
+size_t http_bodyLength(const httpresponse_t* resp);
+
+/**************** http_takeBody ****************/
+/* Take ownership of the body received so far, as a null-terminated string.
+ *
+ * We return:
+ *   malloc'd string, which caller must later free; NULL if out of memory.
+ *   The parser's own body becomes empty.
+ */
+char* http_takeBody(httpresponse_t* resp);
+
+/**************** http_reset ****************/
+/* Make the parser ready for the next response on the same connection,
+ * discarding any body not taken.  The body buffer is kept for reuse.
+ */
+void http_reset(httpresponse_t* resp);
+
+/**************** http_delete ****************/
+/* Free the parser and any body not taken; ignore NULL.
+ */
+void http_delete(httpresponse_t* resp);
+
+#endif // __HTTP_H
@@ -17,9 +17,10 @@
 
 /**************** file-local global variables ****************/
 // track malloc and free across *all* calls within this program.
-static int nmalloc = 0;         // number of successful malloc calls
-static int nfree = 0;           // number of free calls
-static int nfreenull = 0;       // number of free(NULL) calls
+// (atomic, so the counts stay right when several threads allocate)
+static _Atomic int nmalloc = 0;         // number of successful malloc calls
+static _Atomic int nfree = 0;           // number of free calls
+static _Atomic int nfreenull = 0;       // number of free(NULL) calls
 
 
 /**************** mem_assert ****************/
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "set.h"
+#include "hash.h"
 #include "mem.h"
 
 // Local Types
@@ -17,6 +18,7 @@
 typedef struct setnode {
     char* key; // key for this item (string)
     void* item;              
+    uint64_t hash; // hash_string(key), compared before the key
     struct setnode* next; // pointer to the next node
 } setnode_t;
 
@@ -31,7 +33,8 @@ typedef struct set {
 
 // Prototypes
 
-static setnode_t* setnode_new(void* item, const char* key);
+static setnode_t* setnode_new(void* item, const char* key, const uint64_t hash);
+static setnode_t* setnode_find(set_t* set, const char* key, const uint64_t hash);
 
 // Functions
 
@@ -56,17 +59,39 @@ set_t* set_new(void) {
  * Also returns false on null parameters and errors.
  */
 bool set_insert(set_t* set, const char* key, void* item) {
+    if (key == NULL) {
+        return false;
+    }
+    return set_insertHashed(set, key, hash_string(key, NULL), item);
+}
+
+/*
+ * set_find: Given a key, return the item associated.
+ * Params: Constant key value and pointer to set to look at
+ * Returns a pointer to the item corresponding to the given key, or null if key not found/set is null.
+ */
+void* set_find(set_t* set, const char* key) {
+    if (key == NULL) {
+        return NULL;
+    }
+    return set_findHashed(set, key, hash_string(key, NULL));
+}
+
+/*
+ * set_insertHashed - set_insert, given the key's hash_string
+ * Params: pointer to set, key, hash of key, item to be inserted
+ * Returns true if new item was inserted, false if key already exists, on null parameters, or on errors.
+ */
+bool set_insertHashed(set_t* set, const char* key, const uint64_t hash, void* item) {
     if (set == NULL || key == NULL || item == NULL) {
         return false; // Handles all invalid parameters (null key, set, item)
     }
-    // Loop through the set and check if the key already exists.
-    for (setnode_t* node = set->head; node != NULL; node = node->next) { 
-        if (strcmp(node->key, key) == 0) {
-            return false; // Key already exists, insertion fails and return false
-        }
+    // Check if the key already exists
+    if (setnode_find(set, key, hash) != NULL) {
+        return false; // Key already exists, insertion fails and return false
     }
     // Create a new node if the key is new
-    setnode_t* new_node = setnode_new(item, key);
+    setnode_t* new_node = setnode_new(item, key, hash);
     if (new_node == NULL) {
         return false; //If malloc fails, return false
     }
@@ -77,21 +102,16 @@ bool set_insert(set_t* set, const char* key, void* item) {
 }
 
 /*
- * set_find: Given a key, return the item associated.
- * Params: Constant key value and pointer to set to look at
+ * set_findHashed: set_find, given the key's hash_string
+ * Params: pointer to set, key, hash of key
  * Returns a pointer to the item corresponding to the given key, or null if key not found/set is null.
  */
-void* set_find(set_t* set, const char* key) {
+void* set_findHashed(set_t* set, const char* key, const uint64_t hash) {
     if (set == NULL || key == NULL) {
         return NULL; // // Handles all invalid parameters (null key, set)
     }
-    // Now, search for the key in the set
-    for (setnode_t* node = set->head; node != NULL; node = node->next) {
-        if (strcmp(node->key, key) == 0) {
-            return node->item; // If the key is found, return the corresponding item
-        }
-    }
-    return NULL;
+    setnode_t* node = setnode_find(set, key, hash);
+    return node != NULL ? node->item : NULL;
 }
 
 /*
@@ -165,7 +185,7 @@ void set_delete(set_t* set, void (*itemdelete)(void* item)) {
  * setnode_new: Given a key and item, creates a new node.
  * Returns pointer to new node, or null if malloc fails. 
  */
-static setnode_t* setnode_new(void* item, const char* key) {
+static setnode_t* setnode_new(void* item, const char* key, const uint64_t hash) {
     // Allocate memory for the node
     setnode_t* node = malloc(sizeof(setnode_t));
     if (node == NULL) {
@@ -181,6 +201,20 @@ static setnode_t* setnode_new(void* item, const char* key) {
     // Initialize the node
     node->key = copy;
     node->item = item;
+    node->hash = hash;
     node->next = NULL;
     return node;
 }
+
+/*
+ * setnode_find: Finds the node for a key; most nodes are passed over on the hash alone.
+ * Returns pointer to the node, or null if key is not in the set.
+ */
+static setnode_t* setnode_find(set_t* set, const char* key, const uint64_t hash) {
+    for (setnode_t* node = set->head; node != NULL; node = node->next) {
+        if (node->hash == hash && strcmp(node->key, key) == 0) {
+            return node;
+        }
+    }
+    return NULL;
+}
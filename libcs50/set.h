@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /**************** global types ****************/
 typedef struct set set_t;  // opaque to users of the module
@@ -66,6 +67,27 @@ bool set_insert(set_t* set, const char* key, void* item);
  */
 void* set_find(set_t* set, const char* key);
 
+/**************** set_insertHashed ****************/
+/* Like set_insert, for a caller that has already hashed the key.
+ *
+ * Caller provides:
+ *   as for set_insert, plus hash_string(key) (see hash.h).
+ * Notes:
+ *   Each node keeps its key's hash, and lookups compare hashes before
+ *   comparing strings; a caller such as hashtable, which must hash the
+ *   key anyway to pick a set, saves hashing it again.  The hash must be
+ *   hash_string(key), so that set_insert and set_find agree with it.
+ */
+bool set_insertHashed(set_t* set, const char* key, const uint64_t hash, void* item);
+
+/**************** set_findHashed ****************/
+/* Like set_find, for a caller that has already hashed the key.
+ *
+ * Caller provides:
+ *   as for set_find, plus hash_string(key).
+ */
+void* set_findHashed(set_t* set, const char* key, const uint64_t hash);
+
 /**************** set_print ****************/
 /* Print the whole set; provide the output file and func to print each item.
  *
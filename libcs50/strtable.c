@@ -0,0 +1,294 @@
+/*
+ * strtable.c - string table module
+ *
+ * See strtable.h for usage.
+ *
+ * The table is a power-of-two array of slots, so a hash picks its home
+ * slot with a mask.  Each slot records how far its entry sits from home
+ * (0 for an empty slot); inserting walks forward from home and swaps the
+ * new entry with any that is nearer its own home ("takes from the rich"),
+ * then carries the displaced entry on.  A lookup can therefore stop as
+ * soon as it meets an entry nearer home than the key would be: the key
+ * would have displaced it.  The array doubles before it is 7/8 full.
+ *
+ * Keys are copied end to end into blocks of KEY_BLOCK bytes (a longer key
+ * gets a block of its own); blocks are freed only with the table.
+ *
+ * Aniket Dey, 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "strtable.h"
+#include "hash.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+static const size_t MIN_SLOTS = 16;       // smallest array of slots
+static const size_t KEY_BLOCK = 65536;    // bytes in a block of key storage
+
+/**************** local types ****************/
+typedef struct slot {
+  const char* key;    // interned copy of the key
+  void* item;
+  uint32_t hash;      // low bits of hash_string(key)
+  uint32_t dist;      // 1 + distance from the key's home slot; 0 if empty
+} slot_t;
+
+typedef struct keyblock {
+  struct keyblock* next;    // the block filled before this one
+  size_t used;              // bytes of data in use
+  size_t size;              // bytes of data allocated
+  char data[];
+} keyblock_t;
+
+/**************** global types ****************/
+typedef struct strtable {
+  slot_t* slots;
+  size_t capacity;          // slots in the array (a power of two)
+  int size;                 // slots in use
+  keyblock_t* keys;         // block now being filled, or NULL
+  size_t keyBytes;          // bytes allocated for key blocks
+} strtable_t;
+
+/**************** local functions ****************/
+static slot_t* findSlot(strtable_t* table, const char* key, const uint32_t hash);
+static void place(slot_t* slots, const size_t mask, slot_t entry);
+static bool grow(strtable_t* table);
+static const char* intern(strtable_t* table, const char* key, const size_t len);
+
+/**************** strtable_new ****************/
+/* see strtable.h for description */
+strtable_t*
+strtable_new(const int expected)
+{
+  // room for the expected keys without passing 7/8 full
+  size_t capacity = MIN_SLOTS;
+  while (expected > 0 && capacity / 8 * 7 < (size_t)expected) {
+    capacity *= 2;
+  }
+
+  strtable_t* table = mem_malloc(sizeof(strtable_t));
+  if (table == NULL) {
+    return NULL;
+  }
+  table->slots = mem_calloc(capacity, sizeof(slot_t));
+  if (table->slots == NULL) {
+    mem_free(table);
+    return NULL;
+  }
+  table->capacity = capacity;
+  table->size = 0;
+  table->keys = NULL;
+  table->keyBytes = 0;
+  return table;
+}
+
+/**************** strtable_insert ****************/
+/* see strtable.h for description */
+bool
+strtable_insert(strtable_t* table, const char* key, void* item)
+{
+  if (table == NULL || key == NULL || item == NULL) {
+    return false;
+  }
+
+  size_t len;
+  uint32_t hash = (uint32_t)hash_string(key, &len);
+  if (findSlot(table, key, hash) != NULL) {
+    return false;
+  }
+  if ((size_t)(table->size + 1) > table->capacity / 8 * 7 && !grow(table)) {
+    return false;
+  }
+  const char* copy = intern(table, key, len);
+  if (copy == NULL) {
+    return false;
+  }
+
+  slot_t entry = { copy, item, hash, 1 };
+  place(table->slots, table->capacity - 1, entry);
+  table->size++;
+  return true;
+}
+
+/**************** strtable_find ****************/
+/* see strtable.h for description */
+void*
+strtable_find(strtable_t* table, const char* key)
+{
+  if (table == NULL || key == NULL) {
+    return NULL;
+  }
+  slot_t* slot = findSlot(table, key, (uint32_t)hash_string(key, NULL));
+  return slot != NULL ? slot->item : NULL;
+}
+
+/**************** strtable_key ****************/
+/* see strtable.h for description */
+const char*
+strtable_key(strtable_t* table, const char* key)
+{
+  if (table == NULL || key == NULL) {
+    return NULL;
+  }
+  slot_t* slot = findSlot(table, key, (uint32_t)hash_string(key, NULL));
+  return slot != NULL ? slot->key : NULL;
+}
+
+/**************** strtable_size ****************/
+/* see strtable.h for description */
+int
+strtable_size(strtable_t* table)
+{
+  return table != NULL ? table->size : 0;
+}
+
+/**************** strtable_bytes ****************/
+/* see strtable.h for description */
+size_t
+strtable_bytes(strtable_t* table)
+{
+  if (table == NULL) {
+    return 0;
+  }
+  return sizeof(strtable_t) + table->capacity * sizeof(slot_t) + table->keyBytes;
+}
+
+/**************** strtable_iterate ****************/
+/* see strtable.h for description */
+void
+strtable_iterate(strtable_t* table, void* arg,
+                 void (*itemfunc)(void* arg, const char* key, void* item))
+{
+  if (table != NULL && itemfunc != NULL) {
+    for (size_t i = 0; i < table->capacity; i++) {
+      if (table->slots[i].dist != 0) {
+        (*itemfunc)(arg, table->slots[i].key, table->slots[i].item);
+      }
+    }
+  }
+}
+
+/**************** strtable_delete ****************/
+/* see strtable.h for description */
+void
+strtable_delete(strtable_t* table, void (*itemdelete)(void* item))
+{
+  if (table != NULL) {
+    if (itemdelete != NULL) {
+      for (size_t i = 0; i < table->capacity; i++) {
+        if (table->slots[i].dist != 0) {
+          (*itemdelete)(table->slots[i].item);
+        }
+      }
+    }
+    while (table->keys != NULL) {
+      keyblock_t* next = table->keys->next;
+      mem_free(table->keys);
+      table->keys = next;
+    }
+    mem_free(table->slots);
+    mem_free(table);
+  }
+}
+
+/**************** findSlot ****************/
+/* Find the slot holding key, whose hash is given; NULL if there is none.
+ * The array always has an empty slot, whose dist of 0 ends the search.
+ */
+static slot_t*
+findSlot(strtable_t* table, const char* key, const uint32_t hash)
+{
+  size_t mask = table->capacity - 1;
+  size_t i = hash & mask;
+  for (uint32_t dist = 1; ; dist++, i = (i + 1) & mask) {
+    slot_t* slot = &table->slots[i];
+    if (slot->dist < dist) {
+      return NULL;      // key would have displaced this entry
+    }
+    if (slot->hash == hash && strcmp(slot->key, key) == 0) {
+      return slot;
+    }
+  }
+}
+
+/**************** place ****************/
+/* Put entry (dist 1, i.e. at home) into an array that has a free slot,
+ * displacing entries nearer their home than it is.
+ */
+static void
+place(slot_t* slots, const size_t mask, slot_t entry)
+{
+  for (size_t i = entry.hash & mask; ; i = (i + 1) & mask, entry.dist++) {
+    if (slots[i].dist == 0) {
+      slots[i] = entry;
+      return;
+    }
+    if (slots[i].dist < entry.dist) {
+      slot_t richer = slots[i];
+      slots[i] = entry;
+      entry = richer;
+    }
+  }
+}
+
+/**************** grow ****************/
+/* Double the array, placing every entry anew by its cached hash.
+ * Returns false, leaving the table unchanged, if out of memory.
+ */
+static bool
+grow(strtable_t* table)
+{
+  size_t capacity = table->capacity * 2;
+  slot_t* slots = mem_calloc(capacity, sizeof(slot_t));
+  if (slots == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < table->capacity; i++) {
+    if (table->slots[i].dist != 0) {
+      slot_t entry = table->slots[i];
+      entry.dist = 1;
+      place(slots, capacity - 1, entry);
+    }
+  }
+  mem_free(table->slots);
+  table->slots = slots;
+  table->capacity = capacity;
+  return true;
+}
+
+/**************** intern ****************/
+/* Copy key, of length len, into the key storage; NULL if out of memory.
+ */
+static const char*
+intern(strtable_t* table, const char* key, const size_t len)
+{
+  keyblock_t* block = table->keys;
+  if (block == NULL || block->size - block->used < len + 1) {
+    size_t size = len + 1 > KEY_BLOCK ? len + 1 : KEY_BLOCK;
+    block = mem_malloc(sizeof(keyblock_t) + size);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->used = 0;
+    block->size = size;
+    table->keyBytes += sizeof(keyblock_t) + size;
+    // a key too long to share a block goes behind the current one, so
+    // the current one's free space is not wasted
+    if (size > KEY_BLOCK && table->keys != NULL) {
+      block->next = table->keys->next;
+      table->keys->next = block;
+    } else {
+      block->next = table->keys;
+      table->keys = block;
+    }
+  }
+
+  char* copy = block->data + block->used;
+  memcpy(copy, key, len + 1);
+  block->used += len + 1;
+  return copy;
+}
@@ -0,0 +1,120 @@
+/*
+ * strtable.h - header file for the string table module
+ *
+ * A *strtable* maps string keys to items, like a hashtable, but grows as
+ * keys are added, so lookups stay fast however many keys there are.
+ *
+ * All entries live in one array, found by open addressing with Robin Hood
+ * probing: an entry may displace one that is nearer its home slot, which
+ * keeps every probe sequence short even when the array is mostly full.
+ * Each entry caches its key's hash, so probing rarely needs to compare
+ * strings, and growing never rehashes a key.  The keys themselves are
+ * copied ("interned") into large blocks owned by the table, rather than
+ * one malloc'd string each; a key pointer handed out by the table stays
+ * valid, unchanged, until the table is deleted.
+ *
+ * Keys cannot be removed.
+ *
+ * Aniket Dey, 2025
+ */
+
+#ifndef __STRTABLE_H
+#define __STRTABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**************** global types ****************/
+typedef struct strtable strtable_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** strtable_new ****************/
+/* Create a new (empty) strtable.
+ *
+ * Caller provides:
+ *   the number of keys expected (may be 0); the table grows past it as
+ *   needed, but room for that many is made up front.
+ * We return:
+ *   pointer to the new strtable; return NULL if error.
+ * Caller is responsible for:
+ *   later calling strtable_delete.
+ */
+strtable_t* strtable_new(const int expected);
+
+/**************** strtable_insert ****************/
+/* Insert item, identified by key (string), into the given strtable.
+ *
+ * Caller provides:
+ *   valid pointer to strtable, valid string for key, valid pointer for item.
+ * We return:
+ *   false if key exists in the table, any parameter is NULL, or error;
+ *   true iff new item was inserted.
+ * Notes:
+ *   The key string is copied into the table's key storage; the caller is
+ *   free to re-use or deallocate its key string after this call.
+ */
+bool strtable_insert(strtable_t* table, const char* key, void* item);
+
+/**************** strtable_find ****************/
+/* Return the item associated with the given key.
+ *
+ * Caller provides:
+ *   valid pointer to strtable, valid string for key.
+ * We return:
+ *   pointer to the item corresponding to the given key, if found;
+ *   NULL if table is NULL, key is NULL, or key is not found.
+ */
+void* strtable_find(strtable_t* table, const char* key);
+
+/**************** strtable_key ****************/
+/* Return the table's own copy of the given key.
+ *
+ * We return:
+ *   the interned key, valid until the table is deleted, if key is in the
+ *   table; NULL otherwise.
+ */
+const char* strtable_key(strtable_t* table, const char* key);
+
+/**************** strtable_size ****************/
+/* Return the number of keys in the table; 0 if table is NULL.
+ */
+int strtable_size(strtable_t* table);
+
+/**************** strtable_bytes ****************/
+/* Return the number of bytes the table has allocated, for its slots and
+ * its key storage; 0 if table is NULL.
+ */
+size_t strtable_bytes(strtable_t* table);
+
+/**************** strtable_iterate ****************/
+/* Iterate over all items in the table; in undefined order.
+ *
+ * Caller provides:
+ *   valid pointer to strtable,
+ *   arbitrary void*arg pointer,
+ *   itemfunc that can handle a single (key, item) pair.
+ * We do:
+ *   nothing, if table==NULL or itemfunc==NULL.
+ *   otherwise, call the itemfunc once for each item, with (arg, key, item).
+ * Notes:
+ *   the itemfunc may change the contents of the item, but must not insert
+ *   into the table.
+ */
+void strtable_iterate(strtable_t* table, void* arg,
+                      void (*itemfunc)(void* arg, const char* key, void* item));
+
+/**************** strtable_delete ****************/
+/* Delete strtable, calling a delete function on each item.
+ *
+ * Caller provides:
+ *   valid strtable pointer,
+ *   valid pointer to function that handles one item (may be NULL).
+ * We do:
+ *   if table==NULL, do nothing.
+ *   otherwise, unless itemdelete==NULL, call the itemdelete on each item;
+ *   free the key storage, and the table itself.
+ */
+void strtable_delete(strtable_t* table, void (*itemdelete)(void* item));
+
+#endif // __STRTABLE_H
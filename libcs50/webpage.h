@@ -15,6 +15,10 @@
  * Othertimes, you have fetched the HTML and want to work with it;
  * then, the webpage object has a non-null HTML pointer.
  *
+ * A page made with webpage_newView only borrows its HTML - typically
+ * from a file mapped into memory - and never copies or modifies it.
+ * Such HTML need not be null-terminated, so use webpage_getHTMLLength.
+ *
  * Original by Ira Ray Jenkins - April 2014
  * 
  * Updated by David Kotz - April 2016, July 2017, April 2019, 2021
@@ -37,6 +41,16 @@ typedef struct webpage webpage_t;
 int   webpage_getDepth(const webpage_t* page);
 char* webpage_getURL(const webpage_t* page);
 char* webpage_getHTML(const webpage_t* page);
+size_t webpage_getHTMLLength(const webpage_t* page);
+
+/* webpage_getStatus returns the HTTP status code of the response to the
+ * page's last fetch, or 0 if no whole response arrived: the server could
+ * not be reached, or the connection failed, was closed or timed out before
+ * the response was complete, or the response was not valid HTTP.  So a
+ * failed fetch with status 0 failed in transport, and may well succeed if
+ * tried again, while one with a status (404, say) got the server's answer.
+ */
+int   webpage_getStatus(const webpage_t* page);
 
 /**************** webpage_new ****************/
 /* Allocate and initialize a new webpage_t structure.
@@ -62,6 +76,49 @@ char* webpage_getHTML(const webpage_t* page);
  */
 webpage_t* webpage_new(char* url, const int depth, char* html);
 
+/**************** webpage_newView ****************/
+/* Allocate a webpage_t whose html is a read-only view of memory it does not own.
+ *
+ * Caller provides:
+ *   url   must be a non-null pointer to malloc'd memory, as for webpage_new.
+ *   depth must be non-negative.
+ *   html, len: the page's html, len bytes, not necessarily null-terminated.
+ *   map, map_len: a region from mmap() that holds html, which the page
+ *     takes over and webpage_delete will munmap(); or NULL, in which case
+ *     the caller must keep html valid until the page is deleted.
+ *
+ * We return:
+ *   pointer to new webpage_t, or NULL on any error.
+ *
+ * Notes:
+ *   The html is never written through, nor free'd; webpage_getNextWord
+ *   and webpage_getNextURL read at most len bytes of it.
+ *   Callers of webpage_getHTML must mind webpage_getHTMLLength.
+ */
+webpage_t* webpage_newView(char* url, const int depth, const char* html, const size_t len,
+                           void* map, const size_t map_len);
+
+/**************** webpage_setHTML ****************/
+/* Give a page the HTML fetched for it by some means other than webpage_fetch.
+ *
+ * Caller provides:
+ *   page: a valid webpage_t* with no html yet;
+ *   html: null-terminated, malloc'd string; it will later be free'd
+ *         by webpage_delete.
+ *
+ * We return:
+ *   true on success; false if either is NULL or the page already has html
+ *   (in which case the caller still owns html).
+ */
+bool webpage_setHTML(webpage_t* page, char* html);
+
+/**************** webpage_setStatus ****************/
+/* Record the outcome of a fetch made by some means other than webpage_fetch:
+ * the HTTP status code of its response, or 0 if no whole response arrived
+ * (see webpage_getStatus).  A page does nothing else with it.
+ */
+void webpage_setStatus(webpage_t* page, const int status);
+
 /**************** webpage_delete ****************/
 /* Delete a webpage_t structure created by webpage_new().
  *
@@ -70,7 +127,8 @@ webpage_t* webpage_new(char* url, const int depth, char* html);
  *   (parameter is void* so this function can be used as an itemdelete()).
  *
  * IMPORTANT:
- *   we call free() on both the url and the html, if not NULL.
+ *   we call free() on both the url and the html, if not NULL;
+ *   for a page from webpage_newView, we munmap() its map instead of freeing the html.
  */
 void webpage_delete(void* data);
 
@@ -85,6 +143,7 @@ void webpage_delete(void* data);
  * We return:
  *   true if the fetch was successful; otherwise, false;
  *   if the fetch succeeded, page->html will contain the content retrieved.
+ *   Either way, webpage_getStatus tells what the server answered, if anything.
  *
  * Caller is responsible for:
  *   If this function is successful, a new, null-terminated character
@@ -103,9 +162,27 @@ void webpage_delete(void* data);
  *   * can only handle http (not https or other schemes)
  *   * can only handle URLs of form http://host[:port][/pathname]
  *   * cannot handle redirects (HTTP 301 or 302 response codes)
+ *
+ * Note:
+ *   safe to call from several threads at once, on different pages.
+ *   We do not pause between fetches; the caller must pace its requests
+ *   to any one server (the crawler's frontier does this per host).
+ *   Connections are kept open (HTTP/1.1 keep-alive) when the server allows,
+ *   and reused by later fetches from the same host:port, which saves a
+ *   host lookup and a TCP handshake per page.
  */
 bool webpage_fetch(webpage_t* page);
 
+/***************** webpage_closeConnections ***********************/
+/* Close the idle connections that webpage_fetch keeps open for reuse.
+ *
+ * Caller is responsible for:
+ *   calling this only when no webpage_fetch is in progress, typically once
+ *   all fetching is finished; later fetches still work, but no longer
+ *   keep connections open.
+ */
+void webpage_closeConnections(void);
+
 
 /**************** webpage_getNextWord ***********************************/
 /* return the next word from page->html[pos]
@@ -119,8 +196,9 @@ bool webpage_fetch(webpage_t* page);
  * We return:
  *   pointer to string containing the next word, if any; otherwise NULL.
  * 
- * Side effect:
- *   page->html will be compressed to remove white space.
+ * Notes:
+ *   page->html is not modified, and only its first webpage_getHTMLLength
+ *   bytes are read, so this works on views from webpage_newView.
  *
  * Caller is responsible for:
  *   later free()ing the string returned.
@@ -149,8 +227,10 @@ char* webpage_getNextWord(webpage_t* page, int* pos);
  * We return:
  *   pointer to string containing the next URL, if any; otherwise NULL.
  *
- * Side effect:
- *   page->html will be compressed to remove white space.
+ * Notes:
+ *   Whitespace in the html is ignored, as though squeezed out, but
+ *   page->html is not modified, and only its first webpage_getHTMLLength
+ *   bytes are read, so this works on views from webpage_newView.
  *
  * Caller is responsible for:
  *   later free()ing the string returned.
@@ -196,6 +276,20 @@ char* webpage_getNextURL(webpage_t* page, int* pos);
 char* normalizeURL(const char* url);
 
 
+/***********************************************************************
+ * burstURL - split a URL of form http://host[:port][/pathname] into parts
+ *
+ * Caller provides:
+ *    url: normalized http URL;
+ *    pointers to receive the hostname, port, and pathname.
+ *
+ * Returns:
+ *  true on success, in which case *hostname and *pathname are new strings
+ *  that the caller must later free(), and *port defaults to 80;
+ *  false if the URL is not of that form.
+ */
+bool burstURL(const char* url, char** hostname, int* port, char** pathname);
+
 /***********************************************************************
  * isInternalURL - verify whether the given url is 'internal' to CS50
  *
@@ -0,0 +1,170 @@
+/*
+* intersecttest.c - Checks every intersection kernel against a plain merge, over random posting arrays, and
+*                   with -t times each, and the choice intersect_postings makes itself ("auto"). Lists of like
+*                   sizes are merged by the kernel; lists of very different sizes are galloped whatever the
+*                   kernel, so those rows time the gallop. Only the check is printed without -t, as timings
+*                   differ from run to run and CPU to CPU.
+* @author: Aniket Dey
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "../common/postings.h"
+#include "../common/intersect.h"
+
+// Local types
+typedef struct trial {
+    int sizeA;      // entries in the shorter list
+    int sizeB;      // entries in the longer list
+    int range;      // docIDs are drawn from 1..range, so range/size sets how sparse a list is
+} trial_t;
+
+// Global Constants
+static const int DEFAULT_ROUNDS = 200; // intersections timed per kernel and trial
+static const char* KERNELS[] = { "scalar", "sse2", "avx2", "auto" };
+static const int NUM_KERNELS = 4;
+static const trial_t TRIALS[] = {
+    { 1000, 1000, 2000 },       // dense: half of all docIDs match
+    { 10000, 10000, 1000000 },  // sparse: few match
+    { 100000, 100000, 200000 },
+    { 5000, 40000, 80000 },     // uneven, but merged
+    { 100, 100000, 200000 },    // skewed: galloped
+    { 3, 7, 16 },               // shorter than a block
+};
+static const int NUM_TRIALS = 6;
+
+// Function Prototypes
+static posting_t* randomList(const int size, const int range);
+static int reference(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out);
+static double nowNs(void);
+
+/*
+* main(): Runs each trial under each kernel the CPU supports
+* Params: number of command-line arguments (argc), array of command-line arguments (argv): -t rounds times each
+*         kernel over that many intersections, rounds defaulting to DEFAULT_ROUNDS if only -t is given
+* Returns: 0 if every kernel agrees with the plain merge, 1 otherwise
+*/
+int main(int argc, char* argv[]) {
+    if (argc > 3 || (argc > 1 && strcmp(argv[1], "-t") != 0)) {
+        fprintf(stderr, "Usage: %s [-t [rounds]]\n", argv[0]);
+        return 1;
+    }
+    bool timed = (argc > 1);
+    int rounds = (argc == 3) ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) {
+        fprintf(stderr, "Error: rounds must be a positive integer\n");
+        return 1;
+    }
+    srand(42);
+    if (timed) {
+        printf("kernel for sparse lists: %s\n", intersect_kernel());
+    }
+
+    bool ok = true;
+    for (int t = 0; t < NUM_TRIALS; t++) {
+        const trial_t* trial = &TRIALS[t];
+        posting_t* a = randomList(trial->sizeA, trial->range);
+        posting_t* b = randomList(trial->sizeB, trial->range);
+        posting_t* expected = malloc(trial->sizeA * sizeof(posting_t));
+        posting_t* got = malloc(trial->sizeA * sizeof(posting_t));
+        if (a == NULL || b == NULL || expected == NULL || got == NULL) {
+            fprintf(stderr, "Error: out of memory\n");
+            return 1;
+        }
+        int matches = reference(a, trial->sizeA, b, trial->sizeB, expected);
+        if (timed) {
+            printf("%6d x %-6d in 1..%-7d %6d matches:", trial->sizeA, trial->sizeB, trial->range, matches);
+        }
+
+        for (int k = 0; k < NUM_KERNELS; k++) {
+            if (!intersect_setKernel(KERNELS[k])) {
+                continue; // not on this CPU
+            }
+            // Either way round must give the same answer
+            int n = intersect_postings(a, trial->sizeA, b, trial->sizeB, got);
+            bool same = (n == matches && memcmp(got, expected, n * sizeof(posting_t)) == 0);
+            n = intersect_postings(b, trial->sizeB, a, trial->sizeA, got);
+            same = same && (n == matches && memcmp(got, expected, n * sizeof(posting_t)) == 0);
+            if (!same) {
+                printf("%6d x %-6d in 1..%-7d: %s WRONG\n", trial->sizeA, trial->sizeB, trial->range, KERNELS[k]);
+                ok = false;
+                continue;
+            }
+            if (!timed) {
+                continue;
+            }
+
+            double start = nowNs();
+            for (int r = 0; r < rounds; r++) {
+                intersect_postings(a, trial->sizeA, b, trial->sizeB, got);
+            }
+            printf("  %s %8.1f us", KERNELS[k], (nowNs() - start) / rounds / 1000);
+        }
+        if (timed) {
+            printf("\n");
+        }
+        free(a);
+        free(b);
+        free(expected);
+        free(got);
+    }
+    intersect_setKernel("auto");
+    printf("%s\n", ok ? "all kernels agree" : "KERNELS DISAGREE");
+    return ok ? 0 : 1;
+}
+
+/*
+* randomList(): Makes a posting array of distinct random docIDs, in order, with random counts
+* Params: number of entries (size), largest docID (range, at least size)
+* Returns: the array, which the caller frees; null if out of memory
+*/
+static posting_t* randomList(const int size, const int range) {
+    posting_t* list = malloc(size * sizeof(posting_t));
+    if (list == NULL) {
+        return NULL;
+    }
+    // Pick each docID in turn with the probability that leaves the right number still to pick
+    int n = 0;
+    for (int docID = 1; docID <= range && n < size; docID++) {
+        if (rand() % (range - docID + 1) < size - n) {
+            list[n].docID = docID;
+            list[n++].count = 1 + rand() % 9;
+        }
+    }
+    return list;
+}
+
+/*
+* reference(): Intersects two posting arrays with the plainest possible merge
+* Params: as for intersect_postings
+* Returns: the number of entries written to out
+*/
+static int reference(const posting_t* a, const int sizeA, const posting_t* b, const int sizeB, posting_t* out) {
+    int n = 0;
+    int j = 0;
+    for (int i = 0; i < sizeA; i++) {
+        while (j < sizeB && b[j].docID < a[i].docID) {
+            j++;
+        }
+        if (j < sizeB && b[j].docID == a[i].docID) {
+            out[n].docID = a[i].docID;
+            out[n++].count = (a[i].count < b[j].count) ? a[i].count : b[j].count;
+        }
+    }
+    return n;
+}
+
+/*
+* nowNs(): Reads the monotonic clock
+* Params: None
+* Returns: the time in nanoseconds
+*/
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
@@ -10,31 +10,26 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <limits.h>
 #include "webpage.h"
-#include "hashtable.h"
-#include "counters.h"
 #include "file.h"
+#include "index.h"
+#include "postings.h"
 #include "pagedir.h"
+#include "pagestore.h"
 #include "word.h"
+#include "topk.h"
 
 // Types
 
-// Struct to hold data for union operations
+// One 'AND' sequence of a query, as top-k evaluation reads it: a cursor over the documents matching it
 typedef struct {
-    counters_t* runningSum;
-} unionHelperData_t;
-
-// Struct to hold data for intersection operations
-typedef struct {
-    counters_t* tempProduct; 
-    counters_t* wordCounters; 
-} intersectHelperData_t;
-
-// Struct to hold data for ranking results
-typedef struct {
-    int maxDocID; 
-    int maxScore;
-} maxScoreData_t;
+    postings_cursor_t cursor; // over the word's postings or, for a sequence of several words, over matches
+    postings_t* matches; // the documents matching a sequence of several words; null for a single word
+    posting_t at; // the entry the cursor is on
+    bool done; // true once the cursor has no entries left
+    int bound; // no document scores more than this for the sequence
+} clause_t;
 
 // Function Prototypes
 char* takeQuery(void);
@@ -42,23 +37,23 @@ char** parseQuery(char* query);
 void printQuery(char** wordArray);
 int cleanQuery(char** wordArray);
 char*** grammarQuery(char** wordArray);
-hashtable_t* indexBuilder(char* indexFilename);
-counters_t* wordMatch(char* wordinRankArray, hashtable_t* index);
-counters_t* processAndSequence(char** andSequence, hashtable_t* index);
-counters_t* processQuery(char*** rankArray, hashtable_t* index);
-void rankResult(counters_t* runningSum, const char* pageDirectory);
-void mainLoop(const char* pageDirectory, const char* indexFilename);
-void parseArgs(const int args, char* argv[], char** pageDirectory, char** indexFilename);
+bool wordMatch(char* wordinRankArray, index_t* index, postings_cursor_t* cursor);
+postings_t* processAndSequence(char** andSequence, index_t* index);
+postings_t* processQuery(char*** rankArray, index_t* index);
+topk_t* processTopK(char*** rankArray, index_t* index, const int maxResults);
+void rankResult(postings_t* runningSum, pagestore_t* store, const int maxResults);
+void printResults(topk_t* top, pagestore_t* store);
+void mainLoop(const char* pageDirectory, const char* indexFilename, const int maxResults);
+void parseArgs(const int args, char* argv[], char** pageDirectory, char** indexFilename, int* maxResults);
 
 // Helper functions
-void unionHelper(void* arg, const int docID, int count);
-void intersectHelper(void* arg, const int docID, int count);
-void rankHelper(void* arg, const int docID, int count);
-void delete_word_counter_pairs(void* arg, const char* key, void* item);
-void copy_counter_item(void* arg, const int key, const int count);
+void offerHelper(void* arg, const int docID, const int count);
+int compareCursors(const void* a, const void* b);
+int compareBounds(const void* a, const void* b);
+void freeClauses(clause_t* clauses, const int numClauses);
 void freeWordArray(char** wordArray);
 void freeRankArray(char*** rankArray);
-void cleanup(hashtable_t* index, char* query, char** wordArray, char*** rankArray);
+void cleanup(index_t* index, char* query, char** wordArray, char*** rankArray);
 
 // Helper Functions
 
@@ -82,15 +77,12 @@ void freeRankArray(char*** rankArray) {
 
 /*
  * cleanup(): Frees allocated memory and cleans up resources.
- * Params: index hashtable (index), query string (query), word array (wordArray), rank array (rankArray)
+ * Params: index (index), query string (query), word array (wordArray), rank array (rankArray)
  * Returns: none
  */
-void cleanup(hashtable_t* index, char* query, char** wordArray, char*** rankArray) {
+void cleanup(index_t* index, char* query, char** wordArray, char*** rankArray) {
     if (index != NULL) {
-        // Iterate through the hashtable and delete word-counter pairs
-        hashtable_iterate(index, NULL, delete_word_counter_pairs);
-        // Delete the hashtable itself
-        hashtable_delete(index, NULL);
+        index_delete(index); // Delete the index and its posting lists
     }
     if (query != NULL) {
         free(query); 
@@ -103,43 +95,6 @@ void cleanup(hashtable_t* index, char* query, char** wordArray, char*** rankArra
     }
 }
 
-/*
- * copy_counter_item(): Copies a counter item.
- * Params: argument (arg), document ID (key), count (count)
- * Returns: none
- */
-void copy_counter_item(void* arg, const int key, const int count) {
-    counters_t* dest = arg; 
-    if (dest != NULL) {
-        counters_set(dest, key, count); 
-    }
-}
-
-/*
- * delete_word_counter_pairs(): Deletes word-counter pairs in hashtable.
- * Params: argument (arg), word key (key), counters item (item)
- * Returns: none
- */
-void delete_word_counter_pairs(void* arg, const char* key, void* item) {
-    if (key != NULL) {
-        free((char*)key); 
-    }
-    if (item != NULL) {
-        counters_delete(item);
-    }
-}
-
-/*
- * delete_item(): Deletes a counters item.
- * Params: item to delete (item)
- * Returns: none
- */
-void delete_item(void* item) {
-    if (item != NULL) {
-        counters_delete((counters_t*)item);
-    }
-}
-
 /*
  * freeWordArray(): Frees the word array memory.
  * Params: array of words (wordArray)
@@ -406,259 +361,293 @@ char*** grammarQuery(char** wordArray) {
     return rankArray; 
 }
 
-/**************** indexBuilder ****************/
+/**************** offerHelper ****************/
 /*
- * indexBuilder(): Builds index from index file.
- * Params: index filename (indexFilename)
- * Returns: pointer to the index hashtable
+ * offerHelper(): Helper function for ranking documents; offers each scored document to the top-k list.
+ * Params: top-k list (arg), document ID (docID), score (count)
+ * Returns: none
  */
-hashtable_t* indexBuilder(char* indexFilename) {
-    if (indexFilename == NULL) return NULL;
-
-    // Create a new hashtable with an initial size
-    hashtable_t* index = hashtable_new(200);  
-    if (index == NULL) return NULL;
-
-    // Open the index file for reading
-    FILE* indexFile = fopen(indexFilename, "r");
-    if (indexFile == NULL) {
-        hashtable_delete(index, NULL);
-        return NULL;
-    }
-
-    char* line = NULL;
-    size_t len = 0;     
-    bool error_occurred = false; 
-
-    // Read each line from the index file
-    while (getline(&line, &len, indexFile) != -1 && !error_occurred) {
-        char word[200]; 
-        int docID, count; 
-        
-        counters_t* counter = counters_new(); 
-        if (counter == NULL) {
-            error_occurred = true;
-            break;
-        }
-
-        char* remaining = line; 
-        int charsRead = 0;      
-        
-        if (sscanf(remaining, "%199s%n", word, &charsRead) != 1) {
-            counters_delete(counter); 
-            continue; 
-        }
-        remaining += charsRead; // Move the pointer past the word
-
-        // Parse docIDs and counts from the remaining part of the line
-        while (sscanf(remaining, "%d %d%n", &docID, &count, &charsRead) == 2) {
-            counters_set(counter, docID, count); 
-            remaining += charsRead; 
-        }
-
-        char* wordCopy = strdup(word); // Duplicate the word string
-        if (wordCopy == NULL) {
-            counters_delete(counter); // Delete counters on failure
-            error_occurred = true; 
-            break;
-        }
-
-        // Insert the word and its counters into the hashtable
-        if (!hashtable_insert(index, wordCopy, counter)) {
-            free(wordCopy); // 
-            counters_delete(counter); 
-            error_occurred = true; 
-            break;
-        }
+void offerHelper(void* arg, const int docID, const int count) {
+    topk_t* top = arg;
+    if (top != NULL && count > 0) {
+        topk_offer(top, docID, count);
     }
-
-    free(line); 
-    fclose(indexFile); 
-
-    if (error_occurred) { 
-        hashtable_iterate(index, NULL, delete_word_counter_pairs);
-        hashtable_delete(index, delete_item); 
-        return NULL; 
-    }
-
-    return index; 
 }
 
-/**************** unionHelper ****************/
 /*
- * unionHelper(): Helper function for union of counters.
- * Params: argument (arg), document ID (docID), count (count)
- * Returns: none
+ * compareCursors(): Orders posting cursors by how many entries they have left, fewest first; for qsort.
+ * Params: pointers to two cursors (a, b)
+ * Returns: negative, zero or positive as a has fewer, as many or more entries left than b
  */
-void unionHelper(void* arg, const int docID, int count) {
-    unionHelperData_t* data = arg; // Cast the argument to unionHelperData_t
-    if (data != NULL && data->runningSum != NULL) {
-        int existingCount = counters_get(data->runningSum, docID); 
-        counters_set(data->runningSum, docID, existingCount + count); // Update the count
-    }
+int compareCursors(const void* a, const void* b) {
+    const postings_cursor_t* x = a;
+    const postings_cursor_t* y = b;
+    int left = postings_remaining(x);
+    int right = postings_remaining(y);
+    return (left > right) - (left < right);
 }
 
-/**************** intersectHelper ****************/
 /*
- * intersectHelper(): Helper function for intersection of counters.
- * Params: argument (arg), document ID (docID), count (count)
- * Returns: none
+ * compareBounds(): Orders clauses by their score bounds, smallest first; for qsort.
+ * Params: pointers to two clauses (a, b)
+ * Returns: negative, zero or positive as a's bound is less than, equal to or more than b's
  */
-void intersectHelper(void* arg, const int docID, int count) {
-    intersectHelperData_t* data = arg; // Cast the argument to intersectHelperData_t
-    if (data != NULL && data->tempProduct != NULL && data->wordCounters != NULL) {
-        int wordCount = counters_get(data->wordCounters, docID); 
-        if (wordCount > 0) { 
-            int minCount = (count < wordCount) ? count : wordCount; 
-            counters_set(data->tempProduct, docID, minCount); 
-        }
-    }
+int compareBounds(const void* a, const void* b) {
+    const clause_t* x = a;
+    const clause_t* y = b;
+    return (x->bound > y->bound) - (x->bound < y->bound);
 }
 
-/**************** rankHelper ****************/
 /*
- * rankHelper(): Helper function for ranking documents.
- * Params: argument (arg), document ID (docID), count (count)
+ * freeClauses(): Frees the clause array and the match lists of its multi-word sequences.
+ * Params: array of clauses (clauses), number of clauses (numClauses)
  * Returns: none
  */
-void rankHelper(void* arg, const int docID, int count) {
-    maxScoreData_t* data = arg; 
-    if (data != NULL && count > data->maxScore) {
-        data->maxScore = count;  
-        data->maxDocID = docID;  
+void freeClauses(clause_t* clauses, const int numClauses) {
+    if (clauses != NULL) {
+        for (int i = 0; i < numClauses; i++) {
+            postings_delete(clauses[i].matches);
+        }
+        free(clauses);
     }
 }
 
 /**************** wordMatch ****************/
 /*
  * wordMatch(): Finds matching documents for a word in the index.
- * Params: word to match (wordinRankArray), index hashtable (index)
- * Returns: pointer to counters of matching documents
+ * Params: word to match (wordinRankArray), index (index), cursor to start over the word's postings (cursor)
+ * Returns: true if the word is in the index; false, leaving the cursor on an empty list, if not
  */
-counters_t* wordMatch(char* wordinRankArray, hashtable_t* index) {
-    if (wordinRankArray == NULL || index == NULL) return NULL;
-
-    counters_t* findWord = hashtable_find(index, wordinRankArray); 
-    counters_t* wordCounts = counters_new(); 
-    if (wordCounts == NULL) return NULL;
-
-    if (findWord != NULL) { 
-        counters_iterate(findWord, wordCounts, copy_counter_item); 
+bool wordMatch(char* wordinRankArray, index_t* index, postings_cursor_t* cursor) {
+    if (wordinRankArray == NULL || index == NULL) {
+        postings_openCursor(cursor, NULL);
+        return false;
     }
 
-    return wordCounts; // Return the counters of matching documents
+    // A word in a mapped index is read straight from its compressed list in the file
+    return index_cursor(index, wordinRankArray, cursor);
 }
 
 /**************** processAndSequence ****************/
 /*
  * processAndSequence(): Processes 'AND' sequence of words against the index.
- * Params: array of words in 'AND' sequence (andSequence), index hashtable (index)
- * Returns: pointer to counters of matching documents
+ * Params: array of words in 'AND' sequence (andSequence), index (index)
+ * Returns: pointer to a new posting list of matching documents, each scored by its smallest count
  */
-counters_t* processAndSequence(char** andSequence, hashtable_t* index) {
+postings_t* processAndSequence(char** andSequence, index_t* index) {
     if (andSequence == NULL || index == NULL) return NULL;
 
-    counters_t* runningProduct = NULL; // Initialize running product of counters
-
-    // Iterate through each word in the 'AND' sequence
-    for (int i = 0; andSequence[i] != NULL; i++) {
-        counters_t* wordCounters = wordMatch(andSequence[i], index); // Get counters for the word
-        if (wordCounters == NULL) {
-            counters_delete(runningProduct);
-            return NULL;
-        }
-
-        if (runningProduct == NULL) { // If first word in the sequence
-            runningProduct = counters_new(); 
-            if (runningProduct == NULL) {
-                counters_delete(wordCounters); // Delete wordCounters on failure
-                return NULL;
-            }
-            counters_iterate(wordCounters, runningProduct, copy_counter_item); // Copy wordCounters to runningProduct
-        } else {
-            counters_t* tempProduct = counters_new(); // Create a temporary counters for intersection
-            if (tempProduct == NULL) {
-                counters_delete(wordCounters); 
-                counters_delete(runningProduct); 
-                return NULL;
-            }
+    int numWords = 0;
+    while (andSequence[numWords] != NULL) {
+        numWords++;
+    }
+    if (numWords == 0) return postings_new();
+    postings_cursor_t* wordPostings = malloc(numWords * sizeof(postings_cursor_t));
+    if (wordPostings == NULL) return NULL;
 
-            intersectHelperData_t data = {tempProduct, wordCounters}; 
-            counters_iterate(runningProduct, &data, intersectHelper); 
+    // Get postings for every word, then take them rarest first, so the running product starts,
+    // and stays, no longer than the rarest word's list (a word not in the index ends it at once)
+    for (int i = 0; i < numWords; i++) {
+        wordMatch(andSequence[i], index, &wordPostings[i]);
+    }
+    qsort(wordPostings, numWords, sizeof(postings_cursor_t), compareCursors);
 
-            counters_delete(runningProduct); 
-            runningProduct = tempProduct; // Update runningProduct to the intersection result
-        }
-        counters_delete(wordCounters); 
+    // The rarest word's list is read in whole; each later one is only sought through for the
+    // documents still in the running product
+    postings_t* runningProduct = postings_fromCursor(&wordPostings[0]);
+    for (int i = 1; runningProduct != NULL && postings_size(runningProduct) > 0 && i < numWords; i++) {
+        postings_t* next = postings_intersectCursor(runningProduct, &wordPostings[i]);
+        postings_delete(runningProduct);
+        runningProduct = next; // Update runningProduct to the intersection result
     }
 
+    free(wordPostings);
     return runningProduct; 
 }
 
 /**************** processQuery ****************/
 /*
  * processQuery(): Processes the query against the index.
- * Params: array of 'AND' sequences (rankArray), index hashtable (index)
- * Returns: pointer to counters of matching documents
+ * Params: array of 'AND' sequences (rankArray), index (index)
+ * Returns: pointer to a new posting list of matching documents, each scored by the sum over its sequences
  */
-counters_t* processQuery(char*** rankArray, hashtable_t* index) {
+postings_t* processQuery(char*** rankArray, index_t* index) {
     if (rankArray == NULL || index == NULL) return NULL;
 
-    counters_t* runningSum = counters_new(); // Initialize running sum of counters
+    postings_t* runningSum = postings_new(); // Initialize running sum of posting lists
     if (runningSum == NULL) return NULL;
 
-    unionHelperData_t data = {runningSum}; // Prepare data for union operations
-
     // Iterate through each 'AND' sequence in the rankArray
     for (int i = 0; rankArray[i] != NULL; i++) {
-        counters_t* andResult = processAndSequence(rankArray[i], index); // Process the 'AND' sequence
+        postings_t* andResult = processAndSequence(rankArray[i], index); // Process the 'AND' sequence
         if (andResult == NULL) {
-            counters_delete(runningSum); 
+            postings_delete(runningSum); 
             return NULL;
         }
 
-        counters_iterate(andResult, &data, unionHelper); // Union the 'AND' result into runningSum
-        counters_delete(andResult); // Delete the 'AND' result as it's no longer needed
+        postings_t* sum = postings_union(runningSum, andResult); // Union the 'AND' result into runningSum
+        postings_delete(andResult); // Delete the 'AND' result as it's no longer needed
+        postings_delete(runningSum);
+        if (sum == NULL) {
+            return NULL;
+        }
+        runningSum = sum;
     }
 
-    return runningSum; // Return the combined counters of all sequences
+    return runningSum; // Return the combined postings of all sequences
+}
+
+/**************** processTopK ****************/
+/*
+ * processTopK(): Finds the best-scoring documents for a query, by MaxScore: each 'AND' sequence has a bound on
+ * the score it can give a document, and sequences whose bounds together cannot lift a document above the worst
+ * score in the top maxResults are only sought through for documents the others match, never scanned.
+ * Params: array of 'AND' sequences (rankArray), index (index), how many documents to find (maxResults > 0)
+ * Returns: pointer to a new top-k list of the documents, scored as processQuery scores them; null if out of memory
+ */
+topk_t* processTopK(char*** rankArray, index_t* index, const int maxResults) {
+    if (rankArray == NULL || index == NULL) return NULL;
+
+    int numClauses = 0;
+    while (rankArray[numClauses] != NULL) {
+        numClauses++;
+    }
+    topk_t* top = topk_new(maxResults);
+    clause_t* clauses = calloc(numClauses > 0 ? numClauses : 1, sizeof(clause_t));
+    long* below = malloc((numClauses > 0 ? numClauses : 1) * sizeof(long)); // sums of bounds up to each clause
+    if (top == NULL || clauses == NULL || below == NULL) {
+        topk_delete(top);
+        free(clauses);
+        free(below);
+        return NULL;
+    }
+
+    // A single word is read from its own postings; a longer sequence is intersected up front
+    for (int i = 0; i < numClauses; i++) {
+        clause_t* clause = &clauses[i];
+        if (rankArray[i][0] != NULL && rankArray[i][1] == NULL) {
+            wordMatch(rankArray[i][0], index, &clause->cursor);
+        }
+        else {
+            clause->matches = processAndSequence(rankArray[i], index);
+            if (clause->matches == NULL) {
+                topk_delete(top);
+                freeClauses(clauses, numClauses);
+                free(below);
+                return NULL;
+            }
+            postings_openCursor(&clause->cursor, clause->matches);
+        }
+        clause->bound = postings_bound(&clause->cursor);
+        clause->done = !postings_next(&clause->cursor, &clause->at);
+    }
+    qsort(clauses, numClauses, sizeof(clause_t), compareBounds);
+    for (int i = 0; i < numClauses; i++) {
+        below[i] = clauses[i].bound + (i > 0 ? below[i - 1] : 0);
+    }
+
+    // Documents come in docID order, so one scoring no more than the threshold loses even a tie
+    int essential = 0; // clauses before this one cannot lift a document into the top maxResults on their own
+    while (1) {
+        long threshold = topk_threshold(top);
+        while (essential < numClauses && below[essential] <= threshold) {
+            essential++;
+        }
+
+        // The next candidate is the smallest docID in any essential clause
+        int docID = 0;
+        for (int i = essential; i < numClauses; i++) {
+            if (!clauses[i].done && (docID == 0 || clauses[i].at.docID < docID)) {
+                docID = clauses[i].at.docID;
+            }
+        }
+        if (docID == 0) break; // Every essential clause is used up
+
+        long score = 0;
+        for (int i = essential; i < numClauses; i++) {
+            clause_t* clause = &clauses[i];
+            if (!clause->done && clause->at.docID == docID) {
+                score += clause->at.count;
+                clause->done = !postings_next(&clause->cursor, &clause->at);
+            }
+        }
+        // Then the other clauses, largest bound first, for as long as the document could still make it
+        for (int i = essential - 1; i >= 0 && score + below[i] > threshold; i--) {
+            clause_t* clause = &clauses[i];
+            if (!clause->done && clause->at.docID < docID) {
+                clause->done = !postings_seek(&clause->cursor, docID, &clause->at);
+            }
+            if (!clause->done && clause->at.docID == docID) {
+                score += clause->at.count;
+            }
+        }
+        if (score > threshold) {
+            topk_offer(top, docID, (score > INT_MAX) ? INT_MAX : (int)score);
+        }
+    }
+
+    freeClauses(clauses, numClauses);
+    free(below);
+    return top;
 }
 
 /**************** rankResult ****************/
 /*
- * rankResult(): Ranks and displays search results.
- * Params: counters of matching documents (runningSum), page directory (pageDirectory)
+ * rankResult(): Ranks and displays search results, best score first, and lowest docID first among equal scores.
+ * Params: posting list of matching documents (runningSum), open page directory (store),
+ *         most results to display (maxResults; 0 for all)
  * Returns: none
  */
-void rankResult(counters_t* runningSum, const char* pageDirectory) {
-    if (runningSum == NULL || pageDirectory == NULL) return;
+void rankResult(postings_t* runningSum, pagestore_t* store, const int maxResults) {
+    if (runningSum == NULL || store == NULL) return;
 
-    maxScoreData_t data; 
-    int resultsFound = 0; 
+    int numResults = postings_size(runningSum);
+    if (maxResults > 0 && maxResults < numResults) {
+        numResults = maxResults;
+    }
+    if (numResults == 0) {
+        printf("No documents match.\n");
+        return;
+    }
 
-    while (1) {
-        data.maxDocID = -1; 
-        data.maxScore = 0; 
+    // A heap of the best numResults documents, sorted once at the end
+    topk_t* top = topk_new(numResults);
+    if (top == NULL) {
+        fprintf(stderr, "Error: out of memory ranking results\n");
+        return;
+    }
+    postings_iterate(runningSum, top, offerHelper);
+    printResults(top, store);
+    topk_delete(top);
+}
 
-        // Iterate to find the document with the highest score
-        counters_iterate(runningSum, &data, rankHelper);
+/**************** printResults ****************/
+/*
+ * printResults(): Displays ranked documents, best first.
+ * Params: top-k list of the documents to display (top), open page directory (store)
+ * Returns: none
+ */
+void printResults(topk_t* top, pagestore_t* store) {
+    if (top == NULL || store == NULL) return;
 
-        if (data.maxScore == 0) break; 
+    const posting_t* ranked = topk_sort(top);
 
-        resultsFound = 1; // At least one result found
-        webpage_t* page = pagedir_load((char*)pageDirectory, data.maxDocID); 
+    for (int i = 0; i < topk_size(top); i++) {
+        // The URL comes from the document table if the crawler wrote one, else from the page itself
+        pagestore_doc_t doc;
+        if (pagestore_describe(store, ranked[i].docID, &doc)) {
+            printf("score: %d doc: %d url: %s\n", ranked[i].count, ranked[i].docID, doc.url);
+            continue;
+        }
+        webpage_t* page = pagestore_load(store, ranked[i].docID); 
 
         if (page != NULL) { 
             char* url = webpage_getURL(page); 
-            printf("score: %d doc: %d url: %s\n", data.maxScore, data.maxDocID, url); 
+            printf("score: %d doc: %d url: %s\n", ranked[i].count, ranked[i].docID, url); 
             webpage_delete(page);
         }
-
-        // Reset the score for the ranked document to avoid re-ranking
-        counters_set(runningSum, data.maxDocID, 0);
     }
-
-    if (!resultsFound) { 
+    if (topk_size(top) == 0) { 
         printf("No documents match.\n");
     }
 }
@@ -732,14 +721,23 @@ int cleanQuery(char** wordArray) {
 /**************** mainLoop ****************/
 /*
  * mainLoop(): Runs the main query processing loop.
- * Params: page directory (pageDirectory), index filename (indexFilename)
+ * Params: page directory (pageDirectory), index filename (indexFilename), most results to display per query (maxResults; 0 for all)
  * Returns: none
  */
-void mainLoop(const char* pageDirectory, const char* indexFilename) {
+void mainLoop(const char* pageDirectory, const char* indexFilename, const int maxResults) {
     if (pageDirectory == NULL || indexFilename == NULL) return; // Validate inputs
 
-    hashtable_t* index = indexBuilder((char*)indexFilename); // Build the index from the index file
-    if (index == NULL) return; // Exit if index building failed
+    index_t* index = index_open(indexFilename); // Open the index; a binary one is mapped, and words load as queried
+    if (index == NULL) { // Exit if index loading failed
+        fprintf(stderr, "Error: cannot load index from %s\n", indexFilename);
+        return;
+    }
+
+    pagestore_t* store = pagestore_open(pageDirectory); // Open the page directory, in whichever format
+    if (store == NULL) { // Exit if the pages cannot be read
+        index_delete(index);
+        return;
+    }
 
     while (1) { // Infinite loop to process queries
         char* query = takeQuery(); 
@@ -768,10 +766,20 @@ void mainLoop(const char* pageDirectory, const char* indexFilename) {
             continue; // Continue to the next iteration
         }
 
-        counters_t* results = processQuery(rankArray, index); // Process the query against the index
-        if (results != NULL) {
-            rankResult(results, pageDirectory); 
-            counters_delete(results); // Delete the results counters
+        if (maxResults > 0) {
+            // With a limit, documents that cannot make the top maxResults are passed over, not scored
+            topk_t* top = processTopK(rankArray, index, maxResults);
+            if (top != NULL) {
+                printResults(top, store);
+                topk_delete(top);
+            }
+        }
+        else {
+            postings_t* results = processQuery(rankArray, index); // Process the query against the index
+            if (results != NULL) {
+                rankResult(results, store, maxResults); 
+                postings_delete(results); // Delete the results postings
+            }
         }
 
         // Cleanup allocated resources for this query
@@ -780,24 +788,40 @@ void mainLoop(const char* pageDirectory, const char* indexFilename) {
         free(query); 
     }
 
-    hashtable_delete(index, delete_item); // Delete the index hashtable
+    pagestore_close(store); // Close the page directory
+    index_delete(index); // Delete the index
 }
 
 /**************** parseArgs ****************/
 /*
  * parseArgs(): Parses command-line arguments.
- * Params: number of arguments (args), array of arguments (argv), page directory pointer (pageDirectory), index filename pointer (indexFilename)
+ * Params: number of arguments (args), array of arguments (argv), page directory pointer (pageDirectory), index filename pointer (indexFilename),
+ *         pointer to the most results to display per query (maxResults; set from -k N, else 0 for all)
  * Returns: none
  */
-void parseArgs(const int args, char* argv[], char** pageDirectory, char** indexFilename) {
+void parseArgs(const int args, char* argv[], char** pageDirectory, char** indexFilename, int* maxResults) {
+    // An optional '-k N' comes before the two required arguments
+    int first = (args == 5 && argv != NULL && strcmp(argv[1], "-k") == 0) ? 3 : 1;
+
     // Check for correct number of arguments and non-NULL pointers
-    if (args != 3 || argv == NULL || pageDirectory == NULL || indexFilename == NULL) {
-        fprintf(stderr, "Usage: ./querier pageDirectory indexFilename\n"); // Print usage message
+    if (args != first + 2 || argv == NULL || pageDirectory == NULL || indexFilename == NULL || maxResults == NULL) {
+        fprintf(stderr, "Usage: ./querier [-k N] pageDirectory indexFilename\n"); // Print usage message
         exit(1); 
     }
 
-    *pageDirectory = argv[1]; // Assign pageDirectory from arguments
-    *indexFilename = argv[2]; // Assign indexFilename from arguments
+    *maxResults = 0; // Display every match unless told otherwise
+    if (first == 3) {
+        char* end;
+        long k = strtol(argv[2], &end, 10);
+        if (*argv[2] == '\0' || *end != '\0' || k <= 0 || k > INT_MAX) {
+            fprintf(stderr, "Error: -k needs a positive integer, not '%s'\n", argv[2]); // Report bad result limit
+            exit(1);
+        }
+        *maxResults = (int)k;
+    }
+
+    *pageDirectory = argv[first]; // Assign pageDirectory from arguments
+    *indexFilename = argv[first + 1]; // Assign indexFilename from arguments
 
     // Validate the page directory
     if (!pagedir_validate(*pageDirectory)) {
@@ -823,9 +847,10 @@ void parseArgs(const int args, char* argv[], char** pageDirectory, char** indexF
 int main(const int argc, char* argv[]) {
     char* pageDirectory = NULL; 
     char* indexFilename = NULL; 
+    int maxResults = 0;
 
-    parseArgs(argc, argv, &pageDirectory, &indexFilename); // Parse and validate arguments
-    mainLoop(pageDirectory, indexFilename); 
+    parseArgs(argc, argv, &pageDirectory, &indexFilename, &maxResults); // Parse and validate arguments
+    mainLoop(pageDirectory, indexFilename, maxResults); 
 
     return 0; // Return success
 }
@@ -52,6 +52,79 @@ run_querier_test "Test 3: Query 'home and tse'" "home and tse"
 
 run_querier_test "Test 4: Query 'algorithm or tse'" "algorithm or tse"
 
+# The same query against the index in binary form, which the querier maps rather than loads
+echo "----- Test 4b: Query 'algorithm or tse' on a binary index -----"
+../indexer/indextest -b "$INDEX_FILE" "$INDEX_FILE.bin"
+echo "algorithm or tse" | ./querier "$PAGE_DIR" "$INDEX_FILE.bin"
+echo ""
+
+# Every intersection kernel the CPU supports must agree with a plain merge; ./intersecttest -t also times them
+echo "----- Test 4c: Intersection kernels -----"
+./intersecttest
+echo ""
+
+# An AND sequence is taken rarest word first, whatever order it is written in
+echo "----- Test 4d: Query 'page and tse and playground' on a binary index -----"
+echo "page and tse and playground" | ./querier "$PAGE_DIR" "$INDEX_FILE.bin"
+echo ""
+
+# Only the best two matches, in the same order as without -k
+echo "----- Test 4e: Query 'algorithm or tse' with -k 2 -----"
+echo "algorithm or tse" | ./querier -k 2 "$PAGE_DIR" "$INDEX_FILE"
+echo ""
+
+# The same limit with an 'and' sequence among the 'or's, which the top-k evaluation scores like the full one
+echo "----- Test 4f: Query 'home and tse or page or playground' with -k 3 -----"
+echo "home and tse or page or playground" | ./querier -k 3 "$PAGE_DIR" "$INDEX_FILE.bin"
+echo ""
+
+
+# An index kept up to date with -u: the first pages make the index, and the rest a segment of it, which the
+# querier searches with it; the results should be those of Test 4. The manifest is shown without the length
+# of the last page, which changes whenever the page does
+echo "----- Test 4g: Query 'algorithm or tse' on an index updated with -u -----"
+rm -rf "$PAGE_DIR.inc" "$INDEX_FILE.inc"*
+mkdir -p "$PAGE_DIR.inc"
+cp "$PAGE_DIR/.crawler" "$PAGE_DIR/1" "$PAGE_DIR/2" "$PAGE_DIR.inc"
+../indexer/indexer -u "$PAGE_DIR.inc" "$INDEX_FILE.inc"
+cp "$PAGE_DIR"/[0-9]* "$PAGE_DIR.inc"
+../indexer/indexer -u "$PAGE_DIR.inc" "$INDEX_FILE.inc"
+cut -d' ' -f1,2,4 "$INDEX_FILE.inc.segments"
+echo "algorithm or tse" | ./querier "$PAGE_DIR" "$INDEX_FILE.inc"
+echo ""
+
+# Seven updates of two pages each: the first makes the index, and the rest segments, which are folded in the
+# background whenever there are more than 4; each update waits for the fold before it, by its lock. The
+# querier should find the same pages in the index and its segments as in an index built all at once
+echo "----- Test 4h: Queries on an index whose segments have been folded -----"
+FOLD_DIR="../data/folded"
+rm -rf "$FOLD_DIR" "$FOLD_DIR.index"* "$FOLD_DIR.all"
+mkdir -p "$FOLD_DIR"
+touch "$FOLD_DIR/.crawler"
+for ((d = 1; d <= 14; d++)); do
+    words="page"
+    (( d % 2 == 0 )) && words="$words even" || words="$words odd"
+    (( d % 3 == 0 )) && words="$words third third"
+    (( d % 5 == 0 )) && words="$words fifth fifth fifth"
+    printf "http://folded/%d\n0\n<html>%s</html>\n" "$d" "$words" > "$FOLD_DIR/$d"
+    if (( d % 2 == 0 )); then
+        flock "$FOLD_DIR.index.fold" true
+        ../indexer/indexer -u "$FOLD_DIR" "$FOLD_DIR.index"
+    fi
+done
+flock "$FOLD_DIR.index.fold" true
+cat "$FOLD_DIR.index.segments"
+../indexer/indexer "$FOLD_DIR" "$FOLD_DIR.all"
+for query in "page" "even and third" "odd or fifth" "third fifth or even"; do
+    echo "$query" | ./querier "$FOLD_DIR" "$FOLD_DIR.index" > "$FOLD_DIR.out1"
+    echo "$query" | ./querier "$FOLD_DIR" "$FOLD_DIR.all" > "$FOLD_DIR.out2"
+    if cmp -s "$FOLD_DIR.out1" "$FOLD_DIR.out2"; then
+        echo "'$query': same results as the index built all at once"
+    else
+        echo "'$query': results differ!"
+    fi
+done
+echo ""
 
 # 4. Add Invalid Test Cases
 echo "===== Testing querier with invalid queries ====="
@@ -81,5 +154,7 @@ echo ""
 # 6. Clean Up
 echo "Cleaning up data directories"
 # rm -f ../data/letters-1.index
+rm -f ../data/letters-1.index.bin ../data/letters-1.index.inc*
+rm -rf ../data/letters-1.inc ../data/folded ../data/folded.*
 # rm -rf ../data/letters-1
 echo "All tests completed."